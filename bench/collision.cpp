@@ -0,0 +1,75 @@
+#include <stdexcept>
+
+#include "game.h"
+
+#include "fixtures.h"
+#include "harness.h"
+
+namespace Snake::Bench
+{
+	void s_AddCollisionBenchmarks(std::vector<Case>& cases)
+	{
+		for (BoardSize size : BOARD_SIZES)
+		{
+			for (unsigned int length : SNAKE_LENGTHS)
+			{
+				if (!s_Fits(size, length))
+					continue;
+
+				cases.push_back(Case{ "collision.pairs", size.width, size.height, "length", length, 1,
+					[size, length]() -> Body
+					{
+						auto board = std::make_shared<Board>(size, length);
+
+						return [board](State& state)
+						{
+							for (uint64_t i = 0; i < state.iterations(); ++i)
+							{
+								ObjectPairs pairs = Game::s_GenerateUniquePairs(board->buffer.getObjects());
+								s_Keep(pairs.data());
+							}
+						};
+					} });
+
+				// Nothing collides, so every pair is scanned in full: the worst case of a tick
+				cases.push_back(Case{ "collision.check", size.width, size.height, "length", length, 1,
+					[size, length]() -> Body
+					{
+						auto board = std::make_shared<Board>(size, length);
+						auto pairs = std::make_shared<ObjectPairs>(Game::s_GenerateUniquePairs(board->buffer.getObjects()));
+
+						if (Game::s_CheckCollisions(*pairs) != CollisionResult::NONE)
+							throw std::logic_error("collision.check: fixture collides");
+
+						return [board, pairs](State& state)
+						{
+							for (uint64_t i = 0; i < state.iterations(); ++i)
+							{
+								s_Keep(Game::s_CheckCollisions(*pairs));
+							}
+						};
+					} });
+
+				// Same scan in chunks on every core, see `--parallel-phases`
+				cases.push_back(Case{ "collision.parallel", size.width, size.height, "length", length, 1,
+					[size, length]() -> Body
+					{
+						auto board = std::make_shared<Board>(size, length);
+						auto pairs = std::make_shared<ObjectPairs>(Game::s_GenerateUniquePairs(board->buffer.getObjects()));
+						auto jobs = std::make_shared<FrameJobs>(0);
+
+						if (Game::s_CheckCollisions(*pairs, *jobs) != Game::s_CheckCollisions(*pairs))
+							throw std::logic_error("collision.parallel: result differs from the serial check");
+
+						return [board, pairs, jobs](State& state)
+						{
+							for (uint64_t i = 0; i < state.iterations(); ++i)
+							{
+								s_Keep(Game::s_CheckCollisions(*pairs, *jobs));
+							}
+						};
+					} });
+			}
+		}
+	}
+};
@@ -0,0 +1,56 @@
+#include "glyphs.h"
+
+#include "fixtures.h"
+
+namespace Snake::Bench
+{
+	PosVector s_SerpentinePositions(BoardSize size, unsigned int length)
+	{
+		const unsigned int inner = size.width - 2;
+		PosVector positions(length);
+
+		// Walk the path tail first, then flip it so the head leads
+		for (unsigned int i = 0; i < length; ++i)
+		{
+			const unsigned int row = i / inner;
+			const unsigned int column = i % inner;
+			const unsigned int x = row % 2 == 0 ? 1 + column : inner - column;
+
+			positions[length - 1 - i] = { x, 1 + row };
+		}
+
+		return positions;
+	}
+
+	Board::Board(BoardSize size, unsigned int length)
+		: buffer(size.width, size.height),
+		  border(size.width, size.height),
+		  snake(1, 1),
+		  food(size.width - 2, size.height - 2),
+		  positions(s_SerpentinePositions(size, length))
+	{
+		resetSnake();
+
+		buffer.addObject(&border);
+		buffer.addObject(&snake);
+		buffer.addObject(&food);
+	}
+
+	void Board::resetSnake()
+	{
+		// The head leads the way the path was going: along its row, or down at a row end
+		const auto [headX, headY] = positions[0];
+		const auto [nextX, nextY] = positions[1];
+
+		::Snake::Snake::Direction direction = ::Snake::Snake::Direction::Down;
+		uint32_t headGlyph = TGLYPHS::SNAKE_HEAD_DOWN;
+
+		if (headY == nextY)
+		{
+			direction = headX > nextX ? ::Snake::Snake::Direction::Right : ::Snake::Snake::Direction::Left;
+			headGlyph = headX > nextX ? TGLYPHS::SNAKE_HEAD_RIGHT : TGLYPHS::SNAKE_HEAD_LEFT;
+		}
+
+		snake.restore(positions, headGlyph, TGLYPHS::SNAKE_TAIL_LEFT, direction);
+	}
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "objects.h"
+#include "screen.h"
+
+namespace Snake::Bench
+{
+	struct BoardSize
+	{
+		unsigned int width;
+		unsigned int height;
+	};
+
+	/** @brief Board sizes every board dependent benchmark runs at, from the smallest supported terminal up */
+	constexpr BoardSize BOARD_SIZES[] = { { 60, 30 }, { 200, 60 }, { 400, 120 }, { 1000, 300 } };
+
+	/** @brief Snake lengths every snake dependent benchmark runs at */
+	constexpr unsigned int SNAKE_LENGTHS[] = { 5, 100, 1000, 10000, 100000 };
+
+	/**
+	 * @brief Whether a snake of `length` leaves at least half of the board's inner cells free
+	 */
+	constexpr bool s_Fits(BoardSize size, unsigned int length) noexcept
+	{
+		return length <= size_t(size.width - 2) * (size.height - 2) / 2;
+	}
+
+	/**
+	 * @brief Head first positions of a snake winding through the inner rows from the top, so it never touches itself or the border
+	 * @param size Board size
+	 * @param length Cells; must satisfy `s_Fits`
+	 */
+	PosVector s_SerpentinePositions(BoardSize size, unsigned int length);
+
+	/**
+	 * @struct Board
+	 * @brief A game board as Snake::Game sets it up: border, a snake of the given length and one food, all in the screen buffer.
+	 *
+	 * Nothing overlaps, so collision checks over it find nothing and scan every pair completely.
+	 */
+	struct Board
+	{
+		Board(BoardSize size, unsigned int length);
+
+		Board(Board const&) = delete;
+		Board& operator=(Board const&) = delete;
+
+		ScreenBuffer buffer;
+		Border border;
+		::Snake::Snake snake;
+		Food food;
+
+		/** @brief Shape the snake was built with, for resetting it */
+		PosVector positions;
+
+		/** @brief Puts the snake back into `positions` */
+		void resetSnake();
+	};
+};
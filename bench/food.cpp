@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <numeric>
+
+#include "game.h"
+#include "random.h"
+
+#include "fixtures.h"
+#include "harness.h"
+
+namespace Snake::Bench
+{
+	namespace
+	{
+		/** @brief Percentages of the inner cells taken before food is placed */
+		constexpr unsigned int FILL_PERCENTS[] = { 0, 25, 50, 75, 90, 99 };
+	}
+
+	void s_AddFoodBenchmarks(std::vector<Case>& cases)
+	{
+		for (BoardSize size : BOARD_SIZES)
+		{
+			for (unsigned int fill : FILL_PERCENTS)
+			{
+				// Placement as `Game::insertFood` does it; taken cells are scattered so every attempt is a fresh guess
+				cases.push_back(Case{ "food.insert", size.width, size.height, "fill", fill, 1,
+					[size, fill]() -> Body
+					{
+						auto buffer = std::make_shared<ScreenBuffer>(size.width, size.height);
+						const CellPtr taken = std::make_shared<Cell>(Cell{ .codepoint = TGLYPHS::SNAKE_BODY });
+
+						std::vector<Position> inner;
+
+						for (unsigned int y = 1; y + 1 < size.height; ++y)
+						{
+							for (unsigned int x = 1; x + 1 < size.width; ++x)
+							{
+								inner.emplace_back(x, y);
+							}
+						}
+
+						Rng rng(size.width * 31 + fill);
+
+						for (size_t i = inner.size() - 1; i > 0; --i)
+						{
+							std::swap(inner[i], inner[rng.below(static_cast<uint32_t>(i + 1))]);
+						}
+
+						for (size_t i = 0; i < inner.size() * fill / 100; ++i)
+						{
+							buffer->set(inner[i].first, inner[i].second, taken);
+						}
+
+						return [buffer, taken, rng](State& state) mutable
+						{
+							for (uint64_t i = 0; i < state.iterations(); ++i)
+							{
+								s_Keep(Game::s_RandomEmptyPosition(*buffer, rng));
+							}
+						};
+					} });
+			}
+		}
+	}
+};
@@ -0,0 +1,95 @@
+#include <algorithm>
+
+#include "harness.h"
+
+namespace Snake::Bench
+{
+	State::State(uint64_t iterations) noexcept
+		: m_iterations(iterations)
+	{}
+
+	uint64_t State::iterations() const noexcept
+	{
+		return m_iterations;
+	}
+
+	void State::pause() noexcept
+	{
+		m_pausedAt = std::chrono::steady_clock::now();
+	}
+
+	void State::resume() noexcept
+	{
+		m_paused += std::chrono::steady_clock::now() - m_pausedAt;
+	}
+
+	std::chrono::nanoseconds State::paused() const noexcept
+	{
+		return m_paused;
+	}
+
+	void State::setBytesPerOp(uint64_t bytes) noexcept
+	{
+		m_bytesPerOp = bytes;
+	}
+
+	uint64_t State::bytesPerOp() const noexcept
+	{
+		return m_bytesPerOp;
+	}
+
+	Result s_Run(Case const& benchmark, std::chrono::nanoseconds minTime)
+	{
+		Body body = benchmark.setup();
+		uint64_t iterations = 1;
+
+		for (;;)
+		{
+			State state(iterations);
+
+			const auto start = std::chrono::steady_clock::now();
+			body(state);
+			const auto elapsed = std::chrono::steady_clock::now() - start - state.paused();
+
+			if (elapsed >= minTime || iterations >= (uint64_t(1) << 40))
+			{
+				return Result{
+					&benchmark, iterations,
+					static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / static_cast<double>(iterations),
+					state.bytesPerOp()
+				};
+			}
+
+			// Aim a little past minTime, but never more than 100x the last run in case it was a fluke
+			const double ratio = elapsed.count() > 0 ? 1.4 * static_cast<double>(minTime.count()) / static_cast<double>(elapsed.count()) : 100.0;
+
+			iterations = static_cast<uint64_t>(static_cast<double>(iterations) * std::clamp(ratio, 2.0, 100.0));
+		}
+	}
+
+	void s_WriteCsvHeader(std::ostream& out)
+	{
+		out << "benchmark,width,height,param_name,param,iterations,ns_per_op,items_per_op,ns_per_item,bytes_per_op\n";
+	}
+
+	void s_WriteCsv(std::ostream& out, Result const& result)
+	{
+		Case const& c = *result.benchmark;
+
+		out << c.name << ',' << c.width << ',' << c.height << ',' << c.paramName << ',' << c.param << ','
+			<< result.iterations << ',' << result.nsPerOp << ',' << c.itemsPerOp << ','
+			<< result.nsPerOp / static_cast<double>(c.itemsPerOp) << ',' << result.bytesPerOp << '\n';
+	}
+
+	void s_WriteJson(std::ostream& out, Result const& result)
+	{
+		Case const& c = *result.benchmark;
+
+		// Names and parameter names are plain identifiers, so nothing needs escaping
+		out << "{\"benchmark\":\"" << c.name << "\",\"width\":" << c.width << ",\"height\":" << c.height
+			<< ",\"param_name\":\"" << c.paramName << "\",\"param\":" << c.param
+			<< ",\"iterations\":" << result.iterations << ",\"ns_per_op\":" << result.nsPerOp
+			<< ",\"items_per_op\":" << c.itemsPerOp << ",\"ns_per_item\":" << result.nsPerOp / static_cast<double>(c.itemsPerOp)
+			<< ",\"bytes_per_op\":" << result.bytesPerOp << "}\n";
+	}
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @namespace Snake::Bench
+ * @brief Microbenchmarks of the engine, built as `snake_bench`.
+ */
+namespace Snake::Bench
+{
+	/**
+	 * @brief Keeps the compiler from optimizing away a value computed only for the benchmark
+	 */
+	template <typename T>
+	inline void s_Keep(T const& value) noexcept
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static const void* volatile sink;
+		sink = &value;
+#endif
+	}
+
+	/**
+	 * @class State
+	 * @brief Handed to a benchmark body: how many operations to run, and a clock that can be paused around setup.
+	 */
+	class State
+	{
+		public:
+			explicit State(uint64_t iterations) noexcept;
+
+			/** @brief Operations the body must run */
+			uint64_t iterations() const noexcept;
+
+			/** @brief Stops the clock, e.g. while resetting the fixture */
+			void pause() noexcept;
+
+			/** @brief Restarts the clock after `State::pause` */
+			void resume() noexcept;
+
+			/** @brief Time spent paused */
+			std::chrono::nanoseconds paused() const noexcept;
+
+			/** @brief Reports the bytes one operation produces, e.g. encoded output */
+			void setBytesPerOp(uint64_t bytes) noexcept;
+
+			uint64_t bytesPerOp() const noexcept;
+
+		private:
+			uint64_t m_iterations;
+			uint64_t m_bytesPerOp = 0;
+			std::chrono::nanoseconds m_paused{ 0 };
+			std::chrono::steady_clock::time_point m_pausedAt;
+	};
+
+	/** @brief Runs `State::iterations` operations */
+	using Body = std::function<void(State&)>;
+
+	/**
+	 * @brief One benchmark at one set of parameters
+	 *
+	 * The fixture is only built, by `Case::setup`, once the case is selected, and released after it ran,
+	 * so large boards and long snakes never coexist in memory.
+	 */
+	struct Case
+	{
+		std::string name;
+		unsigned int width = 0;
+		unsigned int height = 0;
+
+		/** @brief What `param` is, e.g. `length`; empty if the benchmark has no parameter besides the board size */
+		std::string paramName;
+		uint64_t param = 0;
+
+		/** @brief Items one operation handles, e.g. cells of a full board pass */
+		uint64_t itemsPerOp = 1;
+
+		/** @brief Builds the fixture and returns the body that runs against it */
+		std::function<Body()> setup;
+	};
+
+	/**
+	 * @brief Measurement of one Snake::Bench::Case
+	 */
+	struct Result
+	{
+		Case const* benchmark;
+		uint64_t iterations;
+		double nsPerOp;
+		uint64_t bytesPerOp;
+	};
+
+	/**
+	 * @brief Runs a case, growing the iteration count until one run takes at least `minTime`
+	 * @param benchmark Case to run
+	 * @param minTime Shortest run that is reported
+	 */
+	Result s_Run(Case const& benchmark, std::chrono::nanoseconds minTime);
+
+	/**
+	 * @brief Writes the header line of the CSV output
+	 */
+	void s_WriteCsvHeader(std::ostream& out);
+
+	/**
+	 * @brief Writes a result as a CSV line
+	 */
+	void s_WriteCsv(std::ostream& out, Result const& result);
+
+	/**
+	 * @brief Writes a result as a single line JSON object
+	 */
+	void s_WriteJson(std::ostream& out, Result const& result);
+
+	void s_AddRenderBenchmarks(std::vector<Case>& cases);
+	void s_AddSnakeBenchmarks(std::vector<Case>& cases);
+	void s_AddCollisionBenchmarks(std::vector<Case>& cases);
+	void s_AddFoodBenchmarks(std::vector<Case>& cases);
+	void s_AddScreenBenchmarks(std::vector<Case>& cases);
+	void s_AddTimerBenchmarks(std::vector<Case>& cases);
+};
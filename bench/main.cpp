@@ -0,0 +1,146 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/log/core.hpp>
+
+#include "harness.h"
+
+namespace
+{
+	struct BenchOptions
+	{
+		std::string filter;
+		bool json = false;
+		bool list = false;
+		bool help = false;
+		std::chrono::milliseconds minTime{ 100 };
+	};
+
+	std::string usage()
+	{
+		return
+			"Usage: snake_bench [options]\n"
+			"  --filter=<text>     only run benchmarks whose name contains <text>, e.g. render or snake.move\n"
+			"  --min-time=<ms>     shortest measured run of each benchmark (default 100)\n"
+			"  --format=<csv|json> CSV with a header line, or one JSON object per line (default csv)\n"
+			"  --list              print the benchmarks and their parameters without running them\n"
+			"  --help              print this message\n";
+	}
+
+	BenchOptions parse(int argc, char* argv[])
+	{
+		BenchOptions options;
+
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			const size_t equals = arg.find('=');
+			const std::string name = arg.substr(0, equals);
+			const std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+
+			if (name == "--filter")
+			{
+				options.filter = value;
+			}
+			else if (name == "--min-time")
+			{
+				try
+				{
+					options.minTime = std::chrono::milliseconds(std::stoul(value));
+				}
+				catch (const std::exception&)
+				{
+					throw std::invalid_argument("Invalid value for --min-time: " + value);
+				}
+			}
+			else if (name == "--format" && (value == "csv" || value == "json"))
+			{
+				options.json = value == "json";
+			}
+			else if (arg == "--list")
+			{
+				options.list = true;
+			}
+			else if (arg == "--help")
+			{
+				options.help = true;
+			}
+			else
+			{
+				throw std::invalid_argument("Unknown option: " + arg);
+			}
+		}
+
+		return options;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	BenchOptions options;
+
+	try
+	{
+		options = parse(argc, argv);
+	}
+	catch (const std::invalid_argument& e)
+	{
+		std::cerr << e.what() << "\n" << usage();
+
+		return 2;
+	}
+
+	if (options.help)
+	{
+		std::cout << usage();
+
+		return 0;
+	}
+
+	// The engine logs through Boost.Log; without a configured sink records would go to the console
+	boost::log::core::get()->set_logging_enabled(false);
+
+	std::vector<Snake::Bench::Case> cases;
+
+	Snake::Bench::s_AddRenderBenchmarks(cases);
+	Snake::Bench::s_AddSnakeBenchmarks(cases);
+	Snake::Bench::s_AddCollisionBenchmarks(cases);
+	Snake::Bench::s_AddFoodBenchmarks(cases);
+	Snake::Bench::s_AddScreenBenchmarks(cases);
+	Snake::Bench::s_AddTimerBenchmarks(cases);
+
+	std::cout << std::fixed << std::setprecision(2);
+
+	if (!options.json && !options.list)
+	{
+		Snake::Bench::s_WriteCsvHeader(std::cout);
+	}
+
+	for (Snake::Bench::Case const& c : cases)
+	{
+		if (c.name.find(options.filter) == std::string::npos)
+			continue;
+
+		if (options.list)
+		{
+			std::cout << c.name << ',' << c.width << ',' << c.height << ',' << c.paramName << ',' << c.param << '\n';
+
+			continue;
+		}
+
+		const Snake::Bench::Result result = Snake::Bench::s_Run(c, options.minTime);
+
+		if (options.json)
+			Snake::Bench::s_WriteJson(std::cout, result);
+		else
+			Snake::Bench::s_WriteCsv(std::cout, result);
+
+		std::cout.flush(); // a long run reports as it goes
+	}
+
+	return 0;
+}
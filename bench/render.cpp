@@ -0,0 +1,108 @@
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "terminal.h"
+
+#include "fixtures.h"
+#include "harness.h"
+
+namespace Snake::Bench
+{
+	namespace
+	{
+		/** @brief Longest snake `render.vacated` runs at: the diff is quadratic in the length, and one pass at 100000 cells takes tens of seconds */
+		constexpr unsigned int MAX_VACATED_LENGTH = 10000;
+
+		/** @brief A board whose snake moved once, so its buffer and vacated cells are those of a frame in a running game */
+		std::shared_ptr<Board> s_MovedBoard(BoardSize size, unsigned int length)
+		{
+			auto board = std::make_shared<Board>(size, length);
+			board->snake.performMove();
+
+			return board;
+		}
+	}
+
+	void s_AddRenderBenchmarks(std::vector<Case>& cases)
+	{
+		for (BoardSize size : BOARD_SIZES)
+		{
+			for (unsigned int length : SNAKE_LENGTHS)
+			{
+				if (!s_Fits(size, length))
+					continue;
+
+				// Full repaint of the board, as `Terminal::render` encodes it every frame, into memory instead of the tty;
+				// the vacated cells are found once, `render.vacated` times finding them
+				cases.push_back(Case{ "render.encode", size.width, size.height, "length", length, uint64_t(size.width) * size.height,
+					[size, length]() -> Body
+					{
+						auto board = s_MovedBoard(size, length);
+						auto vacated = std::make_shared<PosVector>(board->buffer.getPositionsToClear());
+						auto out = std::make_shared<std::string>();
+
+						return [board, vacated, out](State& state)
+						{
+							for (uint64_t i = 0; i < state.iterations(); ++i)
+							{
+								out->clear();
+								Terminal::s_EncodeFrame(*out, board->buffer, *vacated, board->buffer.width(), board->buffer.height());
+								s_Keep(out->data());
+							}
+
+							state.setBytesPerOp(out->size());
+						};
+					} });
+
+				// Same inputs as `render.encode`, in bands of rows encoded on every core and joined, see `--parallel-phases`
+				cases.push_back(Case{ "render.parallel", size.width, size.height, "length", length, uint64_t(size.width) * size.height,
+					[size, length]() -> Body
+					{
+						auto board = s_MovedBoard(size, length);
+						auto vacated = std::make_shared<PosVector>(board->buffer.getPositionsToClear());
+						auto jobs = std::make_shared<FrameJobs>(0);
+						auto out = std::make_shared<std::string>();
+
+						std::string serial;
+						Terminal::s_EncodeFrame(serial, board->buffer, *vacated, board->buffer.width(), board->buffer.height());
+						Terminal::s_EncodeFrame(*out, board->buffer, *vacated, board->buffer.width(), board->buffer.height(), jobs.get());
+
+						if (*out != serial)
+							throw std::logic_error("render.parallel: output differs from the serial encoding");
+
+						return [board, vacated, jobs, out](State& state)
+						{
+							for (uint64_t i = 0; i < state.iterations(); ++i)
+							{
+								out->clear();
+								Terminal::s_EncodeFrame(*out, board->buffer, *vacated, board->buffer.width(), board->buffer.height(), jobs.get());
+								s_Keep(out->data());
+							}
+
+							state.setBytesPerOp(out->size());
+						};
+					} });
+
+				if (length > MAX_VACATED_LENGTH)
+					continue;
+
+				// Diff of the snake's previous and new cells that `Terminal::s_EncodeBuffer` runs before encoding each frame
+				cases.push_back(Case{ "render.vacated", size.width, size.height, "length", length, length,
+					[size, length]() -> Body
+					{
+						auto board = s_MovedBoard(size, length);
+
+						return [board](State& state)
+						{
+							for (uint64_t i = 0; i < state.iterations(); ++i)
+							{
+								PosVector vacated = board->buffer.getPositionsToClear();
+								s_Keep(vacated.data());
+							}
+						};
+					} });
+			}
+		}
+	}
+};
@@ -0,0 +1,75 @@
+#include "fixtures.h"
+#include "harness.h"
+
+namespace Snake::Bench
+{
+	void s_AddScreenBenchmarks(std::vector<Case>& cases)
+	{
+		for (BoardSize size : BOARD_SIZES)
+		{
+			const uint64_t cells = uint64_t(size.width) * size.height;
+
+			// One operation is a pass over the whole board; ns_per_item is the cost of one cell
+			cases.push_back(Case{ "screen.set", size.width, size.height, "", 0, cells,
+				[size]() -> Body
+				{
+					auto buffer = std::make_shared<ScreenBuffer>(size.width, size.height);
+					const CellPtr cell = std::make_shared<Cell>(Cell{ .codepoint = TGLYPHS::SNAKE_BODY });
+					const CellPtr empty = buffer->getEmptyCellPtr();
+
+					return [buffer, cell, empty](State& state)
+					{
+						for (uint64_t i = 0; i < state.iterations(); ++i)
+						{
+							const CellPtr& value = i % 2 == 0 ? cell : empty;
+
+							for (unsigned int y = 0; y < buffer->height(); ++y)
+							{
+								for (unsigned int x = 0; x < buffer->width(); ++x)
+								{
+									buffer->set(x, y, value);
+								}
+							}
+						}
+					};
+				} });
+
+			// Runs against constant dimensions on the sizes in Snake::FixedBoards
+			cases.push_back(Case{ "screen.snapshot", size.width, size.height, "", 0, cells,
+				[size]() -> Body
+				{
+					auto board = std::make_shared<Board>(size, SNAKE_LENGTHS[0]);
+					auto out = std::make_shared<std::vector<PackedCell>>();
+
+					return [board, out](State& state)
+					{
+						for (uint64_t i = 0; i < state.iterations(); ++i)
+						{
+							board->buffer.snapshot(*out);
+							s_Keep(out->data());
+						}
+					};
+				} });
+
+			cases.push_back(Case{ "screen.get", size.width, size.height, "", 0, cells,
+				[size]() -> Body
+				{
+					auto board = std::make_shared<Board>(size, SNAKE_LENGTHS[0]);
+
+					return [board](State& state)
+					{
+						for (uint64_t i = 0; i < state.iterations(); ++i)
+						{
+							for (unsigned int y = 0; y < board->buffer.height(); ++y)
+							{
+								for (unsigned int x = 0; x < board->buffer.width(); ++x)
+								{
+									s_Keep(board->buffer.get(x, y).get());
+								}
+							}
+						}
+					};
+				} });
+		}
+	}
+};
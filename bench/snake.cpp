@@ -0,0 +1,61 @@
+#include <algorithm>
+
+#include "fixtures.h"
+#include "harness.h"
+
+namespace Snake::Bench
+{
+	void s_AddSnakeBenchmarks(std::vector<Case>& cases)
+	{
+		for (BoardSize size : BOARD_SIZES)
+		{
+			for (unsigned int length : SNAKE_LENGTHS)
+			{
+				if (!s_Fits(size, length))
+					continue;
+
+				// Coordinates are unchecked, so the snake can keep moving past the border for as long as the run lasts
+				cases.push_back(Case{ "snake.move", size.width, size.height, "length", length, length,
+					[size, length]() -> Body
+					{
+						auto board = std::make_shared<Board>(size, length);
+
+						return [board](State& state)
+						{
+							for (uint64_t i = 0; i < state.iterations(); ++i)
+							{
+								board->snake.performMove();
+								s_Keep(board->snake.cells().front()->x);
+							}
+						};
+					} });
+
+				// Grows in batches from `length`, so the length being measured stays close to the parameter
+				cases.push_back(Case{ "snake.grow", size.width, size.height, "length", length, 1,
+					[size, length]() -> Body
+					{
+						auto board = std::make_shared<Board>(size, length);
+
+						return [board](State& state)
+						{
+							constexpr uint64_t batch = 256;
+
+							for (uint64_t done = 0; done < state.iterations(); done += batch)
+							{
+								state.pause();
+								board->resetSnake();
+								state.resume();
+
+								for (uint64_t i = 0, n = std::min(batch, state.iterations() - done); i < n; ++i)
+								{
+									board->snake.grow();
+								}
+
+								s_Keep(board->snake.cells().back()->x);
+							}
+						};
+					} });
+			}
+		}
+	}
+};
@@ -0,0 +1,81 @@
+#include <memory>
+#include <vector>
+
+#include "random.h"
+#include "timerwheel.h"
+
+#include "harness.h"
+
+namespace Snake::Bench
+{
+	namespace
+	{
+		/** @brief Timers pending while measuring */
+		constexpr uint64_t PENDING[] = { 0, 1000, 100000 };
+
+		/** @brief Longest delay of the pending timers, in ticks: a bit over a minute at 1000 Hz */
+		constexpr uint32_t MAX_DELAY = 100000;
+	}
+
+	void s_AddTimerBenchmarks(std::vector<Case>& cases)
+	{
+		for (uint64_t pending : PENDING)
+		{
+			// A timer scheduled and cancelled again, e.g. food expiry replaced before it is due
+			cases.push_back(Case{ "timers.schedule_cancel", 0, 0, "pending", pending, 1,
+				[pending]() -> Body
+				{
+					auto wheel = std::make_shared<TimerWheel>();
+					Rng rng(pending);
+
+					for (uint64_t i = 0; i < pending; ++i)
+					{
+						wheel->schedule(1 + rng.below(MAX_DELAY), []() {});
+					}
+
+					return [wheel, rng](State& state) mutable
+					{
+						for (uint64_t i = 0; i < state.iterations(); ++i)
+						{
+							s_Keep(wheel->cancel(wheel->schedule(1 + rng.below(MAX_DELAY), []() {})));
+						}
+					};
+				} });
+
+			// One tick of a game with `pending` timers that reschedule themselves when they fire
+			cases.push_back(Case{ "timers.advance", 0, 0, "pending", pending, 1,
+				[pending]() -> Body
+				{
+					struct Fixture
+					{
+						TimerWheel wheel;
+						Rng rng;
+						uint64_t fired = 0;
+
+						void arm()
+						{
+							wheel.schedule(1 + rng.below(MAX_DELAY), [this]() { ++fired; arm(); });
+						}
+					};
+
+					auto fixture = std::make_shared<Fixture>();
+					fixture->rng = Rng(pending);
+
+					for (uint64_t i = 0; i < pending; ++i)
+					{
+						fixture->arm();
+					}
+
+					return [fixture](State& state)
+					{
+						for (uint64_t i = 0; i < state.iterations(); ++i)
+						{
+							fixture->wheel.advance();
+						}
+
+						s_Keep(fixture->fired);
+					};
+				} });
+		}
+	}
+};
@@ -0,0 +1,82 @@
+// Example bot plugin: heads for the food along the free neighbour closest to it.
+// Build with the SNAKE_BUILD_BOTS option, then run `snake --bot=./libsnake_bot_greedy.so`.
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "snakebot.h"
+
+namespace
+{
+	// Opposite of each SnakeBotMove direction: the snake cannot turn back on itself
+	constexpr uint32_t s_Reverse[4] = { SNAKE_BOT_DOWN, SNAKE_BOT_UP, SNAKE_BOT_RIGHT, SNAKE_BOT_LEFT };
+
+	uint32_t s_Neighbour(SnakeBotView const* view, uint32_t cell, uint32_t direction)
+	{
+		switch (direction)
+		{
+			case SNAKE_BOT_UP:
+				return cell - view->width;
+			case SNAKE_BOT_DOWN:
+				return cell + view->width;
+			case SNAKE_BOT_LEFT:
+				return cell - 1;
+			default:
+				return cell + 1;
+		}
+	}
+
+	bool s_Free(SnakeBotView const* view, uint32_t cell)
+	{
+		return view->cells[cell] == SNAKE_BOT_FREE || view->cells[cell] == SNAKE_BOT_FOOD;
+	}
+
+	uint32_t s_Decide(void*, SnakeBotView const* view)
+	{
+		const uint32_t head = snake_bot_segment(view, 0);
+		uint32_t best = SNAKE_BOT_KEEP;
+		long bestScore = 0;
+
+		for (uint32_t direction = 0; direction < 4; ++direction)
+		{
+			if (view->length > 1 && direction == s_Reverse[view->direction])
+				continue;
+
+			const uint32_t next = s_Neighbour(view, head, direction);
+
+			if (next >= view->width * view->height || !s_Free(view, next))
+				continue;
+
+			// Closer to the food is better; room around the cell breaks ties
+			long score = 0;
+
+			if (view->food != SNAKE_BOT_NO_FOOD)
+			{
+				const long dx = static_cast<long>(next % view->width) - static_cast<long>(view->food % view->width);
+				const long dy = static_cast<long>(next / view->width) - static_cast<long>(view->food / view->width);
+
+				score -= 4 * (std::labs(dx) + std::labs(dy));
+			}
+
+			for (uint32_t around = 0; around < 4; ++around)
+			{
+				score += s_Free(view, s_Neighbour(view, next, around));
+			}
+
+			if (best == SNAKE_BOT_KEEP || score > bestScore)
+			{
+				best = direction;
+				bestScore = score;
+			}
+		}
+
+		return best;
+	}
+
+	const SnakeBotApi s_Api = { SNAKE_BOT_ABI_VERSION, "greedy", nullptr, s_Decide, nullptr };
+}
+
+extern "C" __attribute__((visibility("default"))) const SnakeBotApi* snake_bot_api(void)
+{
+	return &s_Api;
+}
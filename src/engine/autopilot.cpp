@@ -0,0 +1,461 @@
+#include <algorithm>
+#include <sstream>
+
+#include "include/autopilot.h"
+#include "include/game.h"
+
+namespace Snake
+{
+	Input::KeyKind AutopilotController::nextKey(Game const& game)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		if (game.width() != m_width || game.height() != m_height || game.obstacles() != m_obstacles)
+		{
+			reset(game.width(), game.height(), game.obstacles());
+		}
+
+		syncBody(game);
+
+		const Snake& snake = game.snake();
+		const auto& cells = snake.cells();
+		const Position headPos = snake.getHeadPosition();
+
+		if (headPos.first == 0 || headPos.second == 0 || headPos.first >= m_width - 1 || headPos.second >= m_height - 1 ||
+			(m_obstacles && m_obstacles->covers(headPos.first, headPos.second)))
+		{
+			return Input::KeyKind::None; // dead in the wall, the game is about to restart
+		}
+
+		const uint32_t head = headPos.second * m_width + headPos.first;
+		const uint32_t tail = m_body.back();
+
+		// A tail that shares its cell with the one before it (just grew) does not move away
+		const bool tailMoves = cells.size() > 1 && m_blocked[tail] == 1;
+
+		const auto current = static_cast<unsigned int>(snake.direction());
+		const uint32_t targets[] = { head - m_width, head + m_width, head - 1, head + 1 };
+
+		struct Candidate
+		{
+			unsigned int direction;
+			bool safe;
+			uint32_t distance;
+			size_t room;
+		};
+
+		// Safe moves first, then the shortest way to the food, then the most room, then going straight
+		auto better = [current](Candidate const& a, Candidate const& b)
+		{
+			if (a.safe != b.safe)
+				return a.safe;
+			if (a.safe && a.distance != b.distance)
+				return a.distance < b.distance;
+			if (a.room != b.room)
+				return a.room > b.room;
+
+			return a.direction == current && b.direction != current;
+		};
+
+		Candidate best{ current, false, s_Unreachable, 0 };
+		bool found = false;
+
+		for (unsigned int dir = 0; dir < 4; ++dir)
+		{
+			// The reverse of the current direction is ignored by the snake
+			if (cells.size() > 1 && dir == (current ^ 1u))
+			{
+				continue;
+			}
+
+			const uint32_t target = targets[dir];
+
+			if (m_blocked[target] != 0 && !(target == tail && tailMoves))
+			{
+				continue;
+			}
+
+			bool reachesTail = false;
+			const size_t room = floodFill(target, cells.size(), tailMoves ? tail : s_Unreachable, reachesTail);
+			const Candidate candidate{ dir, reachesTail || room >= cells.size(), m_distance[target], room };
+
+			if (!found || better(candidate, best))
+			{
+				best = candidate;
+				found = true;
+			}
+		}
+
+		const auto elapsed = std::chrono::steady_clock::now() - start;
+		m_totalTime += elapsed;
+		m_worstTime = std::max<std::chrono::nanoseconds>(m_worstTime, elapsed);
+		++m_decisions;
+
+		if (!found || best.direction == current)
+		{
+			return Input::KeyKind::None;
+		}
+
+		return static_cast<Input::KeyKind>(static_cast<unsigned int>(Input::KeyKind::ArrowUp) + best.direction);
+	}
+
+	std::string AutopilotController::report() const
+	{
+		std::ostringstream out;
+		const double average = m_decisions ? static_cast<double>(m_totalTime.count()) / m_decisions / 1000.0 : 0.0;
+
+		out << "decisions:   " << m_decisions << "\n"
+			<< "decision us: " << average << " avg, " << m_worstTime.count() / 1000.0 << " max\n";
+
+		return out.str();
+	}
+
+	void AutopilotController::reset(unsigned int width, unsigned int height, Obstacles const* obstacles)
+	{
+		m_width = width;
+		m_height = height;
+		m_obstacles = obstacles;
+
+		const size_t area = static_cast<size_t>(width) * height;
+
+		m_blocked.assign(area, 0);
+		m_distance.assign(area, s_Unreachable);
+		m_mark.assign(area, 0);
+		m_epoch = 0;
+		m_body.clear();
+		m_food = s_Unreachable;
+
+		for (unsigned int x = 0; x < width; ++x)
+		{
+			m_blocked[x] = 1;
+			m_blocked[(height - 1) * width + x] = 1;
+		}
+
+		for (unsigned int y = 0; y < height; ++y)
+		{
+			m_blocked[y * width] = 1;
+			m_blocked[y * width + width - 1] = 1;
+		}
+
+		if (obstacles)
+		{
+			for (LevelFormat::Run const& run : obstacles->level().runs())
+			{
+				for (uint32_t x = run.x; x < run.x + run.length && x < width - 1 && run.y < height - 1; ++x)
+				{
+					m_blocked[run.y * width + x] = 1;
+				}
+			}
+		}
+	}
+
+	uint32_t AutopilotController::nextEpoch()
+	{
+		if (++m_epoch == 0)
+		{
+			std::fill(m_mark.begin(), m_mark.end(), 0);
+			m_epoch = 1;
+		}
+
+		return m_epoch;
+	}
+
+	void AutopilotController::syncBody(Game const& game)
+	{
+		const auto& cells = game.snake().cells();
+		Food const* food = game.food();
+		const uint32_t foodCell = food ? food->cells().front()->y * m_width + food->cells().front()->x : s_Unreachable;
+
+		// Usual tick: one new head cell, the old tail dropped (or kept, after growing)
+		const uint32_t newHead = cells.front()->y * m_width + cells.front()->x;
+		bool shifted = !m_body.empty() && cells.size() >= m_body.size() && cells.size() <= m_body.size() + 1;
+
+		for (size_t i = 1; shifted && i < cells.size(); ++i)
+		{
+			shifted = cells[i]->y * m_width + cells[i]->x == m_body[i - 1];
+		}
+
+		const bool dropsTail = shifted && cells.size() == m_body.size();
+		const uint32_t oldTail = m_body.empty() ? s_Unreachable : m_body.back();
+
+		const bool incremental = shifted && foodCell == m_food;
+
+		if (shifted)
+		{
+			m_body.insert(m_body.begin(), newHead);
+
+			if (dropsTail)
+			{
+				m_body.pop_back();
+			}
+		}
+		else
+		{
+			for (uint32_t cell : m_body)
+			{
+				--m_blocked[cell];
+			}
+
+			m_body.clear();
+
+			for (const auto& cell : cells)
+			{
+				m_body.push_back(cell->y * m_width + cell->x);
+				++m_blocked[m_body.back()];
+			}
+		}
+
+		if (!incremental)
+		{
+			if (shifted)
+			{
+				++m_blocked[newHead];
+
+				if (dropsTail)
+				{
+					--m_blocked[oldTail];
+				}
+			}
+
+			m_food = foodCell;
+			rebuild();
+
+			return;
+		}
+
+		if (m_blocked[newHead]++ == 0)
+		{
+			block(newHead);
+		}
+
+		if (dropsTail && --m_blocked[oldTail] == 0)
+		{
+			unblock(oldTail);
+		}
+	}
+
+	void AutopilotController::rebuild()
+	{
+		std::fill(m_distance.begin(), m_distance.end(), s_Unreachable);
+
+		if (m_food == s_Unreachable || m_blocked[m_food] != 0)
+		{
+			return;
+		}
+
+		m_queue.clear();
+		m_queue.push_back(m_food);
+		m_distance[m_food] = 0;
+
+		for (size_t i = 0; i < m_queue.size(); ++i)
+		{
+			const uint32_t cell = m_queue[i];
+			const uint32_t next = m_distance[cell] + 1;
+
+			forNeighbors(cell, [&](uint32_t neighbor)
+			{
+				if (m_blocked[neighbor] == 0 && m_distance[neighbor] == s_Unreachable)
+				{
+					m_distance[neighbor] = next;
+					m_queue.push_back(neighbor);
+				}
+			});
+		}
+	}
+
+	void AutopilotController::block(uint32_t cell)
+	{
+		if (m_food == s_Unreachable || m_distance[cell] == s_Unreachable)
+		{
+			m_distance[cell] = s_Unreachable;
+			return;
+		}
+
+		if (cell == m_food)
+		{
+			rebuild();
+			return;
+		}
+
+		// Collect the cells whose every shortest path ran through `cell`, nearest first
+		const uint32_t epoch = nextEpoch();
+
+		m_affected.clear();
+		m_affected.push_back(cell);
+		m_mark[cell] = epoch;
+
+		for (size_t i = 0; i < m_affected.size(); ++i)
+		{
+			const uint32_t parent = m_affected[i];
+			const uint32_t level = m_distance[parent] + 1;
+
+			forNeighbors(parent, [&](uint32_t child)
+			{
+				if (m_blocked[child] != 0 || m_mark[child] == epoch || m_distance[child] != level)
+				{
+					return;
+				}
+
+				bool supported = false;
+
+				forNeighbors(child, [&](uint32_t other)
+				{
+					supported = supported || (m_blocked[other] == 0 && m_mark[other] != epoch && m_distance[other] == level - 1);
+				});
+
+				if (!supported)
+				{
+					m_mark[child] = epoch;
+					m_affected.push_back(child);
+				}
+			});
+		}
+
+		m_distance[cell] = s_Unreachable;
+
+		// Seed every affected cell from its unaffected neighbours, then settle them in distance order by
+		// merging the sorted seeds with a BFS queue
+		m_queue.clear();
+
+		for (size_t i = 1; i < m_affected.size(); ++i)
+		{
+			const uint32_t affected = m_affected[i];
+			uint32_t best = s_Unreachable;
+
+			forNeighbors(affected, [&](uint32_t neighbor)
+			{
+				if (m_blocked[neighbor] == 0 && m_mark[neighbor] != epoch && m_distance[neighbor] != s_Unreachable)
+				{
+					best = std::min(best, m_distance[neighbor] + 1);
+				}
+			});
+
+			m_distance[affected] = best;
+
+			if (best != s_Unreachable)
+			{
+				m_queue.push_back(affected);
+			}
+		}
+
+		std::sort(m_queue.begin(), m_queue.end(), [this](uint32_t a, uint32_t b) { return m_distance[a] < m_distance[b]; });
+
+		const size_t seeds = m_queue.size();
+		size_t nextSeed = 0;
+		size_t nextQueued = seeds;
+
+		while (nextSeed < seeds || nextQueued < m_queue.size())
+		{
+			uint32_t current;
+
+			if (nextQueued == m_queue.size() || (nextSeed < seeds && m_distance[m_queue[nextSeed]] <= m_distance[m_queue[nextQueued]]))
+			{
+				current = m_queue[nextSeed++];
+			}
+			else
+			{
+				current = m_queue[nextQueued++];
+			}
+
+			const uint32_t next = m_distance[current] + 1;
+
+			forNeighbors(current, [&](uint32_t neighbor)
+			{
+				if (m_blocked[neighbor] == 0 && m_mark[neighbor] == epoch && m_distance[neighbor] > next)
+				{
+					m_distance[neighbor] = next;
+					m_queue.push_back(neighbor);
+				}
+			});
+		}
+	}
+
+	void AutopilotController::unblock(uint32_t cell)
+	{
+		if (m_food == s_Unreachable)
+		{
+			return;
+		}
+
+		if (cell == m_food)
+		{
+			rebuild();
+			return;
+		}
+
+		uint32_t best = s_Unreachable;
+
+		forNeighbors(cell, [&](uint32_t neighbor)
+		{
+			if (m_blocked[neighbor] == 0 && m_distance[neighbor] != s_Unreachable)
+			{
+				best = std::min(best, m_distance[neighbor] + 1);
+			}
+		});
+
+		m_distance[cell] = best;
+
+		if (best == s_Unreachable)
+		{
+			return;
+		}
+
+		m_queue.clear();
+		m_queue.push_back(cell);
+
+		for (size_t i = 0; i < m_queue.size(); ++i)
+		{
+			const uint32_t current = m_queue[i];
+			const uint32_t next = m_distance[current] + 1;
+
+			forNeighbors(current, [&](uint32_t neighbor)
+			{
+				if (m_blocked[neighbor] == 0 && m_distance[neighbor] > next)
+				{
+					m_distance[neighbor] = next;
+					m_queue.push_back(neighbor);
+				}
+			});
+		}
+	}
+
+	size_t AutopilotController::floodFill(uint32_t start, size_t limit, uint32_t tail, bool& reachesTail)
+	{
+		const uint32_t epoch = nextEpoch();
+
+		reachesTail = start == tail;
+		m_queue.clear();
+		m_queue.push_back(start);
+		m_mark[start] = epoch;
+
+		for (size_t i = 0; i < m_queue.size() && m_queue.size() < limit; ++i)
+		{
+			forNeighbors(m_queue[i], [&](uint32_t neighbor)
+			{
+				if (m_mark[neighbor] == epoch)
+				{
+					return;
+				}
+
+				if (neighbor == tail)
+				{
+					reachesTail = true;
+				}
+				else if (m_blocked[neighbor] != 0)
+				{
+					return;
+				}
+
+				m_mark[neighbor] = epoch;
+				m_queue.push_back(neighbor);
+			});
+
+			if (reachesTail)
+			{
+				break;
+			}
+		}
+
+		return m_queue.size();
+	}
+};
@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#include "include/batch.h"
+#include "include/random.h"
+
+namespace Snake
+{
+	BatchEnv::BatchEnv(unsigned int width, unsigned int height, size_t games, uint64_t seed, unsigned int threads)
+		: m_width(width),
+		  m_height(height),
+		  m_games(games),
+		  m_capacity((width - 2) * (height - 2) + 2),
+		  m_pool(threads),
+		  m_boards(games * width * height, 0),
+		  m_body(games * m_capacity),
+		  m_headSlot(games),
+		  m_length(games),
+		  m_headX(games),
+		  m_headY(games),
+		  m_nextX(games),
+		  m_nextY(games),
+		  m_direction(games),
+		  m_food(games),
+		  m_frames(games),
+		  m_rng(games),
+		  m_rewards(games, 0),
+		  m_dones(games, 0)
+	{
+		const size_t area = static_cast<size_t>(width) * height;
+
+		for (size_t g = 0; g < games; ++g)
+		{
+			uint8_t* board = &m_boards[g * area];
+
+			for (unsigned int x = 0; x < width; ++x)
+			{
+				board[x] = WALL;
+				board[(height - 1) * width + x] = WALL;
+			}
+
+			for (unsigned int y = 0; y < height; ++y)
+			{
+				board[y * width] = WALL;
+				board[y * width + width - 1] = WALL;
+			}
+
+			m_rng[g] = Rng::s_StreamSeed(seed, g);
+			m_length[g] = 0;
+
+			resetGame(g);
+		}
+	}
+
+	size_t BatchEnv::games() const noexcept
+	{
+		return m_games;
+	}
+
+	unsigned int BatchEnv::width() const noexcept
+	{
+		return m_width;
+	}
+
+	unsigned int BatchEnv::height() const noexcept
+	{
+		return m_height;
+	}
+
+	const int8_t* BatchEnv::rewards() const noexcept
+	{
+		return m_rewards.data();
+	}
+
+	const uint8_t* BatchEnv::dones() const noexcept
+	{
+		return m_dones.data();
+	}
+
+	uint32_t BatchEnv::length(size_t game) const noexcept
+	{
+		return m_length[game];
+	}
+
+	Position BatchEnv::head(size_t game) const noexcept
+	{
+		return { static_cast<unsigned int>(m_headX[game]), static_cast<unsigned int>(m_headY[game]) };
+	}
+
+	const uint8_t* BatchEnv::board(size_t game) const noexcept
+	{
+		return &m_boards[game * m_width * m_height];
+	}
+
+	void BatchEnv::resetGame(size_t g) noexcept
+	{
+		uint8_t* board = &m_boards[g * m_width * m_height];
+		uint32_t* body = &m_body[g * m_capacity];
+
+		// Only the old snake needs clearing, the border never changes
+		for (uint32_t i = 0; i < m_length[g]; ++i)
+		{
+			--board[body[(m_headSlot[g] + i) % m_capacity]];
+		}
+
+		// Same layout as Snake::Snake: head in the middle, body extending to the right, moving left
+		const int32_t x = static_cast<int32_t>(m_width / 2);
+		const int32_t y = static_cast<int32_t>(m_height / 2);
+
+		for (uint32_t i = 0; i < START_LENGTH; ++i)
+		{
+			body[i] = y * m_width + x + i;
+			++board[body[i]];
+		}
+
+		m_headSlot[g] = 0;
+		m_length[g] = START_LENGTH;
+		m_headX[g] = x;
+		m_headY[g] = y;
+		m_direction[g] = LEFT - 1;
+		m_food[g] = NO_FOOD;
+		m_frames[g] = 0;
+	}
+
+	void BatchEnv::spawnFood(size_t g) noexcept
+	{
+		const uint8_t* board = &m_boards[g * m_width * m_height];
+
+		if (m_length[g] >= (m_width - 2) * (m_height - 2))
+		{
+			return; // No empty cell left
+		}
+
+		// Same draws as Snake::Game::insertFood: x then y, retried until the cell is empty
+		uint32_t x, y;
+
+		do
+		{
+			x = Rng::s_Below(m_rng[g], m_width - 2) + 1;
+			y = Rng::s_Below(m_rng[g], m_height - 2) + 1;
+		} while (board[y * m_width + x] != 0);
+
+		m_food[g] = y * m_width + x;
+	}
+
+	void BatchEnv::steer(const uint8_t* __restrict actions, size_t begin, size_t end) noexcept
+	{
+		uint8_t* __restrict direction = m_direction.data();
+		const int32_t* __restrict headX = m_headX.data();
+		const int32_t* __restrict headY = m_headY.data();
+		int32_t* __restrict nextX = m_nextX.data();
+		int32_t* __restrict nextY = m_nextY.data();
+
+		// Branch free so it vectorizes: Up = 0, Down = 1, Left = 2, Right = 3 and the reverse of d is d ^ 1
+		for (size_t i = begin; i < end; ++i)
+		{
+			const uint8_t current = direction[i];
+			const uint8_t wanted = static_cast<uint8_t>(actions[i] - 1);
+			const bool accept = (actions[i] != KEEP) & (wanted != (current ^ 1));
+			const uint8_t d = accept ? wanted : current;
+
+			direction[i] = d;
+			nextX[i] = headX[i] + (d == 3) - (d == 2);
+			nextY[i] = headY[i] + (d == 1) - (d == 0);
+		}
+	}
+
+	void BatchEnv::advance(size_t begin, size_t end) noexcept
+	{
+		const size_t area = static_cast<size_t>(m_width) * m_height;
+
+		for (size_t g = begin; g < end; ++g)
+		{
+			uint8_t* board = &m_boards[g * area];
+			uint32_t* body = &m_body[g * m_capacity];
+			int8_t reward = 0;
+
+			// Snake::Game::update spawns food before moving
+			if (m_frames[g] != 0 && m_frames[g] % FOOD_FREQ == 0 && m_food[g] == NO_FOOD)
+			{
+				spawnFood(g);
+			}
+
+			// Snake::move: every segment takes the place of the one in front, so the tail slot becomes the new head
+			const uint32_t len = m_length[g];
+			const uint32_t tailSlot = (m_headSlot[g] + len - 1) % m_capacity;
+			const uint32_t newHead = static_cast<uint32_t>(m_nextY[g]) * m_width + static_cast<uint32_t>(m_nextX[g]);
+
+			--board[body[tailSlot]];
+
+			m_headSlot[g] = (m_headSlot[g] + m_capacity - 1) % m_capacity;
+			body[m_headSlot[g]] = newHead;
+			m_headX[g] = m_nextX[g];
+			m_headY[g] = m_nextY[g];
+
+			// Collisions in Snake::Game pair order: border, food, self
+			const bool hitWall = board[newHead] == WALL;
+			bool gameOver = hitWall;
+
+			if (!hitWall)
+			{
+				++board[newHead];
+
+				if (newHead == m_food[g])
+				{
+					// Snake::grow duplicates the tail; the copy stays behind on the next move
+					const uint32_t tail = body[(m_headSlot[g] + len - 1) % m_capacity];
+
+					body[(m_headSlot[g] + len) % m_capacity] = tail;
+					++board[tail];
+					++m_length[g];
+
+					m_food[g] = NO_FOOD;
+					reward = 1;
+				}
+				else if (board[newHead] > 1)
+				{
+					gameOver = true;
+				}
+			}
+
+			++m_frames[g];
+
+			if (gameOver)
+			{
+				if (hitWall)
+				{
+					// The head was never counted on the border cell, so take it out of the ring before clearing
+					m_headSlot[g] = (m_headSlot[g] + 1) % m_capacity;
+					--m_length[g];
+				}
+
+				resetGame(g);
+				reward = -1;
+			}
+
+			m_rewards[g] = reward;
+			m_dones[g] = gameOver;
+		}
+	}
+
+	void BatchEnv::step(const uint8_t* actions)
+	{
+		m_pool.parallelFor(m_games, 1024, [this, actions](size_t begin, size_t end) {
+			steer(actions, begin, end);
+			advance(begin, end);
+		});
+	}
+
+	int runBatch(Options const& options)
+	{
+		const uint64_t seed = options.seed != 0 ? options.seed : std::random_device{}();
+		const uint64_t steps = options.ticks;
+
+		BatchEnv env(options.width, options.height, options.batchGames, seed, options.threads);
+
+		std::vector<uint8_t> actions(env.games());
+		uint64_t actionState = Rng::s_StreamSeed(seed, UINT64_MAX);
+		uint64_t eaten = 0;
+		uint64_t deaths = 0;
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (uint64_t s = 0; s < steps; ++s)
+		{
+			// Turn roughly one tick in six, like Snake::RandomController
+			for (uint8_t& action : actions)
+			{
+				uint64_t roll = Rng::s_Next(actionState);
+				action = (roll % 6 == 0) ? static_cast<uint8_t>(1 + (roll >> 8) % 4) : static_cast<uint8_t>(BatchEnv::KEEP);
+			}
+
+			env.step(actions.data());
+
+			for (size_t g = 0; g < env.games(); ++g)
+			{
+				eaten += env.rewards()[g] > 0;
+				deaths += env.dones()[g];
+			}
+		}
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		double envSteps = static_cast<double>(steps) * env.games();
+
+		std::cout << "games:       " << env.games() << "\n"
+			<< "threads:     " << (options.threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : options.threads) << "\n"
+			<< "steps:       " << static_cast<uint64_t>(envSteps) << "\n"
+			<< "seconds:     " << seconds << "\n"
+			<< "steps/s:     " << static_cast<uint64_t>(seconds > 0 ? envSteps / seconds : 0) << "\n"
+			<< "food eaten:  " << eaten << "\n"
+			<< "game overs:  " << deaths << std::endl;
+
+		return 0;
+	}
+};
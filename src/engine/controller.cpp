@@ -0,0 +1,91 @@
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "include/controller.h"
+#include "include/game.h"
+
+namespace Snake
+{
+	ScriptedController::ScriptedController(std::filesystem::path const& path)
+	{
+		std::ifstream in(path);
+
+		if (!in.is_open())
+			throw std::runtime_error("Failed to open input script " + path.string());
+
+		std::string line;
+		unsigned int lineNo = 0;
+		uint64_t lastTick = 0;
+
+		while (std::getline(in, line))
+		{
+			++lineNo;
+
+			if (line.empty() || line[0] == '#')
+			{
+				continue;
+			}
+
+			std::istringstream fields(line);
+			uint64_t tick;
+			std::string direction;
+
+			if (!(fields >> tick >> direction) || tick < lastTick)
+			{
+				throw std::runtime_error("Invalid input script line " + std::to_string(lineNo) + ": " + line);
+			}
+
+			Input::KeyKind key;
+
+			if (direction == "up")
+				key = Input::KeyKind::ArrowUp;
+			else if (direction == "down")
+				key = Input::KeyKind::ArrowDown;
+			else if (direction == "left")
+				key = Input::KeyKind::ArrowLeft;
+			else if (direction == "right")
+				key = Input::KeyKind::ArrowRight;
+			else
+				throw std::runtime_error("Invalid direction in input script line " + std::to_string(lineNo) + ": " + direction);
+
+			m_entries.emplace_back(tick, key);
+			lastTick = tick;
+		}
+	}
+
+	Input::KeyKind ScriptedController::nextKey(Game const& game)
+	{
+		Input::KeyKind key = Input::KeyKind::None;
+
+		// Several entries for the same tick: the last one wins, like multiple key presses within a frame
+		while (m_next < m_entries.size() && m_entries[m_next].first <= game.ticksElapsed())
+		{
+			key = m_entries[m_next++].second;
+		}
+
+		return key;
+	}
+
+	RandomController::RandomController(uint64_t seed)
+		: m_rng(Rng::s_StreamSeed(seed, 1)) // stream 0 is the game's own food generator
+	{}
+
+	Input::KeyKind RandomController::nextKey(Game const&)
+	{
+		static constexpr Input::KeyKind arrows[] = {
+			Input::KeyKind::ArrowUp, Input::KeyKind::ArrowDown,
+			Input::KeyKind::ArrowLeft, Input::KeyKind::ArrowRight
+		};
+
+		uint64_t roll = m_rng.next();
+
+		if (roll % s_TurnOdds != 0)
+		{
+			return Input::KeyKind::None;
+		}
+
+		return arrows[(roll / s_TurnOdds) % 4];
+	}
+};
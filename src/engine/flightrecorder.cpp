@@ -0,0 +1,394 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "include/flightrecorder.h"
+#include "include/log.h"
+
+namespace Snake
+{
+	namespace FlightRecorder
+	{
+		namespace
+		{
+			const std::chrono::steady_clock::time_point s_ProcessStart = std::chrono::steady_clock::now();
+
+			// Single writer: only the game thread records, dumps only read
+			Record s_ring[RECORDS];
+			std::atomic<uint64_t> s_written{ 0 };
+
+			// Set by start(), before the handlers that read them are installed
+			char s_path[4096];
+			Header s_header;
+			std::atomic<bool> s_started{ false };
+			std::atomic_flag s_dumping = ATOMIC_FLAG_INIT;
+
+			uint64_t s_slowNs = UINT64_MAX;
+			bool s_slowDumped = false;
+
+			uint64_t s_Now() noexcept
+			{
+				return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_ProcessStart).count());
+			}
+
+			bool s_WriteAll(int fd, void const* data, size_t size) noexcept
+			{
+				auto bytes = static_cast<char const*>(data);
+
+				while (size > 0)
+				{
+#if defined(_WIN32)
+					const int written = ::_write(fd, bytes, static_cast<unsigned int>(size));
+#else
+					const ssize_t written = ::write(fd, bytes, size);
+#endif
+
+					if (written < 0)
+					{
+#if !defined(_WIN32)
+						if (errno == EINTR)
+							continue;
+#endif
+
+						return false;
+					}
+
+					bytes += written;
+					size -= static_cast<size_t>(written);
+				}
+
+				return true;
+			}
+
+			void s_CrashHandler(int signal)
+			{
+				dump(Reason::Crash, signal);
+
+				// Die of the signal as if it had never been caught, leaving a core dump where enabled
+				std::signal(signal, SIG_DFL);
+				std::raise(signal);
+			}
+
+			const char* s_KindName(uint8_t kind) noexcept
+			{
+				switch (static_cast<Kind>(kind))
+				{
+					case Kind::Tick: return "tick";
+					case Kind::Key: return "key";
+					case Kind::Frame: return "frame";
+					case Kind::Restart: return "restart";
+					case Kind::Pause: return "pause";
+					case Kind::Resume: return "resume";
+					default: return "?";
+				}
+			}
+
+			const char* s_ReasonName(uint32_t reason) noexcept
+			{
+				switch (static_cast<Reason>(reason))
+				{
+					case Reason::GameOver: return "game over";
+					case Reason::Interrupt: return "interrupted";
+					case Reason::Crash: return "crash";
+					case Reason::SlowTick: return "slow tick";
+					case Reason::SlowFrame: return "slow frame";
+					default: return "?";
+				}
+			}
+
+			const char* s_KeyName(uint8_t key) noexcept
+			{
+				switch (static_cast<Input::KeyKind>(key))
+				{
+					case Input::KeyKind::None: return "-";
+					case Input::KeyKind::Char: return "char";
+					case Input::KeyKind::Enter: return "enter";
+					case Input::KeyKind::EscapeKey: return "escape";
+					case Input::KeyKind::ArrowUp: return "up";
+					case Input::KeyKind::ArrowDown: return "down";
+					case Input::KeyKind::ArrowLeft: return "left";
+					case Input::KeyKind::ArrowRight: return "right";
+					case Input::KeyKind::FocusIn: return "focus-in";
+					case Input::KeyKind::FocusOut: return "focus-out";
+					default: return "?";
+				}
+			}
+
+			// Indexed by Snake::Snake::Direction and CollisionResult
+			constexpr const char* s_Directions[] = { "up", "down", "left", "right" };
+			constexpr const char* s_Collisions[] = { "none", "points", "game-over" };
+		}
+
+		void start(Options const& options, unsigned int width, unsigned int height, uint64_t seed)
+		{
+			const std::filesystem::path path(options.flightPath);
+
+			if (path.has_parent_path())
+			{
+				std::error_code error;
+				std::filesystem::create_directories(path.parent_path(), error); // a failed dump reports it later
+			}
+
+			const std::string native = path.string();
+
+			if (native.size() >= sizeof(s_path))
+				throw std::invalid_argument("Flight recorder path is too long: " + native);
+
+			std::memcpy(s_path, native.c_str(), native.size() + 1);
+
+			s_header = Header{};
+			std::memcpy(s_header.magic, MAGIC, sizeof(MAGIC));
+			s_header.version = VERSION;
+			s_header.recordSize = sizeof(Record);
+			s_header.width = width;
+			s_header.height = height;
+			s_header.tickRate = options.tickRate;
+			s_header.seed = seed;
+
+			s_slowNs = 1000000000ull / options.tickRate;
+
+			s_started.store(true, std::memory_order_release);
+
+			std::signal(SIGSEGV, s_CrashHandler);
+			std::signal(SIGABRT, s_CrashHandler);
+			std::signal(SIGFPE, s_CrashHandler);
+			std::signal(SIGILL, s_CrashHandler);
+#ifdef SIGBUS
+			std::signal(SIGBUS, s_CrashHandler);
+#endif
+		}
+
+		void record(Record record) noexcept
+		{
+			record.time = s_Now();
+
+			const uint64_t written = s_written.load(std::memory_order_relaxed);
+			s_ring[written % RECORDS] = record;
+			s_written.store(written + 1, std::memory_order_release); // a dump never reads a slot before it is complete
+
+			const bool timed = record.kind == static_cast<uint8_t>(Kind::Tick) || record.kind == static_cast<uint8_t>(Kind::Frame);
+
+			if (timed && record.totalNs > s_slowNs && !s_slowDumped)
+			{
+				s_slowDumped = true; // once per game: the ring already holds what led up to it
+
+				const bool tick = record.kind == static_cast<uint8_t>(Kind::Tick);
+
+				if (dump(tick ? Reason::SlowTick : Reason::SlowFrame))
+				{
+					SNAKE_LOG(warning) << (tick ? "Tick " : "Frame after tick ") << record.tick << " took " << record.totalNs / 1000
+						<< " us, flight recorder dumped to " << s_path;
+				}
+			}
+		}
+
+		void event(Kind kind, uint64_t tick) noexcept
+		{
+			if (kind == Kind::Restart)
+			{
+				s_slowDumped = false;
+			}
+
+			Record entry{};
+			entry.kind = static_cast<uint8_t>(kind);
+			entry.tick = tick;
+
+			record(entry);
+		}
+
+		void key(uint64_t tick, Input::KeyEvent key) noexcept
+		{
+			Record entry{};
+			entry.kind = static_cast<uint8_t>(Kind::Key);
+			entry.tick = tick;
+			entry.key = static_cast<uint8_t>(key.kind);
+			entry.value = static_cast<uint32_t>(key.codepoint);
+
+			record(entry);
+		}
+
+		void frame(uint64_t tick, std::size_t bytes, std::chrono::nanoseconds took) noexcept
+		{
+			Record entry{};
+			entry.kind = static_cast<uint8_t>(Kind::Frame);
+			entry.tick = tick;
+			entry.value = static_cast<uint32_t>(std::min<std::size_t>(bytes, UINT32_MAX));
+			entry.totalNs = s_Nanoseconds(took);
+
+			record(entry);
+		}
+
+		bool dump(Reason reason, int signal) noexcept
+		{
+			if (!s_started.load(std::memory_order_acquire) || s_dumping.test_and_set(std::memory_order_acquire))
+			{
+				return false; // not started, or a signal arrived during another dump
+			}
+
+			Header header = s_header;
+			header.reason = static_cast<uint32_t>(reason);
+			header.signal = signal;
+			header.written = s_written.load(std::memory_order_acquire);
+			header.records = std::min<uint64_t>(header.written, RECORDS);
+			header.time = s_Now();
+
+#if defined(_WIN32)
+			const int fd = ::_open(s_path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+			const int fd = ::open(s_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+
+			bool ok = fd >= 0;
+
+			if (ok)
+			{
+				// Oldest first: the ring from the oldest slot to its end, then from its start
+				const size_t first = static_cast<size_t>((header.written - header.records) % RECORDS);
+				const size_t tail = std::min<size_t>(static_cast<size_t>(header.records), RECORDS - first);
+
+				ok = s_WriteAll(fd, &header, sizeof(header)) &&
+					s_WriteAll(fd, s_ring + first, tail * sizeof(Record)) &&
+					s_WriteAll(fd, s_ring, (static_cast<size_t>(header.records) - tail) * sizeof(Record));
+
+#if defined(_WIN32)
+				ok = ::_close(fd) == 0 && ok;
+#else
+				ok = ::close(fd) == 0 && ok;
+#endif
+			}
+
+			s_dumping.clear(std::memory_order_release);
+
+			return ok;
+		}
+
+		void decode(std::filesystem::path const& path, std::ostream& out)
+		{
+			std::ifstream in(path, std::ios::binary);
+
+			if (!in.is_open())
+				throw std::runtime_error("Failed to open " + path.string());
+
+			Header header{};
+
+			if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+				throw std::runtime_error(path.string() + " is not a flight recorder dump");
+
+			if (header.version != VERSION || header.recordSize != sizeof(Record))
+				throw std::runtime_error(path.string() + " is a flight recorder dump of version " + std::to_string(header.version) + ", not " + std::to_string(VERSION));
+
+			const uint64_t tickNs = 1000000000ull / std::max(1u, header.tickRate);
+			char line[256];
+
+			char signal[32] = "";
+
+			if (header.signal)
+			{
+				std::snprintf(signal, sizeof(signal), " (signal %d)", header.signal);
+			}
+
+			std::snprintf(line, sizeof(line), "%s: %s%s, %llu of %llu records, board %ux%u, %u Hz, seed %llu\n",
+				path.string().c_str(), s_ReasonName(header.reason), signal,
+				static_cast<unsigned long long>(header.records), static_cast<unsigned long long>(header.written),
+				header.width, header.height, header.tickRate, static_cast<unsigned long long>(header.seed));
+			out << line;
+
+			Record record{};
+			uint64_t read = 0;
+			Record slowest{};
+
+			while (read < header.records && in.read(reinterpret_cast<char*>(&record), sizeof(record)))
+			{
+				++read;
+
+				const double ms = static_cast<double>(record.time) / 1e6;
+
+				switch (static_cast<Kind>(record.kind))
+				{
+					case Kind::Tick:
+						std::snprintf(line, sizeof(line),
+							"%12.3f ms  tick    %8llu  head %4u,%-4u %-5s length %-6u key %-6s %-9s  decide %8.1f  update %8.1f  collision %8.1f  total %8.1f us%s\n",
+							ms, static_cast<unsigned long long>(record.tick), record.headX, record.headY,
+							record.direction < std::size(s_Directions) ? s_Directions[record.direction] : "?", record.value,
+							s_KeyName(record.key), record.collision < std::size(s_Collisions) ? s_Collisions[record.collision] : "?",
+							record.decideNs / 1e3, record.updateNs / 1e3, record.collisionNs / 1e3, record.totalNs / 1e3,
+							record.totalNs > tickNs ? "  SLOW" : "");
+
+						if (record.totalNs > slowest.totalNs)
+						{
+							slowest = record;
+						}
+						break;
+
+					case Kind::Key:
+						if (static_cast<Input::KeyKind>(record.key) == Input::KeyKind::Char)
+						{
+							std::snprintf(line, sizeof(line), "%12.3f ms  key     %8llu  char U+%04X\n",
+								ms, static_cast<unsigned long long>(record.tick), record.value);
+						}
+						else
+						{
+							std::snprintf(line, sizeof(line), "%12.3f ms  key     %8llu  %s\n",
+								ms, static_cast<unsigned long long>(record.tick), s_KeyName(record.key));
+						}
+						break;
+
+					case Kind::Frame:
+						std::snprintf(line, sizeof(line), "%12.3f ms  frame   %8llu  %u bytes, presented in %.1f us%s\n",
+							ms, static_cast<unsigned long long>(record.tick), record.value, record.totalNs / 1e3,
+							record.totalNs > tickNs ? "  SLOW" : "");
+						break;
+
+					default:
+						std::snprintf(line, sizeof(line), "%12.3f ms  %-7s %8llu\n",
+							ms, s_KindName(record.kind), static_cast<unsigned long long>(record.tick));
+						break;
+				}
+
+				out << line;
+			}
+
+			if (read < header.records)
+			{
+				out << "truncated: " << read << " of " << header.records << " records\n";
+			}
+
+			if (slowest.totalNs > 0)
+			{
+				std::snprintf(line, sizeof(line), "slowest tick: %llu, %.1f us (the tick period is %.1f us)\n",
+					static_cast<unsigned long long>(slowest.tick), slowest.totalNs / 1e3, tickNs / 1e3);
+				out << line;
+			}
+		}
+	};
+
+	int runDecodeFlight(Options const& options)
+	{
+		try
+		{
+			FlightRecorder::decode(options.decodeFlightPath, std::cout);
+
+			return 0;
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+
+			return 1;
+		}
+	}
+};
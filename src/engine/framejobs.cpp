@@ -0,0 +1,88 @@
+#include <cstdio>
+
+#include "include/framejobs.h"
+
+namespace Snake
+{
+	FrameJobs::FrameJobs(unsigned int threads)
+		: m_pool(threads), m_work(std::make_unique<ThreadWork[]>(m_pool.size()))
+	{}
+
+	unsigned int FrameJobs::threads() const noexcept
+	{
+		return m_pool.size();
+	}
+
+	std::vector<std::string>& FrameJobs::strings(size_t count)
+	{
+		if (m_strings.size() < count)
+		{
+			m_strings.resize(count);
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			m_strings[i].clear();
+		}
+
+		return m_strings;
+	}
+
+	void FrameJobs::record(Phase phase, std::chrono::nanoseconds wall) noexcept
+	{
+		Stats& stats = m_stats[static_cast<size_t>(phase)];
+
+		++stats.runs;
+		stats.wall += wall;
+
+		for (unsigned int i = 0; i < m_pool.size(); ++i)
+		{
+			stats.work += m_work[i].time;
+			m_work[i].time = std::chrono::nanoseconds(0);
+		}
+	}
+
+	const char* FrameJobs::s_Name(Phase phase) noexcept
+	{
+		switch (phase)
+		{
+			case Phase::Collide:
+				return "collide";
+			case Phase::Encode:
+				return "encode";
+			default:
+				return "?";
+		}
+	}
+
+	std::string FrameJobs::report() const
+	{
+		std::string out;
+		char line[128];
+
+		for (size_t i = 0; i < m_stats.size(); ++i)
+		{
+			Stats const& stats = m_stats[i];
+
+			if (stats.runs == 0)
+			{
+				continue;
+			}
+
+			if (out.empty())
+			{
+				out = "Parallel phases (" + std::to_string(m_pool.size()) + " threads):\n";
+			}
+
+			const double wallMs = std::chrono::duration<double, std::milli>(stats.wall).count();
+			const double workMs = std::chrono::duration<double, std::milli>(stats.work).count();
+
+			std::snprintf(line, sizeof(line), "  %-10s %10llu runs %10.3f ms wall %10.3f ms work  %5.2fx\n",
+				s_Name(static_cast<Phase>(i)), static_cast<unsigned long long>(stats.runs), wallMs, workMs,
+				wallMs > 0 ? workMs / wallMs : 0.0);
+			out += line;
+		}
+
+		return out;
+	}
+};
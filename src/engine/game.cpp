@@ -1,90 +1,983 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <iostream>
+#include <random>
 #include <thread>
 #include <chrono>
 #include <csignal>
 #include <fstream>
 #include <filesystem>
 
-#include <boost/log/utility/setup/common_attributes.hpp>
-#include <boost/log/utility/setup/from_stream.hpp>
-#include <boost/log/trivial.hpp>
+#include "include/autopilot.h"
+#include "include/board.h"
+#include "include/flightrecorder.h"
+#include "include/game.h"
+#include "include/glyphs.h"
+#include "include/input.h"
+#include "include/log.h"
+#include "include/mcts.h"
+#include "include/objects.h"
+#include "include/plugin.h"
+#include "include/trace.h"
+#include "include/utils.h"
+
+namespace Snake
+{
+	Game::Game(Options const& options) try
+		: m_options(options),
+		  m_terminal(options.headless ? nullptr : std::make_unique<Terminal>()),
+		  m_replayFile(options.replayPath.empty() ? nullptr : std::make_unique<ReplayReader>(options.replayPath)),
+		  m_level(options.levelPath.empty() ? nullptr : std::make_unique<Level>(options.levelPath)),
+		  m_width(m_replayFile ? m_replayFile->width() : m_level ? m_level->width() : m_terminal ? m_terminal->width() : options.width),
+		  m_height(m_replayFile ? m_replayFile->height() : m_level ? m_level->height() : m_terminal ? m_terminal->height() : options.height),
+		  m_buffer(m_width, m_height)
+	{
+		m_startupProfile.mark("terminal");
+
+		if (m_level && (m_level->width() != m_width || m_level->height() != m_height))
+			throw std::runtime_error("Replay board " + std::to_string(m_width) + "x" + std::to_string(m_height) + " does not match the level");
+
+		if ((m_replayFile || m_level) && m_terminal && (m_width > m_terminal->width() || m_height > m_terminal->height()))
+			throw std::runtime_error(std::string(m_replayFile ? "Replay" : "Level") + " board " + std::to_string(m_width) + "x" + std::to_string(m_height) + " does not fit the terminal");
+
+		initLogger();
+
+		m_startupProfile.mark("logger");
+
+		Game::s_setupSignalHandling(); // it's not a real cli program if we don't handle SIGINT; does nothing under Windows
+
+		SNAKE_LOG(info) << (m_terminal ? "Terminal size: " : "Headless board size: ") << m_width << " x " << m_height;
+
+		m_border = std::make_unique<Border>(m_width, m_height);
+		m_buffer.addObject(m_border.get());
+
+		if (m_level)
+		{
+			SNAKE_LOG(info) << "Level " << options.levelPath << ": " << m_level->obstacleCells() << " obstacle cells, " << m_level->spawns().size() << " spawns";
+
+			m_obstacles = std::make_unique<Obstacles>(*m_level);
+			m_buffer.addObject(m_obstacles.get());
+			m_obstacles->paint(m_buffer);
+		}
+
+		spawnSnake();
+		m_buffer.addObject(m_snake.get());
+		scheduleFood(m_FramesElapsed);
+
+		m_tickPeriod = std::chrono::nanoseconds(std::chrono::seconds(1)) / options.tickRate;
+		m_framePeriod = std::chrono::nanoseconds(std::chrono::seconds(1)) / options.fps;
+
+		if (options.parallelPhases)
+		{
+			m_jobs = std::make_unique<FrameJobs>(options.threads);
+
+			if (m_terminal)
+			{
+				m_terminal->setFrameJobs(m_jobs.get());
+			}
+
+			SNAKE_LOG(info) << "Collision and encoding phases run on " << m_jobs->threads() << " threads";
+		}
+
+		if (options.hud && m_terminal)
+		{
+			// Frames are only drawn after ticks, so the tick rate caps the frame rate too
+			m_hud = std::make_unique<PerformanceHud>(std::min(options.fps, options.tickRate));
+		}
+
+		m_seed = m_replayFile ? m_replayFile->seed() : options.seed != 0 ? options.seed : std::random_device{}();
+		m_rng = Rng(Rng::s_StreamSeed(m_seed, 0));
+
+		FlightRecorder::start(options, m_width, m_height, m_seed);
+
+		if (m_replayFile)
+		{
+			SNAKE_LOG(info) << "Playing back " << options.replayPath << " with seed " << m_seed;
+
+			auto replay = std::make_unique<ReplayController>(*m_replayFile);
+			m_replay = replay.get();
+			m_controller = std::move(replay);
+		}
+		else if (!options.scriptPath.empty())
+		{
+			m_controller = std::make_unique<ScriptedController>(options.scriptPath);
+		}
+		else if (options.autopilot)
+		{
+			m_controller = std::make_unique<AutopilotController>();
+		}
+		else if (options.mcts)
+		{
+			m_controller = std::make_unique<MctsController>(options.threads, m_seed, m_tickPeriod * options.mctsBudget / 100);
+		}
+		else if (!options.botPath.empty())
+		{
+			m_controller = std::make_unique<PluginController>(options.botPath, m_tickPeriod * options.botBudget / 100);
+		}
+		else if (options.headless)
+		{
+			SNAKE_LOG(info) << "Generating random input with seed " << m_seed;
+			m_controller = std::make_unique<RandomController>(m_seed);
+		}
+
+		if (!options.recordPath.empty())
+		{
+			m_recorder = std::make_unique<ReplayWriter>(options.recordPath, m_seed, m_width, m_height, s_ReplayChecksumInterval);
+		}
+
+		if (options.casual)
+		{
+			m_rewind = std::make_unique<RewindBuffer>(s_RewindSeconds * options.tickRate);
+		}
+
+		// Interactive games publish every rendered frame, headless ones every tick
+		const unsigned int frameMs = std::max(1u, 1000 / (m_terminal ? options.fps : options.tickRate));
+
+		if (!options.framesPath.empty())
+		{
+			m_frameRecorder = std::make_unique<FrameRecorder>(options.framesPath, m_width, m_height, frameMs);
+		}
+
+		if (!options.servePath.empty())
+		{
+			m_spectators = std::make_unique<SpectatorServer>(options.servePath, m_width, m_height, frameMs);
+		}
+
+		if (!options.shmName.empty())
+		{
+			m_sharedFrames = std::make_unique<SharedFrameWriter>(options.shmName, m_width, m_height);
+		}
+
+		m_startupProfile.mark("world");
+	} catch (const std::exception& e) {
+		std::cerr << "Exception during Game initialization: " << e.what() << std::endl;
+		Log::stop(); // exit() must not destroy the log writer under its running thread
+		exit(1);
+	}
+
+	Game::~Game()
+	{
+		if (m_recorder)
+		{
+			try
+			{
+				m_recorder->finish(m_ticksElapsed, m_gameOver);
+			}
+			catch (const std::exception& e)
+			{
+				SNAKE_LOG(error) << e.what();
+			}
+		}
+
+		logMemoryReport("exit");
+
+		Log::stop(); // drain pending records before the terminal is torn down
+	}
+
+	void Game::run()
+	{
+		if (m_terminal)
+		{
+			runInteractive();
+		}
+		else
+		{
+			runHeadless();
+		}
+	}
+
+	void Game::runInteractive()
+	{
+		while (!Input::g_exitRequested)
+		{
+			Input::KeyEvent key = Input::readKey();
+
+			if (Input::g_memoryReportRequested.load(std::memory_order_relaxed) && Input::g_memoryReportRequested.exchange(false))
+			{
+				logMemoryReport("requested");
+			}
+
+			if (key.kind == Input::KeyKind::Enter) // alternative exit
+				Input::g_exitRequested = true;
+
+			if (key.kind == Input::KeyKind::FocusOut || key.kind == Input::KeyKind::FocusIn)
+			{
+				// Only a game nobody else watches pauses on its own, and focus only ends the pause it started
+				if (key.kind == Input::KeyKind::FocusOut && !m_paused && !m_spectators && !m_sharedFrames)
+					setPaused(true, true);
+				else if (key.kind == Input::KeyKind::FocusIn && m_pausedByFocus)
+					setPaused(false);
+
+				continue;
+			}
+
+			if (key.kind == Input::KeyKind::Char && (key.codepoint == U'p' || key.codepoint == U' '))
+			{
+				setPaused(!m_paused);
+
+				continue;
+			}
+
+			if (m_paused)
+			{
+				if (!Input::g_exitRequested)
+					Input::waitForInput(); // no timer: only a key, a focus change or a signal wakes the game
+
+				continue;
+			}
+
+			const auto now = std::chrono::steady_clock::now();
+
+			if (key.kind != Input::KeyKind::None)
+			{
+				Trace::instant("input");
+				FlightRecorder::key(m_ticksElapsed, key);
+				m_pendingInput = key.kind;
+
+				if (m_hud)
+				{
+					m_hud->keyArrived(now);
+				}
+			}
+
+			if (m_awaitingInput && key.kind >= Input::KeyKind::ArrowUp && key.kind <= Input::KeyKind::ArrowRight)
+			{
+				m_awaitingInput = false;
+			}
+
+			if (m_replay)
+			{
+				simulate(); // replays play back as fast as they simulate; only the frames are capped
+			}
+			else if (!m_awaitingInput)
+			{
+				if (now - m_nextTick > s_MaxTickLag)
+				{
+					m_nextTick = now; // stopped or too slow to keep up: drop the backlog rather than race through it
+				}
+
+				while (now >= m_nextTick && !m_awaitingInput && !Input::g_exitRequested)
+				{
+					simulate();
+					m_nextTick += m_tickPeriod;
+				}
+			}
+
+			// A frame shows every tick since the last one; without a new tick there is nothing to draw
+			if (m_ticksSinceFrame > 0 && (now - m_lastFrameTime >= m_framePeriod || m_awaitingInput))
+			{
+				present();
+				m_lastFrameTime = now;
+			}
+
+			if (m_hud)
+			{
+				updateHud(now);
+			}
+
+			if (Input::g_exitRequested)
+			{
+				break;
+			}
+
+			if (m_awaitingInput)
+			{
+				Input::waitForInput(); // nothing moves before the next key anyway
+			}
+			else if (!m_replay)
+			{
+				// Sleep until the next tick or held back frame is due, or a key arrives
+				const auto wakeAt = m_ticksSinceFrame > 0 ? std::min(m_nextTick, m_lastFrameTime + m_framePeriod) : m_nextTick;
+
+				Input::waitForInput(wakeAt - std::chrono::steady_clock::now());
+			}
+		}
+	}
+
+	void Game::simulate()
+	{
+		if (m_hud)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			tick();
+			m_hud->tick(std::chrono::steady_clock::now() - start);
+		}
+		else
+		{
+			tick();
+		}
+
+		// The frame drawn later only knows what the last move vacated; clear each tick's cells now and keep them for it
+		PosVector vacated = m_buffer.getPositionsToClear();
+		m_buffer.clearPositions(vacated);
+		m_vacated.insert(m_vacated.end(), vacated.begin(), vacated.end());
+
+		++m_ticksSinceFrame;
+
+		if (m_replay && (m_replayDivergedAt || m_replay->finished(m_ticksElapsed)))
+		{
+			Input::g_exitRequested = true;
+		}
+	}
+
+	void Game::present()
+	{
+		SNAKE_TRACE_SCOPE("present");
+
+		const auto start = std::chrono::steady_clock::now();
+
+		m_border->performAnimate();
+		m_terminal->render(m_buffer, m_vacated);
+
+		if (m_hud)
+		{
+			m_hud->frame(m_terminal->lastFrameBytes(), std::chrono::steady_clock::now());
+		}
+
+		publishFrame(m_vacated);
+
+		FlightRecorder::frame(m_ticksElapsed, m_terminal->lastFrameBytes(), std::chrono::steady_clock::now() - start);
+
+		m_vacated.clear();
+		m_ticksSinceFrame = 0;
+
+		if (++m_framesRendered == 1)
+		{
+			m_startupProfile.mark("first frame");
+			SNAKE_LOG(info) << "First frame after " << m_startupProfile.total().count() << " us";
+		}
+	}
+
+	void Game::setPaused(bool paused, bool byFocus)
+	{
+		m_paused = paused;
+		m_pausedByFocus = paused && byFocus;
+
+		if (paused)
+		{
+			SNAKE_LOG(info) << (byFocus ? "Paused: terminal lost focus" : "Paused");
+			FlightRecorder::event(FlightRecorder::Kind::Pause, m_ticksElapsed);
+
+			m_terminal->status(byFocus ? "Paused while in the background, press p or Space to resume" : "Paused, press p or Space to resume");
+		}
+		else
+		{
+			SNAKE_LOG(info) << "Resumed";
+			FlightRecorder::event(FlightRecorder::Kind::Resume, m_ticksElapsed);
+
+			m_terminal->status("");
+
+			if (m_hud)
+			{
+				m_hud->reset(std::chrono::steady_clock::now()); // the pause message replaced it; draw it again
+			}
+
+			m_nextTick = std::chrono::steady_clock::now() + m_tickPeriod; // the next tick comes a full period later, not at once
+		}
+	}
+
+	void Game::updateHud(std::chrono::steady_clock::time_point now)
+	{
+		const std::size_t length = m_snake->cells().size();
+
+		if (auto line = m_hud->line(now, length, length > m_spawnLength ? length - m_spawnLength : 0))
+		{
+			m_terminal->status(*line);
+		}
+	}
+
+	void Game::runHeadless()
+	{
+		auto start = std::chrono::steady_clock::now();
+		size_t longest = m_snake->cells().size();
+
+		uint64_t simulated = 0; // unlike m_ticksElapsed, not wound back by an undone death
+
+		while (!Input::g_exitRequested && (m_options.ticks == 0 || simulated < m_options.ticks))
+		{
+			tick();
+			++simulated;
+
+			if (Input::g_memoryReportRequested.load(std::memory_order_relaxed) && Input::g_memoryReportRequested.exchange(false))
+			{
+				logMemoryReport("requested");
+			}
+
+			// No renderer to do it: drop vacated cells from the buffer ourselves, and animate the border once per tick
+			const PosVector vacated = m_buffer.getPositionsToClear();
+			m_buffer.clearPositions(vacated);
+			m_border->performAnimate();
+			publishFrame(vacated);
+
+			longest = std::max(longest, m_snake->cells().size());
+
+			if (m_replay && (m_replayDivergedAt || m_replay->finished(m_ticksElapsed)))
+			{
+				break;
+			}
+
+			if (m_gameOver)
+			{
+				if (m_replay || m_recorder)
+				{
+					break; // a replay covers a single game
+				}
+
+				restart();
+			}
+		}
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		double ticksPerSecond = seconds > 0 ? simulated / seconds : 0;
+
+		SNAKE_LOG(info) << "Headless run: " << simulated << " ticks in " << seconds << " s (" << ticksPerSecond << " ticks/s), "
+			<< m_gamesPlayed << " games, longest snake " << longest;
+
+		std::cout << "ticks:       " << simulated << "\n"
+			<< "seconds:     " << seconds << "\n"
+			<< "ticks/s:     " << static_cast<uint64_t>(ticksPerSecond) << "\n"
+			<< "games:       " << m_gamesPlayed << "\n"
+			<< "longest:     " << longest << std::endl;
+
+		if (m_controller)
+		{
+			std::cout << m_controller->report() << std::flush;
+		}
+	}
+
+	void Game::tick()
+	{
+		SNAKE_TRACE_SCOPE("tick");
+
+		const uint64_t tick = m_ticksElapsed;
+		const auto start = std::chrono::steady_clock::now();
+
+		if (m_controller)
+		{
+			Input::KeyKind key = m_controller->nextKey(*this);
+
+			if (key != Input::KeyKind::None)
+			{
+				m_pendingInput = key;
+			}
+		}
+
+		if (m_recorder)
+		{
+			switch (m_pendingInput)
+			{
+				case Input::KeyKind::ArrowUp:
+					m_recorder->input(tick, Snake::Direction::Up);
+					break;
+				case Input::KeyKind::ArrowDown:
+					m_recorder->input(tick, Snake::Direction::Down);
+					break;
+				case Input::KeyKind::ArrowLeft:
+					m_recorder->input(tick, Snake::Direction::Left);
+					break;
+				case Input::KeyKind::ArrowRight:
+					m_recorder->input(tick, Snake::Direction::Right);
+					break;
+				default:
+					break;
+			}
+		}
+
+		const auto decided = std::chrono::steady_clock::now();
+		const Input::KeyKind applied = m_pendingInput;
+
+		{
+			SNAKE_TRACE_SCOPE("update");
+			update();
+		}
+
+		const auto updated = std::chrono::steady_clock::now();
+
+		if (m_hud && m_pendingInput != Input::KeyKind::None)
+		{
+			m_hud->inputApplied();
+		}
+
+		m_pendingInput = Input::KeyKind::None;
+
+		// Pairs only change with the objects on the board, not from tick to tick
+		if (m_pairsVersion != m_buffer.getObjectsVersion())
+		{
+			SNAKE_TRACE_SCOPE("pairs");
+			m_pairs = s_GenerateUniquePairs(m_buffer.getObjects());
+			m_pairsVersion = m_buffer.getObjectsVersion();
+		}
+
+		CollisionResult collision;
+
+		{
+			SNAKE_TRACE_SCOPE("collision");
+			collision = m_jobs ? s_CheckCollisions(m_pairs, *m_jobs) : s_CheckCollisions(m_pairs);
+			handleCollisionResult(collision);
+		}
+
+		const auto collided = std::chrono::steady_clock::now();
+
+		{
+			SNAKE_TRACE_SCOPE("updateObjects");
+			m_buffer.updateObjects();
+		}
+
+		++m_FramesElapsed;
+		++m_ticksElapsed;
+
+		recordFlight(tick, applied, collision, start, decided, updated, collided);
+
+		if (m_recorder)
+		{
+			m_recorder->checksum(tick, stateChecksum());
+		}
+
+		if (m_rewind)
+		{
+			if (m_gameOver)
+			{
+				if (!undoDeath() && m_terminal)
+				{
+					Input::g_exitRequested = true;
+				}
+			}
+			else
+			{
+				snapshot(m_snapshot);
+				m_rewind->push(m_snapshot);
+			}
+		}
+
+		if (m_replay && !m_replayDivergedAt)
+		{
+			uint32_t checksum = stateChecksum();
+
+			if (!m_replay->verify(tick, checksum))
+			{
+				m_replayDivergedAt = tick;
+				m_replayActualChecksum = checksum;
+
+				SNAKE_LOG(error) << "Replay diverged at tick " << tick;
+			}
+			else if (const bool ended = m_replay->finished(m_ticksElapsed); m_gameOver != (ended && m_replayFile->endsInGameOver()))
+			{
+				// A recording that ended in a game over ends on that tick; one stopped while running never has one
+				m_replayDivergedAt = tick;
+				m_replayEndMismatch = !m_gameOver ? "the recording ended in a game over while the game was still running"
+					: ended ? "the game ended, but the recording was stopped with it still running"
+					: "the game ended before the recording did";
+
+				SNAKE_LOG(error) << "Replay diverged at tick " << tick << ": " << m_replayEndMismatch;
+			}
+		}
+	}
+
+	void Game::recordFlight(uint64_t tick, Input::KeyKind applied, CollisionResult collision, std::chrono::steady_clock::time_point start,
+		std::chrono::steady_clock::time_point decided, std::chrono::steady_clock::time_point updated, std::chrono::steady_clock::time_point collided)
+	{
+		const Position head = m_snake->getHeadPosition();
+
+		FlightRecorder::Record record{};
+		record.kind = static_cast<uint8_t>(FlightRecorder::Kind::Tick);
+		record.tick = tick;
+		record.key = static_cast<uint8_t>(applied);
+		record.collision = static_cast<uint8_t>(collision);
+		record.direction = static_cast<uint8_t>(m_snake->direction());
+		record.value = static_cast<uint32_t>(m_snake->cells().size());
+		record.headX = head.first;
+		record.headY = head.second;
+		record.decideNs = FlightRecorder::s_Nanoseconds(decided - start);
+		record.updateNs = FlightRecorder::s_Nanoseconds(updated - decided);
+		record.collisionNs = FlightRecorder::s_Nanoseconds(collided - updated);
+		record.totalNs = FlightRecorder::s_Nanoseconds(std::chrono::steady_clock::now() - start);
+
+		FlightRecorder::record(record);
+
+		// Headless runs go straight on to the next game; a player who died wants to know why
+		if (collision == CollisionResult::GAME_OVER && m_terminal)
+		{
+			if (FlightRecorder::dump(FlightRecorder::Reason::GameOver))
+			{
+				SNAKE_LOG(info) << "Flight recorder dumped to " << m_options.flightPath;
+			}
+			else
+			{
+				SNAKE_LOG(warning) << "Failed to dump the flight recorder to " << m_options.flightPath;
+			}
+		}
+	}
+
+	void Game::restart()
+	{
+		removeFood();
+
+		m_buffer.clearPositions(m_buffer.getPositionsToClear());
+		m_buffer.removeObject(m_snake.get());
+
+		if (m_obstacles)
+		{
+			m_obstacles->repaint(m_buffer, m_snake->getHeadPosition()); // the head may have died in an obstacle
+		}
+
+		// The dead snake's head may have overwritten a border cell; repaint the border first to keep object order
+		m_buffer.removeObject(m_border.get());
+		m_buffer.addObject(m_border.get());
+
+		++m_gamesPlayed;
+
+		FlightRecorder::event(FlightRecorder::Kind::Restart, m_ticksElapsed);
+
+		spawnSnake();
+		m_buffer.addObject(m_snake.get());
+
+		m_FramesElapsed = 0;
+		m_gameOver = false;
+
+		scheduleFood(m_FramesElapsed);
+	}
+
+	void Game::spawnSnake()
+	{
+		if (!m_level)
+		{
+			m_snake = std::make_unique<Snake>(static_cast<unsigned int>(m_width / 2), static_cast<unsigned int>(m_height / 2));
+			m_spawnLength = m_snake->cells().size();
+
+			return;
+		}
+
+		// Indexed by Snake::Snake::Direction
+		static constexpr uint32_t s_HeadGlyphs[] = { TGLYPHS::SNAKE_HEAD_UP, TGLYPHS::SNAKE_HEAD_DOWN, TGLYPHS::SNAKE_HEAD_LEFT, TGLYPHS::SNAKE_HEAD_RIGHT };
+		static constexpr uint32_t s_TailGlyphs[] = { TGLYPHS::SNAKE_TAIL_DOWN, TGLYPHS::SNAKE_TAIL_UP, TGLYPHS::SNAKE_TAIL_RIGHT, TGLYPHS::SNAKE_TAIL_LEFT };
+
+		const auto spawns = m_level->spawns();
+		LevelFormat::Spawn const& spawn = spawns[(m_gamesPlayed - 1) % spawns.size()];
+
+		m_restorePositions.clear();
+
+		for (unsigned int i = 0; i < LevelFormat::SPAWN_LENGTH; ++i)
+		{
+			m_restorePositions.push_back(LevelFormat::s_SpawnCell(spawn, i));
+		}
+
+		m_snake = std::make_unique<Snake>(spawn.x, spawn.y);
+		m_snake->restore(m_restorePositions, s_HeadGlyphs[spawn.direction], s_TailGlyphs[spawn.direction],
+			static_cast<Snake::Direction>(spawn.direction));
+		m_spawnLength = m_snake->cells().size();
+	}
+
+	bool Game::undoDeath()
+	{
+		if (m_rewind->size() == 0)
+		{
+			return false;
+		}
+
+		const size_t undoTicks = std::max<size_t>(1, static_cast<size_t>(s_UndoMs) * m_options.tickRate / 1000);
+
+		m_rewind->rewind(std::min<size_t>(undoTicks, m_rewind->size() - 1), m_snapshot);
+		restore(m_snapshot);
+
+		// Give the player a moment: nothing moves until the next arrow key
+		m_awaitingInput = m_terminal != nullptr;
+
+		SNAKE_LOG(info) << "Death undone, back to tick " << m_ticksElapsed;
+		FlightRecorder::event(FlightRecorder::Kind::Restart, m_ticksElapsed);
+
+		return true;
+	}
+
+	void Game::publishFrame(PosVector const& vacated)
+	{
+		if (m_frameRecorder)
+		{
+			m_frameRecorder->frame(m_buffer);
+		}
+
+		if (m_spectators)
+		{
+			m_spectators->frame(m_buffer);
+		}
 
-#include "include/game.h"
-#include "include/input.h"
-#include "include/objects.h"
-#include "include/utils.h"
+		if (m_sharedFrames)
+		{
+			const auto& cells = m_snake->cells();
+			SharedFrameFormat::Metadata metadata{};
 
-namespace Snake
-{
-	Game::Game() try
-		: m_terminal(),
-		  m_buffer(m_terminal.width(), m_terminal.height())
+			metadata.tick = m_ticksElapsed;
+			metadata.frames = m_FramesElapsed;
+			metadata.length = static_cast<uint32_t>(cells.size());
+			metadata.headX = cells.front()->x;
+			metadata.headY = cells.front()->y;
+			metadata.foodX = m_food ? m_food->cells().front()->x : SharedFrameFormat::NO_FOOD;
+			metadata.foodY = m_food ? m_food->cells().front()->y : SharedFrameFormat::NO_FOOD;
+			metadata.direction = static_cast<uint32_t>(m_snake->direction());
+			metadata.gameOver = m_gameOver ? 1 : 0;
+
+			m_sharedFrames->frame(m_buffer, vacated, metadata);
+		}
+	}
+
+	void Game::snapshot(GameSnapshot& out) const
 	{
-		initLogger();
+		const auto& cells = m_snake->cells();
+		std::vector<uint32_t>& words = out.words;
 
-		Game::s_setupSignalHandling(); // it's not a real cli program if we don't handle SIGINT; does nothing under Windows
+		words.resize(GameSnapshot::HEADER_WORDS + cells.size());
+
+		words[GameSnapshot::TICKS_LO] = static_cast<uint32_t>(m_ticksElapsed);
+		words[GameSnapshot::TICKS_HI] = static_cast<uint32_t>(m_ticksElapsed >> 32);
+		words[GameSnapshot::FRAMES] = m_FramesElapsed;
+		words[GameSnapshot::RNG_LO] = static_cast<uint32_t>(m_rng.state());
+		words[GameSnapshot::RNG_HI] = static_cast<uint32_t>(m_rng.state() >> 32);
+		words[GameSnapshot::ANIMATION] = static_cast<uint32_t>(m_border->animationFrame());
+		words[GameSnapshot::DIRECTION] = static_cast<uint32_t>(m_snake->direction());
+		words[GameSnapshot::FOOD] = m_food ? GameSnapshot::s_Pack(m_food->cells().front()->x, m_food->cells().front()->y) : GameSnapshot::NO_FOOD;
+		words[GameSnapshot::HEAD_GLYPH] = cells.front()->cell->codepoint;
+		words[GameSnapshot::TAIL_GLYPH] = cells.back()->cell->codepoint;
+
+		for (size_t i = 0; i < cells.size(); ++i)
+		{
+			words[GameSnapshot::HEADER_WORDS + i] = GameSnapshot::s_Pack(cells[i]->x, cells[i]->y);
+		}
+	}
 
-		m_width = m_terminal.width();
-		m_height = m_terminal.height();
+	void Game::restore(GameSnapshot const& in)
+	{
+		const std::vector<uint32_t>& words = in.words;
 
-		BOOST_LOG_TRIVIAL(info) << "Terminal size: " << m_width << " x " << m_height;
+		// Take everything off the board, including cells vacated by a move that was never rendered
+		removeFood();
+		m_buffer.clearPositions(m_buffer.getPositionsToClear());
+		m_buffer.removeObject(m_snake.get());
 
-		m_border = std::make_unique<Border>(m_width, m_height);
-		m_snake = std::make_unique<Snake>(static_cast<unsigned int>(m_width / 2), static_cast<unsigned int>(m_height / 2));
+		// Only a head that died in the wall leaves a hole in the border
+		const Position head = m_snake->getHeadPosition();
+
+		if (m_obstacles)
+		{
+			m_obstacles->repaint(m_buffer, head); // or in an obstacle
+		}
+		const bool repaintBorder = head.first == 0 || head.second == 0 || head.first >= m_width - 1 || head.second >= m_height - 1;
+
+		if (repaintBorder)
+		{
+			m_buffer.removeObject(m_border.get());
+		}
+
+		m_ticksElapsed = words[GameSnapshot::TICKS_LO] | (static_cast<uint64_t>(words[GameSnapshot::TICKS_HI]) << 32);
+		m_FramesElapsed = words[GameSnapshot::FRAMES];
+		m_rng.setState(words[GameSnapshot::RNG_LO] | (static_cast<uint64_t>(words[GameSnapshot::RNG_HI]) << 32));
+		m_border->setAnimationFrame(words[GameSnapshot::ANIMATION]);
+
+		m_restorePositions.clear();
+
+		for (size_t i = GameSnapshot::HEADER_WORDS; i < words.size(); ++i)
+		{
+			m_restorePositions.push_back(GameSnapshot::s_Unpack(words[i]));
+		}
+
+		m_snake->restore(m_restorePositions, words[GameSnapshot::HEAD_GLYPH], words[GameSnapshot::TAIL_GLYPH],
+			static_cast<Snake::Direction>(words[GameSnapshot::DIRECTION]));
+
+		if (repaintBorder)
+		{
+			m_buffer.addObject(m_border.get());
+		}
 
-		m_buffer.addObject(m_border.get());
 		m_buffer.addObject(m_snake.get());
-	} catch (const std::exception& e) {
-		std::cerr << "Exception during Game initialization: " << e.what() << std::endl;
-		exit(1);
+
+		if (words[GameSnapshot::FOOD] != GameSnapshot::NO_FOOD)
+		{
+			auto [x, y] = GameSnapshot::s_Unpack(words[GameSnapshot::FOOD]);
+
+			m_food = std::make_unique<Food>(x, y);
+			m_buffer.addObject(m_food.get());
+
+			m_foodSpawn = {};
+		}
+		else
+		{
+			scheduleFood(m_FramesElapsed);
+		}
+
+		m_pendingInput = Input::KeyKind::None;
+		m_gameOver = false;
+
+		if (m_terminal)
+		{
+			m_terminal->clearScreen(); // cells of the old state would otherwise stay on screen
+		}
 	}
 
-	Game::~Game() = default;
+	unsigned int Game::width() const noexcept
+	{
+		return m_width;
+	}
 
-	void Game::run()
+	unsigned int Game::height() const noexcept
 	{
-		while (!Input::g_exitRequested)
+		return m_height;
+	}
+
+	uint64_t Game::ticksElapsed() const noexcept
+	{
+		return m_ticksElapsed;
+	}
+
+	Snake const& Game::snake() const noexcept
+	{
+		return *m_snake;
+	}
+
+	Food const* Game::food() const noexcept
+	{
+		return m_food.get();
+	}
+
+	ScreenBuffer const& Game::buffer() const noexcept
+	{
+		return m_buffer;
+	}
+
+	Obstacles const* Game::obstacles() const noexcept
+	{
+		return m_obstacles.get();
+	}
+
+	std::string Game::exitReport() const
+	{
+		std::string report;
+
+		if (m_options.startupProfile)
 		{
-			auto currentTime = std::chrono::steady_clock::now();
-			auto deltaTime = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - m_lastFrameTime).count();
-			Input::KeyEvent key = Input::readKey();
+			report += m_startupProfile.report(m_options.startupBudgetMs);
+		}
 
-			if (key.kind == Input::KeyKind::Enter) // alternative exit
-				Input::g_exitRequested = true;
+		if (m_options.memoryReport)
+		{
+			report += memoryReport().report();
+		}
 
-			if (key.kind != Input::KeyKind::None)
+		if (m_jobs)
+		{
+			report += m_jobs->report();
+		}
+
+		if (m_replay)
+		{
+			if (m_replayDivergedAt && m_replayEndMismatch)
 			{
-				m_pendingInput = key.kind;
+				report += "replay diverged at tick " + std::to_string(*m_replayDivergedAt) + ": " + m_replayEndMismatch + "\n";
 			}
+			else if (m_replayDivergedAt)
+			{
+				char checksums[64];
+				std::snprintf(checksums, sizeof(checksums), "expected %08x, got %08x", m_replay->expectedChecksum(), m_replayActualChecksum);
 
-			if (deltaTime >= s_FrameTimeMs)
+				report += "replay diverged at tick " + std::to_string(*m_replayDivergedAt) + ": " + checksums + "\n";
+			}
+			else
 			{
-				update();
-				m_pendingInput = Input::KeyKind::None;
+				report += "replay verified: " + std::to_string(m_ticksElapsed) + " ticks\n";
+			}
+		}
+
+		return report;
+	}
+
+	bool Game::replayDiverged() const noexcept
+	{
+		return m_replayDivergedAt.has_value();
+	}
 
-				ObjectPairs uniquePairs = s_GenerateUniquePairs(m_buffer.getObjects());
+	MemoryReport Game::memoryReport() const
+	{
+		MemoryReport report;
 
-				handleCollisionResult(s_CheckCollisions(uniquePairs));
+		m_buffer.accountMemory(report);
+		report.addVector(MemorySubsystem::Objects, m_pairs);
 
-				m_buffer.updateObjects();
-				m_terminal.render(m_buffer);
+		report.add(MemorySubsystem::Objects, sizeof(Border));
+		m_border->accountMemory(report);
 
-				m_lastFrameTime = currentTime;
-				++m_FramesElapsed;
-			}
+		if (m_obstacles)
+		{
+			report.add(MemorySubsystem::Objects, sizeof(Obstacles));
+			m_obstacles->accountMemory(report);
+		}
+
+		report.add(MemorySubsystem::Objects, sizeof(Snake));
+		m_snake->accountMemory(report);
+
+		if (m_food)
+		{
+			report.add(MemorySubsystem::Objects, sizeof(Food));
+			m_food->accountMemory(report);
+		}
 
-			// avoid busy-waiting
-			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		report.addVector(MemorySubsystem::History, m_vacated);
+		report.addVector(MemorySubsystem::History, m_restorePositions);
+		report.addVector(MemorySubsystem::History, m_snapshot.words);
+
+		if (m_rewind)
+		{
+			report.add(MemorySubsystem::History, sizeof(RewindBuffer));
+			m_rewind->accountMemory(report);
 		}
+
+		report.add(MemorySubsystem::Logging, Log::memoryBytes(), 0);
+
+		return report;
 	}
 
-	void Game::update()
+	void Game::logMemoryReport(const char* reason) const
+	{
+		const MemoryReport report = memoryReport();
+		const MemoryReport::Usage total = report.total();
+
+		SNAKE_LOG(info) << "Memory (" << reason << "): " << total.bytes << " bytes in " << total.allocations
+			<< " allocations, snake " << m_snake->cells().size() << " cells";
+		SNAKE_LOG(info) << "Memory by subsystem (bytes/allocations): " << report.summary();
+	}
+
+	uint32_t Game::stateChecksum() const noexcept
 	{
-		if (m_FramesElapsed != 0 && m_FramesElapsed % s_FoodFreq == 0 && m_food == nullptr)
+		uint32_t hash = 2166136261u;
+
+		auto mix = [&hash](uint64_t value) {
+			for (int i = 0; i < 8; ++i)
+			{
+				hash ^= static_cast<uint8_t>(value >> (8 * i));
+				hash *= 16777619u;
+			}
+		};
+
+		mix(m_FramesElapsed);
+		mix(static_cast<uint64_t>(m_snake->direction()));
+
+		for (const auto &cell : m_snake->cells())
 		{
-			insertFood();
+			mix((static_cast<uint64_t>(cell->x) << 32) | cell->y);
 		}
 
+		if (m_food)
+		{
+			const auto &cell = m_food->cells().front();
+			mix((static_cast<uint64_t>(cell->x) << 32) | cell->y);
+		}
+
+		mix(m_rng.state());
+
+		return hash;
+	}
+
+	void Game::update()
+	{
+		m_timers.advance();
+
 		switch (m_pendingInput)
 		{
 			case Input::KeyKind::ArrowUp:
@@ -105,23 +998,50 @@ namespace Snake
 		}
 
 		m_snake->performMove(); // keep snake continuously moving with current direction
-		m_border->performAnimate();
 	}
 
 	void Game::insertFood()
 	{
-		// Place food at a random empty position
-		unsigned int foodX, foodY;
-		do
-		{
-			foodX = rand() % (m_width - 2) + 1;	 // avoid border
-			foodY = rand() % (m_height - 2) + 1; // avoid border
-		} while (!m_buffer.isPositionEmpty(foodX, foodY));
+		const auto [foodX, foodY] = s_RandomEmptyPosition(m_buffer, m_rng);
 
 		m_food = std::make_unique<Food>(foodX, foodY);
 		m_buffer.addObject(m_food.get());
 	}
 
+	Position Game::s_RandomEmptyPosition(ScreenBuffer const& buffer, Rng& rng)
+	{
+		const std::vector<CellPtr>& cells = buffer.cells();
+		const Cell* empty = buffer.getEmptyCellPtr().get();
+
+		return withBoard(buffer.width(), buffer.height(), [&](auto board) -> Position
+		{
+			unsigned int x, y;
+
+			do
+			{
+				x = rng.below(board.width() - 2) + 1;  // avoid border
+				y = rng.below(board.height() - 2) + 1; // avoid border
+			} while (cells[board.index(x, y)].get() != empty);
+
+			return { x, y };
+		});
+	}
+
+	void Game::scheduleFood(unsigned int nextFrame)
+	{
+		const unsigned int spawnFrame = std::max(s_FoodFreq, (nextFrame + s_FoodFreq - 1) / s_FoodFreq * s_FoodFreq);
+
+		// The next update advances the wheel to `nextFrame`, so the spawn frame is that many updates later, plus that one
+		m_foodSpawn = spawnFood(spawnFrame - nextFrame + 1);
+	}
+
+	TimerWheel::Script Game::spawnFood(uint64_t ticks)
+	{
+		co_await m_timers.ticks(ticks);
+
+		insertFood();
+	}
+
 	void Game::removeFood()
 	{
 		if (m_food != nullptr)
@@ -145,10 +1065,20 @@ namespace Snake
 					continue; // Skip pairs where either object has no collision
 				}
 
+				if (!objs[i]->isMovable() && !objs[j]->isMovable())
+				{
+					continue; // Two static objects never start overlapping
+				}
+
+				if (!objs[i]->canCollideWith(*objs[j]))
+				{
+					continue; // Skip pairs whose layers and masks don't match
+				}
+
 				pairs.emplace_back(objs[i], objs[j]);
 			}
 
-			if (objs[i]->getCollisionType() == CollisionType::SELF)
+			if (objs[i]->getCollisionType() == CollisionType::SELF && objs[i]->canCollideWith(*objs[i]))
 			{
 				pairs.emplace_back(objs[i], objs[i]); // Add self-pair
 			}
@@ -174,7 +1104,7 @@ namespace Snake
 				// Check if detector position collides with non-detector cell
 				if (x == cell->x && y == cell->y)
 				{
-					BOOST_LOG_TRIVIAL(info) << "Self-collision detected between head and body!";
+					SNAKE_LOG(info) << "Self-collision detected between head and body!";
 					CollisionResult result = obj->getCollisionResult(*obj);
 
 					if (result != CollisionResult::NONE)
@@ -205,6 +1135,32 @@ namespace Snake
 				continue; // Skip the regular collision check for self-pairs
 			}
 
+			// Objects without positioned cells (level obstacles) are asked about each cell of the other one
+			if (obj1->cells().empty() || obj2->cells().empty())
+			{
+				BaseObject const* region = obj1->cells().empty() ? obj1 : obj2;
+				BaseObject const* other = region == obj1 ? obj2 : obj1;
+
+				for (const auto &cell : other->cells())
+				{
+					if (region->covers(cell->x, cell->y)) [[unlikely]]
+					{
+						CollisionResult result = obj1->getCollisionResult(*obj2);
+
+						if (result != CollisionResult::NONE)
+						{
+							SNAKE_LOG(info) << "Collision detected! Result: " << static_cast<int>(result);
+
+							return result;
+						}
+
+						break; // Asking again would give the same answer
+					}
+				}
+
+				continue;
+			}
+
 			// Check if any cells from obj1 overlap with any cells from obj2
 			for (const auto &cell1 : obj1->cells())
 			{
@@ -217,7 +1173,7 @@ namespace Snake
 
 						if (result != CollisionResult::NONE)
 						{
-							BOOST_LOG_TRIVIAL(info) << "Collision detected! Result: " << static_cast<int>(result);
+							SNAKE_LOG(info) << "Collision detected! Result: " << static_cast<int>(result);
 
 							return result; // Stop at first collision
 						}
@@ -229,23 +1185,191 @@ namespace Snake
 		return CollisionResult::NONE; // No collisions detected
 	}
 
+	namespace
+	{
+		/**
+		 * @brief The object of a pair whose cells are split into chunks: the one asked about for a self pair or a
+		 *        pair with a region, the one with more cells otherwise
+		 */
+		BaseObject const* s_ScannedObject(BaseObject const* obj1, BaseObject const* obj2) noexcept
+		{
+			if (obj1 == obj2 || obj2->cells().empty())
+			{
+				return obj1;
+			}
+
+			if (obj1->cells().empty())
+			{
+				return obj2;
+			}
+
+			return obj1->cells().size() >= obj2->cells().size() ? obj1 : obj2;
+		}
+
+		/**
+		 * @brief Whether cells `[begin, end)` of the pair's scanned object overlap the other object, by the rules of `Game::s_CheckCollisions`
+		 */
+		bool s_ChunkCollides(BaseObject const* obj1, BaseObject const* obj2, PosVector const& detectors, size_t begin, size_t end)
+		{
+			BaseObject const* scanned = s_ScannedObject(obj1, obj2);
+			BaseObject const* other = scanned == obj1 ? obj2 : obj1;
+			const std::vector<PCellPtr>& cells = scanned->cells();
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				const PCellPtr& cell = cells[i];
+
+				if (obj1 == obj2)
+				{
+					if (cell->cell->detector)
+					{
+						continue;
+					}
+
+					for (const auto &[x, y] : detectors)
+					{
+						if (x == cell->x && y == cell->y)
+						{
+							return true;
+						}
+					}
+				}
+				else if (other->cells().empty())
+				{
+					if (other->covers(cell->x, cell->y))
+					{
+						return true;
+					}
+				}
+				else
+				{
+					for (const auto &otherCell : other->cells())
+					{
+						if (cell->x == otherCell->x && cell->y == otherCell->y)
+						{
+							return true;
+						}
+					}
+				}
+			}
+
+			return false;
+		}
+	}
+
+	CollisionResult Game::s_CheckCollisions(ObjectPairs const &pairs, FrameJobs& jobs)
+	{
+		struct Chunk
+		{
+			uint32_t pair;
+			uint32_t begin;
+			uint32_t end;
+		};
+
+		size_t total = 0;
+
+		for (const auto &[obj1, obj2] : pairs)
+		{
+			total += s_ScannedObject(obj1, obj2)->cells().size();
+		}
+
+		if (total <= s_CollisionChunk)
+		{
+			return s_CheckCollisions(pairs); // one chunk's worth: waking the workers would cost more than it saves
+		}
+
+		std::vector<Chunk> chunks;
+		std::vector<PosVector> detectors(pairs.size());
+
+		for (size_t p = 0; p < pairs.size(); ++p)
+		{
+			const auto &[obj1, obj2] = pairs[p];
+			const size_t count = s_ScannedObject(obj1, obj2)->cells().size();
+
+			if (obj1 == obj2)
+			{
+				detectors[p] = obj1->getDetectorCellsPos();
+			}
+
+			for (size_t begin = 0; begin < count; begin += s_CollisionChunk)
+			{
+				chunks.push_back({ static_cast<uint32_t>(p), static_cast<uint32_t>(begin), static_cast<uint32_t>(std::min(count, begin + s_CollisionChunk)) });
+			}
+		}
+
+		std::unique_ptr<std::atomic<bool>[]> hits(new std::atomic<bool>[pairs.size()]());
+
+		jobs.parallelFor(FrameJobs::Phase::Collide, chunks.size(), 1, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				Chunk const& chunk = chunks[i];
+
+				// Once a pair is hit, its other chunks cannot change the answer
+				if (!hits[chunk.pair].load(std::memory_order_relaxed) &&
+					s_ChunkCollides(pairs[chunk.pair].first, pairs[chunk.pair].second, detectors[chunk.pair], chunk.begin, chunk.end))
+				{
+					hits[chunk.pair].store(true, std::memory_order_relaxed);
+				}
+			}
+		});
+
+		// Reduce in pair order, so the first colliding pair wins as in the serial scan
+		for (size_t p = 0; p < pairs.size(); ++p)
+		{
+			if (!hits[p].load(std::memory_order_relaxed))
+			{
+				continue;
+			}
+
+			const auto &[obj1, obj2] = pairs[p];
+
+			// Same log as the serial check
+			if (obj1 == obj2) [[unlikely]]
+			{
+				SNAKE_LOG(info) << "Self-collision detected between head and body!";
+			}
+
+			const CollisionResult result = obj1->getCollisionResult(*obj2);
+
+			if (result != CollisionResult::NONE)
+			{
+				if (obj1 != obj2)
+				{
+					SNAKE_LOG(info) << "Collision detected! Result: " << static_cast<int>(result);
+				}
+
+				return result;
+			}
+		}
+
+		return CollisionResult::NONE;
+	}
+
 	void Game::handleCollisionResult(CollisionResult result)
 	{
 		// Handle collision results
 		switch (result)
 		{
 			case CollisionResult::POINTS:
-				BOOST_LOG_TRIVIAL(info) << "Snake ate food!";
+				SNAKE_LOG(info) << "Snake ate food!";
 
 				removeFood();
+				scheduleFood(m_FramesElapsed + 1); // this tick's frame is counted after the collision check
 				m_snake.get()->grow();
 
 				break;
 
 			case CollisionResult::GAME_OVER:
-				BOOST_LOG_TRIVIAL(info) << "Game Over!";
+				SNAKE_LOG(info) << "Game Over!";
+
+				m_gameOver = true;
+				logMemoryReport("game over");
 
-				Input::g_exitRequested = true; // End the game
+				if (m_terminal && !m_rewind)
+				{
+					Input::g_exitRequested = true; // End the game
+				}
 				break;
 
 			case CollisionResult::NONE:
@@ -256,8 +1380,6 @@ namespace Snake
 
 	void Game::initLogger()
 	{
-		boost::log::add_common_attributes();
-
 		std::filesystem::path exePath = Utils::getExecutablePath();
 		std::filesystem::path iniPath = exePath.parent_path() / "logging.ini";
 
@@ -266,13 +1388,19 @@ namespace Snake
 		if (!cfg.is_open())
 			throw std::runtime_error("Failed to open logging.ini");
 
-		boost::log::init_from_stream(cfg);
+		// Only read the file here; parsing it is left to the log writer thread
+		std::string config((std::istreambuf_iterator<char>(cfg)), std::istreambuf_iterator<char>());
+
+		Log::start(std::move(config), Log::OverflowPolicy::Drop);
 
-		BOOST_LOG_TRIVIAL(info) << "Logger initialized";
+		SNAKE_LOG(info) << "Logger initialized";
 	}
 
 	void Game::s_setupSignalHandling()
 	{
 		std::signal(SIGINT, Input::signalHandler);
+#ifdef SIGUSR1
+		std::signal(SIGUSR1, Input::signalHandler);
+#endif
 	}
 };
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "include/hud.h"
+
+namespace Snake
+{
+	PerformanceHud::PerformanceHud(unsigned int targetFps)
+		: m_targetFps(targetFps), m_windowStart(std::chrono::steady_clock::now())
+	{}
+
+	void PerformanceHud::tick(std::chrono::nanoseconds took) noexcept
+	{
+		++m_ticks;
+		m_tickTime += took;
+	}
+
+	void PerformanceHud::keyArrived(std::chrono::steady_clock::time_point at) noexcept
+	{
+		if (!m_keyAt)
+		{
+			m_keyAt = at;
+		}
+	}
+
+	void PerformanceHud::inputApplied() noexcept
+	{
+		m_keyApplied = m_keyAt.has_value();
+	}
+
+	void PerformanceHud::frame(std::size_t bytes, std::chrono::steady_clock::time_point at) noexcept
+	{
+		++m_frames;
+		m_frameBytes += bytes;
+
+		if (m_keyApplied)
+		{
+			const std::chrono::nanoseconds latency = at - *m_keyAt;
+
+			m_latency = m_latency ? std::max(*m_latency, latency) : latency;
+			m_keyAt.reset();
+			m_keyApplied = false;
+		}
+	}
+
+	std::optional<std::string> PerformanceHud::line(std::chrono::steady_clock::time_point now, std::size_t length, uint64_t score)
+	{
+		const auto elapsed = now - m_windowStart;
+
+		if (elapsed < s_RefreshInterval)
+		{
+			return std::nullopt;
+		}
+
+		using std::chrono::duration;
+		using std::chrono::duration_cast;
+		using std::chrono::milliseconds;
+
+		const double fps = m_frames / duration<double>(elapsed).count();
+
+		char latency[24] = "-";
+
+		if (m_latency)
+		{
+			std::snprintf(latency, sizeof(latency), "%lld ms", static_cast<long long>(duration_cast<milliseconds>(*m_latency).count()));
+		}
+
+		char buffer[160];
+		std::snprintf(buffer, sizeof(buffer), "tick %.1f us | frame %zu B | %.0f/%u fps | input %s | length %zu | score %llu",
+			m_ticks ? duration<double, std::micro>(m_tickTime).count() / m_ticks : 0.0,
+			m_frames ? m_frameBytes / m_frames : 0,
+			fps, m_targetFps, latency, length, static_cast<unsigned long long>(score));
+
+		std::string text(buffer);
+
+		startWindow(now);
+		m_shown.swap(text);
+
+		if (m_shown == text)
+		{
+			return std::nullopt;
+		}
+
+		return m_shown;
+	}
+
+	void PerformanceHud::reset(std::chrono::steady_clock::time_point now) noexcept
+	{
+		m_shown.clear();
+		startWindow(now);
+	}
+
+	void PerformanceHud::startWindow(std::chrono::steady_clock::time_point now) noexcept
+	{
+		m_windowStart = now;
+		m_ticks = 0;
+		m_tickTime = std::chrono::nanoseconds(0);
+		m_frames = 0;
+		m_frameBytes = 0;
+		m_latency.reset();
+	}
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "controller.h"
+
+namespace Snake
+{
+	class Obstacles;
+
+	/**
+	 * @class AutopilotController
+	 * @brief Steers the snake towards the food without trapping itself.
+	 *
+	 * @details
+	 * Keeps a BFS distance field from the food over the free cells of the board. The field is only
+	 * rebuilt when the food moves; as the snake moves, the cell its head enters is blocked and the cell
+	 * its tail leaves is freed, and only the distances affected by those two cells are repaired
+	 * (the increase/decrease passes of Ramalingam and Reps' dynamic shortest paths).
+	 *
+	 * Among the moves that do not collide, it picks the one closest to the food whose bounded flood
+	 * fill still reaches the tail or as many cells as the snake is long. When no such move exists it
+	 * takes the move with the most room.
+	 */
+	class AutopilotController : public Controller
+	{
+		public:
+			Input::KeyKind nextKey(Game const& game) override;
+
+			/**
+			 * @brief Average and worst decision time
+			 */
+			std::string report() const override;
+
+		private:
+			static constexpr uint32_t s_Unreachable = UINT32_MAX;
+
+			unsigned int m_width = 0;
+			unsigned int m_height = 0;
+
+			/** @brief Level obstacles the walls were built with */
+			Obstacles const* m_obstacles = nullptr;
+
+			/** @brief Walls, obstacles and snake cells */
+			std::vector<uint8_t> m_blocked;
+
+			/** @brief Steps from each cell to the food, `s_Unreachable` for blocked or cut off cells */
+			std::vector<uint32_t> m_distance;
+
+			/** @brief Per cell epoch marks, so scratch sets never need clearing */
+			std::vector<uint32_t> m_mark;
+			uint32_t m_epoch = 0;
+
+			/** @brief Snake cells as of the last decision */
+			std::vector<uint32_t> m_body;
+
+			/** @brief Food cell the field was built for, `s_Unreachable` if none */
+			uint32_t m_food = s_Unreachable;
+
+			/** @brief Scratch queues reused between calls */
+			std::vector<uint32_t> m_queue;
+			std::vector<uint32_t> m_affected;
+
+			uint64_t m_decisions = 0;
+			std::chrono::nanoseconds m_totalTime{ 0 };
+			std::chrono::nanoseconds m_worstTime{ 0 };
+
+			void reset(unsigned int width, unsigned int height, Obstacles const* obstacles);
+			void syncBody(Game const& game);
+			void rebuild();
+			void block(uint32_t cell);
+			void unblock(uint32_t cell);
+			uint32_t nextEpoch();
+
+			/**
+			 * @brief Counts free cells reachable from `start`, stopping at `limit`
+			 * @param start Cell the head would move to
+			 * @param limit Count at which the search stops
+			 * @param tail Cell the tail leaves on the move, counted as free
+			 * @param reachesTail Set if the tail cell is reachable
+			 */
+			size_t floodFill(uint32_t start, size_t limit, uint32_t tail, bool& reachesTail);
+
+			template <typename Fn>
+			void forNeighbors(uint32_t cell, Fn&& fn) const
+			{
+				fn(cell - m_width);
+				fn(cell + m_width);
+				fn(cell - 1);
+				fn(cell + 1);
+			}
+	};
+};
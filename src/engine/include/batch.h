@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "options.h"
+#include "screen.h"
+#include "workers.h"
+
+namespace Snake
+{
+	/**
+	 * @class BatchEnv
+	 * @brief Steps many independent games at once, for bot training.
+	 *
+	 * @details
+	 * Games are kept in structure-of-arrays form: one packed occupancy board per game, a ring buffer of
+	 * cell indices per snake, and flat arrays for heads, directions, food, frame counters and RNG streams.
+	 * A step first computes every game's new direction and head position in a branch free loop the
+	 * compiler can vectorize, then applies movement, food and collisions per game.
+	 *
+	 * The rules are the ones of Snake::Game: `Snake::setDirection` ignores reversals, `Snake::move` shifts
+	 * every segment, food spawns every `FOOD_FREQ` frames when there is none, eating grows the snake by
+	 * duplicating its tail (`Snake::grow`), and hitting the border or the body is game over.
+	 * A finished game is reset in place and reported through `BatchEnv::dones`.
+	 */
+	class BatchEnv
+	{
+		public:
+			/**
+			 * @brief Actions accepted by `BatchEnv::step`, one byte per game
+			 *
+			 * Values above 0 are `1 + Snake::Snake::Direction`.
+			 */
+			enum Action : uint8_t
+			{
+				KEEP = 0,
+				UP = 1,
+				DOWN = 2,
+				LEFT = 3,
+				RIGHT = 4
+			};
+
+			/** @brief Frames between food spawns, same as `Snake::Game::s_FoodFreq` */
+			static constexpr uint32_t FOOD_FREQ = 5;
+
+			/** @brief Length of a new snake, same as `Snake::Snake` */
+			static constexpr uint32_t START_LENGTH = 5;
+
+			/**
+			 * @brief Creates `games` games in their initial state
+			 * @param width Board width including the border
+			 * @param height Board height including the border
+			 * @param games Number of games
+			 * @param seed Base seed; game `i` uses stream `Rng::s_StreamSeed(seed, i)`
+			 * @param threads Worker threads, 0 uses all cores
+			 */
+			BatchEnv(unsigned int width, unsigned int height, size_t games, uint64_t seed, unsigned int threads = 0);
+
+			/**
+			 * @brief Advances every game by one tick
+			 * @param actions One Snake::BatchEnv::Action per game
+			 */
+			void step(const uint8_t* actions);
+
+			/** @brief Number of games */
+			size_t games() const noexcept;
+
+			/** @brief Board width */
+			unsigned int width() const noexcept;
+
+			/** @brief Board height */
+			unsigned int height() const noexcept;
+
+			/** @brief Per game reward of the last step: 1 food eaten, -1 game over, 0 otherwise */
+			const int8_t* rewards() const noexcept;
+
+			/** @brief Per game flag set when the last step ended that game (it has been reset since) */
+			const uint8_t* dones() const noexcept;
+
+			/** @brief Current snake length of a game */
+			uint32_t length(size_t game) const noexcept;
+
+			/** @brief Current head position of a game */
+			Position head(size_t game) const noexcept;
+
+			/** @brief Occupancy board of a game, `width * height` bytes (0 free, `WALL` border, else segment count) */
+			const uint8_t* board(size_t game) const noexcept;
+
+			/** @brief Board value of border cells */
+			static constexpr uint8_t WALL = 0xFF;
+
+			/** @brief Food index meaning there is no food on the board */
+			static constexpr uint32_t NO_FOOD = UINT32_MAX;
+
+		private:
+			unsigned int m_width;
+			unsigned int m_height;
+			size_t m_games;
+
+			/** @brief Ring buffer capacity per snake: every interior cell plus a duplicated tail */
+			uint32_t m_capacity;
+
+			WorkerPool m_pool;
+
+			std::vector<uint8_t> m_boards;
+			std::vector<uint32_t> m_body;
+			std::vector<uint32_t> m_headSlot;
+			std::vector<uint32_t> m_length;
+			std::vector<int32_t> m_headX;
+			std::vector<int32_t> m_headY;
+			std::vector<int32_t> m_nextX;
+			std::vector<int32_t> m_nextY;
+			std::vector<uint8_t> m_direction;
+			std::vector<uint32_t> m_food;
+			std::vector<uint32_t> m_frames;
+			std::vector<uint64_t> m_rng;
+			std::vector<int8_t> m_rewards;
+			std::vector<uint8_t> m_dones;
+
+			/**
+			 * @brief Vectorizable part of a step: direction rules and next head position
+			 */
+			void steer(const uint8_t* actions, size_t begin, size_t end) noexcept;
+
+			/**
+			 * @brief Per game part of a step: food, movement, collisions
+			 */
+			void advance(size_t begin, size_t end) noexcept;
+
+			void spawnFood(size_t game) noexcept;
+			void resetGame(size_t game) noexcept;
+	};
+
+	/**
+	 * @brief Runs `--batch` mode: steps `Options::batchGames` games with random actions and reports steps per second
+	 * @param options Snake::Options with the board size, game count, tick count, seed and threads
+	 * @return int Process exit code
+	 */
+	int runBatch(Options const& options);
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+namespace Snake
+{
+	/**
+	 * @struct Board
+	 * @brief Board dimensions known at compile time.
+	 *
+	 * @details
+	 * Full-board passes written against a board type (`board.width()`, `board.index(x, y)`, ...) get
+	 * constant strides and trip counts from this one, so the compiler can fold the index math, drop
+	 * bounds checks it can prove and unroll or vectorize the loops. Snake::DynamicBoard has the same
+	 * interface with runtime dimensions, and `withBoard` picks between them.
+	 *
+	 * @tparam W Width in cells
+	 * @tparam H Height in cells
+	 */
+	template <unsigned int W, unsigned int H>
+	struct Board
+	{
+		static_assert(W >= 3 && H >= 3, "a board needs a border and at least one inner cell");
+
+		static constexpr unsigned int width() noexcept
+		{
+			return W;
+		}
+
+		static constexpr unsigned int height() noexcept
+		{
+			return H;
+		}
+
+		static constexpr size_t cells() noexcept
+		{
+			return size_t(W) * H;
+		}
+
+		static constexpr size_t index(unsigned int x, unsigned int y) noexcept
+		{
+			return size_t(y) * W + x;
+		}
+
+		static constexpr bool contains(unsigned int x, unsigned int y) noexcept
+		{
+			return x < W && y < H;
+		}
+	};
+
+	/**
+	 * @struct DynamicBoard
+	 * @brief Board dimensions known at run time, for every size without a Snake::Board specialization.
+	 */
+	struct DynamicBoard
+	{
+		unsigned int m_width;
+		unsigned int m_height;
+
+		constexpr unsigned int width() const noexcept
+		{
+			return m_width;
+		}
+
+		constexpr unsigned int height() const noexcept
+		{
+			return m_height;
+		}
+
+		constexpr size_t cells() const noexcept
+		{
+			return size_t(m_width) * m_height;
+		}
+
+		constexpr size_t index(unsigned int x, unsigned int y) const noexcept
+		{
+			return size_t(y) * m_width + x;
+		}
+
+		constexpr bool contains(unsigned int x, unsigned int y) const noexcept
+		{
+			return x < m_width && y < m_height;
+		}
+	};
+
+	/**
+	 * @brief Board sizes compiled in as Snake::Board specializations
+	 *
+	 * The default headless board, the smallest terminal the game accepts and a common larger one, plus
+	 * the arena of a fixed-size build (`-DSNAKE_FIXED_BOARD=<w>x<h>`). Every entry instantiates each
+	 * full-board pass once more, so the list stays short.
+	 */
+	using FixedBoards = std::tuple<
+#if defined(SNAKE_FIXED_BOARD_WIDTH) && defined(SNAKE_FIXED_BOARD_HEIGHT)
+		Board<SNAKE_FIXED_BOARD_WIDTH, SNAKE_FIXED_BOARD_HEIGHT>,
+#endif
+		Board<80, 24>,
+		Board<60, 30>,
+		Board<120, 40>
+	>;
+
+	namespace Detail
+	{
+		template <typename F>
+		decltype(auto) withBoard(std::tuple<>*, unsigned int width, unsigned int height, F&& f)
+		{
+			return std::forward<F>(f)(DynamicBoard{ width, height });
+		}
+
+		template <typename First, typename... Rest, typename F>
+		decltype(auto) withBoard(std::tuple<First, Rest...>*, unsigned int width, unsigned int height, F&& f)
+		{
+			if (width == First::width() && height == First::height())
+			{
+				return std::forward<F>(f)(First{});
+			}
+
+			return withBoard(static_cast<std::tuple<Rest...>*>(nullptr), width, height, std::forward<F>(f));
+		}
+	};
+
+	/**
+	 * @brief Calls `f` with the Snake::FixedBoards entry matching the size, or with a Snake::DynamicBoard
+	 * @param width Board width
+	 * @param height Board height
+	 * @param f Generic callable taking the board by value; every instantiation must return the same type
+	 * @return Whatever `f` returns
+	 *
+	 * Dispatch once per pass, not per cell: the point is to run the whole loop against constant dimensions.
+	 */
+	template <typename F>
+	decltype(auto) withBoard(unsigned int width, unsigned int height, F&& f)
+	{
+		return Detail::withBoard(static_cast<FixedBoards*>(nullptr), width, height, std::forward<F>(f));
+	}
+};
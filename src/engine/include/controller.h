@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "input.h"
+#include "random.h"
+
+namespace Snake
+{
+	class Game;
+
+	/**
+	 * @class Controller
+	 * @brief Source of input that replaces the keyboard.
+	 *
+	 * Snake::Game asks the controller for a key once per tick, right before updating the game state.
+	 */
+	class Controller
+	{
+		public:
+			/**
+			 * @brief Default virtual destructor
+			 */
+			virtual ~Controller() = default;
+
+			/**
+			 * @brief Decides the input for the upcoming tick
+			 * @param game Snake::Game about to be updated
+			 * @return Input::KeyKind Key to apply, or Input::KeyKind::None to keep the current direction
+			 */
+			virtual Input::KeyKind nextKey(Game const& game) = 0;
+
+			/**
+			 * @brief Statistics printed at the end of a headless run, empty by default
+			 */
+			virtual std::string report() const
+			{
+				return {};
+			}
+	};
+
+	/**
+	 * @class ScriptedController
+	 * @brief Replays key presses from a script file.
+	 *
+	 * @details
+	 * One `<tick> <direction>` entry per line, where direction is `up`, `down`, `left` or `right`.
+	 * Ticks count from the start of the run and must not decrease. Lines starting with `#` are ignored.
+	 */
+	class ScriptedController : public Controller
+	{
+		public:
+			/**
+			 * @brief Loads a script
+			 * @param path Path of the script file
+			 * @throws std::runtime_error if the file cannot be read or contains an invalid line
+			 */
+			explicit ScriptedController(std::filesystem::path const& path);
+
+			Input::KeyKind nextKey(Game const& game) override;
+
+		private:
+			/** @brief (tick, key) entries in file order */
+			std::vector<std::pair<uint64_t, Input::KeyKind>> m_entries;
+
+			/** @brief Next entry to apply */
+			size_t m_next = 0;
+	};
+
+	/**
+	 * @class RandomController
+	 * @brief Generates random turns, used to drive headless soak runs.
+	 */
+	class RandomController : public Controller
+	{
+		public:
+			/**
+			 * @brief Creates the generator
+			 * @param seed Seed of the random stream
+			 */
+			explicit RandomController(uint64_t seed);
+
+			Input::KeyKind nextKey(Game const& game) override;
+
+		private:
+			Rng m_rng;
+
+			/** @brief One tick in `s_TurnOdds` produces a turn */
+			static constexpr unsigned int s_TurnOdds = 6;
+	};
+};
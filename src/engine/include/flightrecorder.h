@@ -0,0 +1,181 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+
+#include "input.h"
+#include "options.h"
+
+namespace Snake
+{
+	/**
+	 * @namespace Snake::FlightRecorder
+	 * @brief Always-on ring of the last ticks, keys and frames, dumped to a file when a game ends, stalls, is interrupted or crashes.
+	 *
+	 * @details
+	 * The game thread appends one Snake::FlightRecorder::Record per tick, key and frame to a static ring of
+	 * `RECORDS` slots: a copy into the slot and a release store of the count, no locks, allocation or system
+	 * calls. A dump only calls `open`, `write` and `close` on memory prepared by `start`, so it also runs
+	 * inside the SIGINT, SIGSEGV, SIGBUS, SIGFPE, SIGILL and SIGABRT handlers. A dump taken on another thread
+	 * while the game thread writes, e.g. on Ctrl+C during a hang, may end with one torn record.
+	 *
+	 * Dump file, little-endian, read back with `snake --decode-flight=<path>`:
+	 * - Header: a Snake::FlightRecorder::Header
+	 * - Records: `Header::records` Snake::FlightRecorder::Record, oldest first
+	 *
+	 * Every dump overwrites the file, so it holds the last one of a run.
+	 */
+	namespace FlightRecorder
+	{
+		constexpr char MAGIC[4] = { 'S', 'N', 'K', 'B' };
+		constexpr uint32_t VERSION = 1;
+
+		/**
+		 * @brief Records kept, 384 KiB: a few thousand ticks even with a key per tick
+		 */
+		constexpr std::size_t RECORDS = 1 << 13;
+
+		enum class Kind : uint8_t
+		{
+			Tick = 1,
+			Key,		// key read, applied by the next tick
+			Frame,		// frame presented
+			Restart,	// new game or rewound death
+			Pause,
+			Resume
+		};
+
+		enum class Reason : uint8_t
+		{
+			GameOver = 1,
+			Interrupt,	// SIGINT
+			Crash,		// fatal signal, see `Header::signal`
+			SlowTick,	// a tick took longer than the tick period
+			SlowFrame	// presenting a frame took longer than the tick period
+		};
+
+		/**
+		 * @brief One tick, key or frame; fields a kind does not use are 0
+		 *
+		 * Durations are in nanoseconds and saturate at about 4 seconds.
+		 */
+		struct Record
+		{
+			/** @brief Nanoseconds since the program started */
+			uint64_t time;
+			uint64_t tick;
+			uint8_t kind;
+			/** @brief Input::KeyKind a tick applied or a Key read */
+			uint8_t key;
+			/** @brief CollisionResult of a tick */
+			uint8_t collision;
+			/** @brief Snake::Snake::Direction after a tick */
+			uint8_t direction;
+			/** @brief Snake length after a tick, codepoint of a Key, bytes of a Frame */
+			uint32_t value;
+			/** @brief Snake head after a tick */
+			uint32_t headX;
+			uint32_t headY;
+			/** @brief The controller picking the tick's key */
+			uint32_t decideNs;
+			/** @brief Moving the snake */
+			uint32_t updateNs;
+			/** @brief Checking and handling collisions */
+			uint32_t collisionNs;
+			/** @brief The whole tick, or presenting a Frame */
+			uint32_t totalNs;
+		};
+
+		struct Header
+		{
+			char magic[4];
+			uint32_t version;
+			uint32_t recordSize;
+			uint32_t reason;
+			/** @brief Signal of a Crash or Interrupt, 0 otherwise */
+			int32_t signal;
+			uint32_t width;
+			uint32_t height;
+			uint32_t tickRate;
+			/** @brief Records in the file */
+			uint64_t records;
+			/** @brief Records written since `start`; the ones before the file's first were overwritten */
+			uint64_t written;
+			uint64_t seed;
+			/** @brief Nanoseconds since the program started, at the dump */
+			uint64_t time;
+		};
+
+		static_assert(sizeof(Record) == 48 && sizeof(Header) == 64);
+
+		/**
+		 * @brief Prepares dumps to `options.flightPath` and installs the fatal signal handlers
+		 * @param options Parsed command line, for the path and tick rate
+		 * @param width Board width
+		 * @param height Board height
+		 * @param seed Seed of the game
+		 *
+		 * Recording works before `start` too; dumping does not.
+		 */
+		void start(Options const& options, unsigned int width, unsigned int height, uint64_t seed);
+
+		/**
+		 * @brief Appends a record, stamping its time
+		 *
+		 * The first Tick or Frame of a game longer than the tick period triggers a dump.
+		 */
+		void record(Record record) noexcept;
+
+		/**
+		 * @brief Appends a record of a kind without payload, e.g. `Kind::Pause`
+		 */
+		void event(Kind kind, uint64_t tick) noexcept;
+
+		/**
+		 * @brief Appends a key read before tick `tick`
+		 */
+		void key(uint64_t tick, Input::KeyEvent key) noexcept;
+
+		/**
+		 * @brief Appends a frame presented after tick `tick`
+		 * @param tick Ticks elapsed
+		 * @param bytes Bytes the frame wrote to the terminal
+		 * @param took Time spent presenting it
+		 */
+		void frame(uint64_t tick, std::size_t bytes, std::chrono::nanoseconds took) noexcept;
+
+		/**
+		 * @brief Writes the ring to the dump file; async-signal-safe
+		 * @param reason Why the dump is taken
+		 * @param signal Signal being handled, 0 outside a handler
+		 * @return false if `start` was not called or the file could not be written
+		 */
+		bool dump(Reason reason, int signal = 0) noexcept;
+
+		/**
+		 * @brief Duration in Record units: nanoseconds, saturated
+		 */
+		constexpr uint32_t s_Nanoseconds(std::chrono::nanoseconds duration) noexcept
+		{
+			return duration.count() < 0 ? 0 : duration.count() > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(duration.count());
+		}
+
+		/**
+		 * @brief Prints a dump as text, one line per record
+		 * @param path Dump file
+		 * @param out Stream to print to
+		 * @throws std::runtime_error if the file cannot be read or is not a dump of this version
+		 */
+		void decode(std::filesystem::path const& path, std::ostream& out);
+	};
+
+	/**
+	 * @brief Entry point of `--decode-flight`: prints the dump as text
+	 * @param options Parsed command line
+	 * @return int Process exit code
+	 */
+	int runDecodeFlight(Options const& options);
+};
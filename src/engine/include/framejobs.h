@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "workers.h"
+
+namespace Snake
+{
+	/**
+	 * @class FrameJobs
+	 * @brief Runs the data parallel phases of a tick on a Snake::WorkerPool and measures how well they scale (`--parallel-phases`).
+	 *
+	 * @details
+	 * A tick is a fixed chain of phases, each one a barrier for the next. Moving the objects stays serial: there
+	 * are a handful of them, and later ones overwrite earlier ones in the screen buffer. The collision phase
+	 * checks every pair in parallel chunks of cells and reduces the hits in pair order, and the frame is
+	 * encoded in parallel bands of rows that are joined in row order. Every phase produces exactly
+	 * what its serial version does, so replays, checksums and terminal output do not depend on the thread count.
+	 *
+	 * For each phase the time every thread spent in its chunks is summed; divided by the wall time of the
+	 * phase it gives the speedup over running the same chunks on one thread.
+	 */
+	class FrameJobs
+	{
+		public:
+			enum class Phase
+			{
+				Collide,
+				Encode,
+				Count
+			};
+
+			/**
+			 * @param threads Threads including the caller, 0 uses all cores
+			 */
+			explicit FrameJobs(unsigned int threads);
+
+			/** @brief Threads taking part in a phase, including the caller */
+			unsigned int threads() const noexcept;
+
+			/**
+			 * @brief `WorkerPool::parallelFor`, timed as part of `phase`
+			 */
+			template <typename Fn>
+			void parallelFor(Phase phase, size_t count, size_t grain, Fn&& fn)
+			{
+				const auto start = std::chrono::steady_clock::now();
+
+				m_pool.parallelFor(count, grain, [&](size_t begin, size_t end)
+				{
+					const auto chunkStart = std::chrono::steady_clock::now();
+
+					fn(begin, end);
+
+					m_work[WorkerPool::s_ThreadIndex()].time += std::chrono::steady_clock::now() - chunkStart;
+				});
+
+				record(phase, std::chrono::steady_clock::now() - start);
+			}
+
+			/**
+			 * @brief Scratch strings reused between calls, e.g. one per band of encoded rows
+			 * @param count Strings needed; each one is cleared
+			 */
+			std::vector<std::string>& strings(size_t count);
+
+			/**
+			 * @brief Runs, wall time, summed thread time and speedup of each phase; empty if none ran in parallel
+			 */
+			std::string report() const;
+
+			static const char* s_Name(Phase phase) noexcept;
+
+		private:
+			struct Stats
+			{
+				uint64_t runs = 0;
+				std::chrono::nanoseconds wall{ 0 };
+				std::chrono::nanoseconds work{ 0 };
+			};
+
+			/** @brief Time a thread spent in chunks of the running phase; only that thread writes its slot */
+			struct alignas(64) ThreadWork
+			{
+				std::chrono::nanoseconds time{ 0 };
+			};
+
+			WorkerPool m_pool;
+			std::unique_ptr<ThreadWork[]> m_work;
+			std::array<Stats, static_cast<size_t>(Phase::Count)> m_stats{};
+			std::vector<std::string> m_strings;
+
+			/** @brief Adds a finished phase; the pool has joined every thread, so their slots can be read */
+			void record(Phase phase, std::chrono::nanoseconds wall) noexcept;
+	};
+};
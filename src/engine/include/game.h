@@ -2,11 +2,25 @@
 
 #include <chrono>
 #include <memory>
+#include <optional>
 #include <utility>
 
+#include "controller.h"
+#include "framejobs.h"
+#include "hud.h"
 #include "input.h"
+#include "level.h"
+#include "options.h"
+#include "profile.h"
+#include "recording.h"
+#include "random.h"
+#include "replay.h"
 #include "screen.h"
+#include "sharedframe.h"
+#include "snapshot.h"
+#include "spectator.h"
 #include "terminal.h"
+#include "timerwheel.h"
 #include "objects.h"
 
 /**
@@ -28,13 +42,16 @@ namespace Snake
 		public:
 			/**
 			 * @brief Construct a new Game object
+			 * @param options Snake::Options parsed from the command line
 			 *
 			 * Initializes terminal, screen buffer, game objects, and logger.
 			 */
-			explicit Game();
+			explicit Game(Options const& options = Options());
 
 			/**
-			 * @brief Default destructor
+			 * @brief Destructor
+			 *
+			 * Stops the asynchronous logger so queued records reach the log file.
 			 */
 			~Game();
 
@@ -43,14 +60,169 @@ namespace Snake
 			 */
 			void run();
 
+			/**
+			 * @brief Report to print on exit: startup phases if `--startup-profile` was given, memory if `--memory-report` was,
+			 *        replay verification result if `--replay` was
+			 * @return std::string Report, empty if there is nothing to report
+			 *
+			 * Meant to be printed after the game is destroyed, once the terminal is restored.
+			 */
+			std::string exitReport() const;
+
+			/**
+			 * @brief Whether a replay played back with `--replay` diverged from its recorded checksums
+			 */
+			bool replayDiverged() const noexcept;
+
+			/**
+			 * @brief Memory currently held per subsystem
+			 * @return Snake::MemoryReport Counted by walking the buffer, the objects and the history, so it is always current
+			 */
+			MemoryReport memoryReport() const;
+
+			/**
+			 * @brief Checksum of the simulation state: frame count, snake cells, food position and random generator state
+			 * @return uint32_t FNV-1a hash of the state
+			 *
+			 * Recorded in replays every `s_ReplayChecksumInterval` ticks to detect divergence on playback.
+			 */
+			uint32_t stateChecksum() const noexcept;
+
+			/**
+			 * @brief Captures the full simulation state
+			 * @param out Receives the state; reusing the same snapshot avoids allocating
+			 */
+			void snapshot(GameSnapshot& out) const;
+
+			/**
+			 * @brief Puts the simulation back into a captured state
+			 * @param in State captured by `Game::snapshot` on a board of the same size
+			 *
+			 * Rebuilds the screen buffer, and clears the terminal so the next render repaints everything.
+			 */
+			void restore(GameSnapshot const& in);
+
+			/**
+			 * @brief Game area width
+			 */
+			unsigned int width() const noexcept;
+
+			/**
+			 * @brief Game area height
+			 */
+			unsigned int height() const noexcept;
+
+			/**
+			 * @brief Ticks simulated since the run started, across restarts in headless mode
+			 */
+			uint64_t ticksElapsed() const noexcept;
+
+			/**
+			 * @brief The player's snake
+			 */
+			Snake const& snake() const noexcept;
+
+			/**
+			 * @brief The current food, or nullptr if none is on the board
+			 */
+			Food const* food() const noexcept;
+
+			/**
+			 * @brief The screen buffer holding every object on the board
+			 */
+			ScreenBuffer const& buffer() const noexcept;
+
+			/**
+			 * @brief The obstacles of the level given with `--level`, or nullptr without one
+			 */
+			Obstacles const* obstacles() const noexcept;
+
+			/**
+			 * @brief Generates all unique pairs of game objects for collision detection
+			 * @callgraph
+			 * @param objs Vector of Snake::BaseObject pointers
+			 * @return ObjectPairs Vector of unique object pairs
+			 *
+			 * Also adds self-collision pairs for objects that can collide with themselves (e.g., Snake).
+			 * Leaves out pairs of two static objects and pairs whose Snake::CollisionLayer masks exclude each other.
+			 */
+			static ObjectPairs s_GenerateUniquePairs(std::vector<BaseObject*> const &objs);
+
+			/**
+			 * @brief Checks for collisions among object pairs and self-collisions
+			 * @callgraph
+			 * @param pairs Snake::ObjectPairs Vector of unique object pairs
+			 * @return Snake::CollisionResult Result of the first detected collision, or Snake::CollisionResult::NONE if no collisions
+			 */
+			static CollisionResult s_CheckCollisions(ObjectPairs const &pairs);
+
+			/**
+			 * @brief Like `Game::s_CheckCollisions`, with every pair split into chunks of cells checked in parallel
+			 * @param pairs Snake::ObjectPairs Vector of unique object pairs
+			 * @param jobs Threads to check on
+			 * @return Snake::CollisionResult Same result as `Game::s_CheckCollisions`: that of the first pair, in order, whose cells overlap
+			 *
+			 * A pair's result only depends on its two objects, not on where they overlap, so chunks just flag their pair
+			 * and the flags are reduced in pair order afterwards.
+			 */
+			static CollisionResult s_CheckCollisions(ObjectPairs const &pairs, FrameJobs& jobs);
+
+			/** @brief Cells per chunk of `Game::s_CheckCollisions` on Snake::FrameJobs */
+			static constexpr size_t s_CollisionChunk = 2048;
+
+			/**
+			 * @brief Checks for self-collisions of a single object
+			 * @callgraph
+			 * @param obj Snake::BaseObject Pointer to the game object to check
+			 * @return Snake::CollisionResult Result of the self-collision, or Snake::CollisionResult::NONE if no collision
+			 *
+			 * Self collision is based on the detector cells of the object
+			 */
+			static CollisionResult s_CheckSelfCollisions(BaseObject* const &obj);
+
+			/**
+			 * @brief Picks a random empty position inside the border
+			 * @param buffer Screen buffer to search; must have at least one empty inner cell
+			 * @param rng Generator, advanced by two draws per attempt
+			 * @return Position Empty position
+			 *
+			 * Rejection sampling, so the expected number of attempts grows with how full the board is.
+			 */
+			static Position s_RandomEmptyPosition(ScreenBuffer const& buffer, Rng& rng);
+
 		private:
 			/**
-			 * @brief Game area width resolved by `Snake::Terminal`
+			 * @brief Options the game was started with
+			 */
+			Options m_options;
+
+			/**
+			 * @brief Startup phase timings; declared first so it starts before the terminal is set up
+			 */
+			StartupProfile m_startupProfile;
+
+			/**
+			 * @brief `Snake::Terminal` instance, nullptr in headless mode
+			 */
+			std::unique_ptr<Terminal> m_terminal;
+
+			/**
+			 * @brief Replay being played back, nullptr unless `--replay` was given; its header decides the board size
+			 */
+			std::unique_ptr<ReplayReader> m_replayFile;
+
+			/**
+			 * @brief Level loaded with `--level`, nullptr without one; decides the board size unless a replay does
+			 */
+			std::unique_ptr<Level> m_level;
+
+			/**
+			 * @brief Game area width resolved by `Snake::Terminal` (or `Options::width` in headless mode, or the level, or the replay header)
 			*/
 			unsigned int m_width;
 
 			/**
-			 * @brief Game area height resolved by `Snake::Terminal`
+			 * @brief Game area height resolved by `Snake::Terminal` (or `Options::height` in headless mode, or the level, or the replay header)
 			*/
 			unsigned int m_height;
 
@@ -62,31 +234,70 @@ namespace Snake
 			Input::KeyKind m_pendingInput = Input::KeyKind::None; // Store latest key
 
 			/**
-			 * @brief `Snake::Terminal` instance
+			 * @brief `Snake::ScreenBuffer` instance
 			 */
-			Terminal m_terminal;
+			ScreenBuffer m_buffer;
 
 			/**
-			 * @brief `Snake::ScreenBuffer` instance
+			 * @brief Collision pairs of the objects in `m_buffer`, rebuilt only when its objects version changes
 			 */
-			ScreenBuffer m_buffer;
+			ObjectPairs m_pairs;
+
+			/** @brief `ScreenBuffer::getObjectsVersion` that `m_pairs` was built for */
+			uint64_t m_pairsVersion = UINT64_MAX;
 
 			/**
-			 * @brief Target frame time in milliseconds (250ms = 4 FPS)
+			 * @brief Time between two ticks, from `Options::tickRate` (default 250ms = 4 ticks per second)
 			 *
-			 * Lower values will make the game more difficult but suitable for big terminal windows.
+			 * Shorter ticks make the game more difficult but suit big terminal windows.
 			 *
-			 * Higher values will make the game easier but suitable for small terminal windows.
+			 * Longer ticks make the game easier but suit small terminal windows.
 			 */
-			static constexpr unsigned int s_FrameTimeMs = 250;
+			std::chrono::nanoseconds m_tickPeriod;
 
 			/**
-			 * @brief Time point of the last rendered frame
+			 * @brief Shortest time between two rendered frames, from `Options::fps`
+			 */
+			std::chrono::nanoseconds m_framePeriod;
+
+			/**
+			 * @brief When the next tick is due
 			 *
-			 * Used to calculate delta time for frame rate control.
+			 * Advanced by `m_tickPeriod` per tick rather than set from the clock, so the tick rate does not drift.
+			 */
+			std::chrono::steady_clock::time_point m_nextTick;
+
+			/**
+			 * @brief Time point of the last rendered frame
 			 */
 			std::chrono::steady_clock::time_point m_lastFrameTime;
 
+			/**
+			 * @brief How far behind schedule the simulation may fall before the missed ticks are dropped instead of caught up
+			 */
+			static constexpr std::chrono::milliseconds s_MaxTickLag{ 250 };
+
+			/**
+			 * @brief Positions vacated by the ticks since the last rendered frame, already cleared from `m_buffer`
+			 */
+			PosVector m_vacated;
+
+			/** @brief Ticks simulated since the last rendered frame */
+			unsigned int m_ticksSinceFrame = 0;
+
+			/** @brief Frames rendered in interactive mode */
+			uint64_t m_framesRendered = 0;
+
+			/**
+			 * @brief Threads for the collision and encoding phases, nullptr unless `--parallel-phases` was given
+			 */
+			std::unique_ptr<FrameJobs> m_jobs;
+
+			/**
+			 * @brief Performance HUD on the status row, nullptr unless `--hud` was given
+			 */
+			std::unique_ptr<PerformanceHud> m_hud;
+
 			/**
 			 * @brief Number of frames elapsed since game start
 			 *
@@ -94,25 +305,233 @@ namespace Snake
 			 */
 			unsigned int m_FramesElapsed = 0;
 
+			/**
+			 * @brief Ticks simulated since the run started; unlike `m_FramesElapsed` it survives restarts
+			 */
+			uint64_t m_ticksElapsed = 0;
+
+			/**
+			 * @brief Games started in this run (headless mode restarts after game over)
+			 */
+			uint64_t m_gamesPlayed = 1;
+
+			/**
+			 * @brief Set when the last tick ended in Snake::CollisionResult::GAME_OVER
+			 */
+			bool m_gameOver = false;
+
+			/**
+			 * @brief Input source replacing the keyboard, if any
+			 */
+			std::unique_ptr<Controller> m_controller;
+
+			/**
+			 * @brief `m_controller` when it plays back a replay, used to verify checksums
+			 */
+			ReplayController* m_replay = nullptr;
+
+			/**
+			 * @brief Tick at which the replay diverged from its recorded checksums, if it did
+			 */
+			std::optional<uint64_t> m_replayDivergedAt;
+
+			/**
+			 * @brief Checksum computed at `m_replayDivergedAt`
+			 */
+			uint32_t m_replayActualChecksum = 0;
+
+			/**
+			 * @brief Why the replay diverged when its checksums matched but the game did not end the way the recording did
+			 */
+			const char* m_replayEndMismatch = nullptr;
+
+			/**
+			 * @brief Records inputs to a replay file, nullptr unless `--record-replay` was given
+			 */
+			std::unique_ptr<ReplayWriter> m_recorder;
+
+			/**
+			 * @brief Records rendered frames, nullptr unless `--record-frames` was given
+			 */
+			std::unique_ptr<FrameRecorder> m_frameRecorder;
+
+			/**
+			 * @brief Broadcasts rendered frames, nullptr unless `--serve` was given
+			 */
+			std::unique_ptr<SpectatorServer> m_spectators;
+
+			/**
+			 * @brief Exports rendered frames to shared memory, nullptr unless `--shm` was given
+			 */
+			std::unique_ptr<SharedFrameWriter> m_sharedFrames;
+
+			/**
+			 * @brief Ticks between state checksums in recorded replays
+			 */
+			static constexpr unsigned int s_ReplayChecksumInterval = 64;
+
+			/**
+			 * @brief Snapshots of the last `s_RewindSeconds`, nullptr unless `--casual` was given
+			 */
+			std::unique_ptr<RewindBuffer> m_rewind;
+
+			/** @brief Scratch snapshot reused every tick */
+			GameSnapshot m_snapshot;
+
+			/** @brief Scratch positions reused by `Game::restore` */
+			PosVector m_restorePositions;
+
+			/**
+			 * @brief Set after a death was undone; the game waits for an arrow key before moving again
+			 */
+			bool m_awaitingInput = false;
+
+			/**
+			 * @brief Paused with `p` or Space, or because the terminal lost focus: nothing ticks, renders or animates until resumed
+			 */
+			bool m_paused = false;
+
+			/** @brief The pause came from a focus loss, so regaining focus ends it */
+			bool m_pausedByFocus = false;
+
+			/** @brief Seconds of history kept for rewinding in casual mode */
+			static constexpr unsigned int s_RewindSeconds = 10;
+
+			/** @brief Time a death rewinds in casual mode */
+			static constexpr unsigned int s_UndoMs = 2000;
+
+			/**
+			 * @brief Seed of `m_rng`, from the replay header, `--seed` or `std::random_device`
+			 */
+			uint64_t m_seed;
+
+			/**
+			 * @brief Food placement generator; seeded so games can be replayed exactly
+			 */
+			Rng m_rng;
+
 			/**
 			 * @brief Frequency of food appearance
 			 *
-			 * Used to calculate when to spawn food based on `m_FramesElapsed` ( every `s_FoodFreq` frames ).
+			 * Food spawns in the first update on a nonzero multiple of `s_FoodFreq` frames while there is none, see `scheduleFood`.
 			 */
 			static constexpr unsigned int s_FoodFreq = 5; // frames
 
+			/**
+			 * @brief Timed game events, advanced at the start of every `update`
+			 */
+			TimerWheel m_timers;
+
+			/**
+			 * @brief Spawns the next food when it is due; done while food is on the board
+			 */
+			TimerWheel::Script m_foodSpawn;
+
 			std::unique_ptr<Border> m_border;
+			std::unique_ptr<Obstacles> m_obstacles;
 			std::unique_ptr<Snake> m_snake;
 			std::unique_ptr<Food> m_food;
 
+			/** @brief Length of the snake when it spawned; what it grew since is the score */
+			std::size_t m_spawnLength = 0;
+
 			/**
 			 * @brief Initializes the logging system using `Boost::log`
 			 * @throws std::runtime_error if `logging.ini` cannot be opened
 			 *
-			 * Tries to open `logging.ini` in the executable directory for configuration.
+			 * Tries to open `logging.ini` in the executable directory for configuration,
+			 * then starts the background writer of `Snake::Log`.
 			 */
 			void initLogger();
 
+			/**
+			 * @brief Runs the interactive loop: keyboard input, fixed frame rate, rendering
+			 *
+			 * While paused or waiting for an arrow key after an undone death, it blocks in `Input::waitForInput`
+			 * instead of polling, so an idle game uses no CPU.
+			 */
+			void runInteractive();
+
+			/**
+			 * @brief Simulates one tick of the interactive game and keeps what it vacated for the next frame
+			 */
+			void simulate();
+
+			/**
+			 * @brief Draws the ticks simulated since the last frame and animates the border, in interactive mode
+			 *
+			 * Called at most every `m_framePeriod`, so the terminal output is bounded by the frame cap whatever the tick rate.
+			 */
+			void present();
+
+			/**
+			 * @brief Shows the HUD line on the status row if `PerformanceHud::line` has a new one
+			 */
+			void updateHud(std::chrono::steady_clock::time_point now);
+
+			/**
+			 * @brief Pauses or resumes the interactive game and says so on the row below the board
+			 * @param paused Whether to pause
+			 * @param byFocus The pause is caused by the terminal losing focus and ends when it comes back
+			 */
+			void setPaused(bool paused, bool byFocus = false);
+
+			/**
+			 * @brief Runs the simulation as fast as possible without a terminal and reports ticks per second
+			 *
+			 * Game over starts a new game so long soak runs are not cut short.
+			 */
+			void runHeadless();
+
+			/**
+			 * @brief Simulates one tick: input, movement, collisions and screen buffer update
+			 * @callgraph
+			 *
+			 * Shared by the interactive and headless loops; does not render.
+			 */
+			void tick();
+
+			/**
+			 * @brief Hands the rendered frame to the recorder, the spectators and the shared memory export, whichever are enabled
+			 * @param vacated Cells vacated since the previous frame
+			 */
+			void publishFrame(PosVector const& vacated);
+
+			/**
+			 * @brief Appends the tick to the flight recorder, and dumps it if the tick ended an interactive game
+			 * @param tick Tick just simulated
+			 * @param applied Key the tick applied
+			 * @param collision Result of its collision check
+			 * @param start When the tick started
+			 * @param decided When the controller had picked the key
+			 * @param updated When the snake had moved
+			 * @param collided When collisions had been handled
+			 */
+			void recordFlight(uint64_t tick, Input::KeyKind applied, CollisionResult collision, std::chrono::steady_clock::time_point start,
+				std::chrono::steady_clock::time_point decided, std::chrono::steady_clock::time_point updated, std::chrono::steady_clock::time_point collided);
+
+			/**
+			 * @brief Replaces the snake and food with a fresh game on the same board
+			 */
+			void restart();
+
+			/**
+			 * @brief Logs a one line `Game::memoryReport` and the snake length
+			 * @param reason What triggered the report, e.g. "game over"
+			 */
+			void logMemoryReport(const char* reason) const;
+
+			/**
+			 * @brief Creates the snake of a new game: in the middle of the board, or at the level's spawn points in turn
+			 */
+			void spawnSnake();
+
+			/**
+			 * @brief Casual mode: rewinds `s_UndoMs` worth of ticks instead of ending the game
+			 * @return false if there is no history to rewind to
+			 */
+			bool undoDeath();
+
 			/**
 			 * @brief Updates game state for the current frame
 			 * @callgraph
@@ -138,32 +557,15 @@ namespace Snake
 			void removeFood();
 
 			/**
-			 * @brief Generates all unique pairs of game objects for collision detection
-			 * @callgraph
-			 * @param objs Vector of Snake::BaseObject pointers
-			 * @return ObjectPairs Vector of unique object pairs
-			 *
-			 * Also adds self-collision pairs for objects that can collide with themselves (e.g., Snake).
+			 * @brief Schedules the next food spawn, replacing a pending one
+			 * @param nextFrame `m_FramesElapsed` of the next `update`
 			 */
-			static ObjectPairs s_GenerateUniquePairs(std::vector<BaseObject*> const &objs);
+			void scheduleFood(unsigned int nextFrame);
 
 			/**
-			 * @brief Checks for collisions among object pairs and self-collisions
-			 * @callgraph
-			 * @param pairs Snake::ObjectPairs Vector of unique object pairs
-			 * @return Snake::CollisionResult Result of the first detected collision, or Snake::CollisionResult::NONE if no collisions
+			 * @brief Waits for `ticks` updates, then inserts food
 			 */
-			static CollisionResult s_CheckCollisions(ObjectPairs const &pairs);
-
-			/**
-			 * @brief Checks for self-collisions of a single object
-			 * @callgraph
-			 * @param obj Snake::BaseObject Pointer to the game object to check
-			 * @return Snake::CollisionResult Result of the self-collision, or Snake::CollisionResult::NONE if no collision
-			 *
-			 * Self collision is based on the detector cells of the object
-			 */
-			static CollisionResult s_CheckSelfCollisions(BaseObject* const &obj);
+			TimerWheel::Script spawnFood(uint64_t ticks);
 
 			/**
 			 * @brief Handles the result of a collision
@@ -172,7 +574,7 @@ namespace Snake
 			 *
 			 * For example, if food is eaten, grow the snake and remove the food.
 			 *
-			 * If game over, set exit request flag.
+			 * If game over, set `m_gameOver` and, unless headless, the exit request flag.
 			 */
 			void handleCollisionResult(CollisionResult result);
 
@@ -30,5 +30,7 @@ namespace Snake
 		constexpr uint32_t SNAKE_TAIL_RIGHT = 0x25B7; // ▷
 		// FOOD
 		constexpr uint32_t FOOD = 0x25CE; // ◎
+		// LEVEL
+		constexpr uint32_t OBSTACLE = 0x2593; // ▓
 	};
 };
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace Snake
+{
+	/**
+	 * @class PerformanceHud
+	 * @brief Collects tick time, frame size, frame rate and input latency for the status row (`--hud`).
+	 *
+	 * @details
+	 * Samples are summed over a window of `s_RefreshInterval`; `PerformanceHud::line` then averages them into one line
+	 * and returns it only if it differs from the one shown, so a steady game writes nothing and a busy one
+	 * at most a line per interval.
+	 *
+	 * Input latency is the time from a key arriving to the frame showing the tick that applied it being handed to
+	 * the terminal writer; the window shows the worst one.
+	 */
+	class PerformanceHud
+	{
+		public:
+			/**
+			 * @param targetFps Frames per second the game tries to draw
+			 */
+			explicit PerformanceHud(unsigned int targetFps);
+
+			/**
+			 * @brief Adds a simulated tick
+			 * @param took Time `Game::tick` took
+			 */
+			void tick(std::chrono::nanoseconds took) noexcept;
+
+			/**
+			 * @brief A key arrived; the first one since the last measured frame starts a latency measurement
+			 */
+			void keyArrived(std::chrono::steady_clock::time_point at) noexcept;
+
+			/**
+			 * @brief A tick applied the input, so the next frame shows it
+			 */
+			void inputApplied() noexcept;
+
+			/**
+			 * @brief Adds a drawn frame
+			 * @param bytes Encoded size of the frame
+			 * @param at When the frame was handed to the terminal writer
+			 */
+			void frame(std::size_t bytes, std::chrono::steady_clock::time_point at) noexcept;
+
+			/**
+			 * @brief Closes the window once `s_RefreshInterval` has passed
+			 * @param now Current time
+			 * @param length Snake length
+			 * @param score Food eaten this game
+			 * @return The new line, or nothing if the window is still open or the line did not change
+			 */
+			std::optional<std::string> line(std::chrono::steady_clock::time_point now, std::size_t length, uint64_t score);
+
+			/**
+			 * @brief Forgets the line shown, e.g. after something else used the row, and restarts the window
+			 * @param now Current time
+			 */
+			void reset(std::chrono::steady_clock::time_point now) noexcept;
+
+			/** @brief Shortest time between two HUD updates */
+			static constexpr std::chrono::milliseconds s_RefreshInterval{ 500 };
+
+		private:
+			unsigned int m_targetFps;
+
+			std::chrono::steady_clock::time_point m_windowStart;
+			uint64_t m_ticks = 0;
+			std::chrono::nanoseconds m_tickTime{ 0 };
+			uint64_t m_frames = 0;
+			std::size_t m_frameBytes = 0;
+
+			/** @brief Worst input latency of the window, if any input was shown */
+			std::optional<std::chrono::nanoseconds> m_latency;
+
+			/** @brief Arrival of the oldest key not yet shown */
+			std::optional<std::chrono::steady_clock::time_point> m_keyAt;
+			bool m_keyApplied = false;
+
+			/** @brief Line currently on screen */
+			std::string m_shown;
+
+			void startWindow(std::chrono::steady_clock::time_point now) noexcept;
+	};
+};
@@ -1,7 +1,8 @@
 #pragma once
 
-#include <cstdint>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 
 namespace Snake
 {
@@ -28,7 +29,8 @@ namespace Snake
 		 * @brief Signal handler for graceful termination on SIGINT
 		 * @param signal Signal number received
 		 *
-		 * Sets the exit request flag when SIGINT is received. Only works on Unix-like systems.
+		 * Sets the exit request flag when SIGINT is received, and the memory report request flag on SIGUSR1.
+		 * Only works on Unix-like systems.
 		 */
 		void signalHandler(int signal);
 
@@ -39,6 +41,13 @@ namespace Snake
 		 */
 		extern std::atomic<bool> g_exitRequested;
 
+		/**
+		 * @brief Global flag asking the game to log its memory report, see Snake::Game::memoryReport
+		 *
+		 * Set to true when SIGUSR1 is received; cleared by the game once the report is logged.
+		 */
+		extern std::atomic<bool> g_memoryReportRequested;
+
 		enum class KeyKind : uint8_t
 		{
 			None = 0,
@@ -49,6 +58,8 @@ namespace Snake
 			ArrowDown = 5,
 			ArrowLeft = 6,
 			ArrowRight = 7,
+			FocusIn = 8,  // terminal window gained focus, see TSEQ::ENABLE_FOCUS_REPORTING
+			FocusOut = 9, // terminal window lost focus
 			// add more as needed: Home, End, F1…F12, etc.
 		};
 
@@ -59,5 +70,18 @@ namespace Snake
 		};
 
 		KeyEvent readKey();
+
+		/**
+		 * @brief Blocks until stdin has input to read or a signal arrives
+		 *
+		 * Sleeps in the kernel with no timeout, so a waiting process uses no CPU and is never woken for nothing.
+		 */
+		void waitForInput();
+
+		/**
+		 * @brief Like `waitForInput()`, but gives up after `timeout`
+		 * @param timeout Longest wait, rounded up to whole milliseconds; zero or negative returns at once
+		 */
+		void waitForInput(std::chrono::nanoseconds timeout);
 	}
 };
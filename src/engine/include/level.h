@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <span>
+
+#include "mappedfile.h"
+#include "objects.h"
+#include "options.h"
+#include "screen.h"
+
+namespace Snake
+{
+	/**
+	 * @namespace Snake::LevelFormat
+	 * @brief Layout of level files, used in place without parsing.
+	 *
+	 * @details
+	 * - Header: a Snake::LevelFormat::Header
+	 * - Spawns: `spawnCount` Snake::LevelFormat::Spawn at `spawnsOffset`
+	 * - Runs: `runCount` Snake::LevelFormat::Run at `runsOffset`, sorted by row then column
+	 * - Bitmap: at `bitmapOffset`, `height` rows of `s_RowWords(width)` 64 bit words; bit `x % 64` of word `x / 64` is set for an obstacle
+	 *
+	 * Runs and bitmap describe the same obstacles: runs to draw them, the bitmap to look one up in O(1).
+	 * The outermost ring is the border and never holds obstacles. Sections start on 8 byte boundaries and
+	 * everything is little-endian, so a mapped file is read as is.
+	 */
+	namespace LevelFormat
+	{
+		constexpr char MAGIC[4] = { 'S', 'N', 'K', 'L' };
+		constexpr uint32_t VERSION = 1;
+
+		struct Header
+		{
+			char magic[4];
+			uint32_t version;
+			uint32_t width;
+			uint32_t height;
+			uint32_t spawnCount;
+			uint32_t reserved;
+			uint64_t runCount;
+			uint64_t obstacleCells;
+			uint64_t spawnsOffset;
+			uint64_t runsOffset;
+			uint64_t bitmapOffset;
+		};
+
+		/**
+		 * @brief Where a snake starts: head position and Snake::Snake::Direction; the body trails behind the head
+		 */
+		struct Spawn
+		{
+			uint32_t x;
+			uint32_t y;
+			uint32_t direction;
+		};
+
+		/**
+		 * @brief Horizontal run of obstacle cells
+		 */
+		struct Run
+		{
+			uint32_t y;
+			uint32_t x;
+			uint32_t length;
+		};
+
+		static_assert(sizeof(Header) == 64 && sizeof(Spawn) == 12 && sizeof(Run) == 12);
+
+		/** @brief Bitmap words per row */
+		constexpr uint64_t s_RowWords(uint32_t width) noexcept
+		{
+			return (uint64_t(width) + 63) / 64;
+		}
+
+		/** @brief Cells of a freshly spawned snake, as Snake::Snake starts */
+		constexpr unsigned int SPAWN_LENGTH = 5;
+
+		/**
+		 * @brief Position of a cell of a snake spawned at `spawn`
+		 * @param spawn Spawn point
+		 * @param i Cell index, 0 being the head; the body trails against the direction
+		 * @return Position Wraps around to a huge coordinate when it would be negative, so bounds checks catch it
+		 */
+		constexpr Position s_SpawnCell(Spawn const& spawn, unsigned int i) noexcept
+		{
+			switch (static_cast<::Snake::Snake::Direction>(spawn.direction))
+			{
+				case ::Snake::Snake::Direction::Up:
+					return { spawn.x, spawn.y + i };
+				case ::Snake::Snake::Direction::Down:
+					return { spawn.x, spawn.y - i };
+				case ::Snake::Snake::Direction::Right:
+					return { spawn.x - i, spawn.y };
+				default:
+					return { spawn.x + i, spawn.y };
+			}
+		}
+	};
+
+	/**
+	 * @class Level
+	 * @brief A level file mapped into memory.
+	 *
+	 * Loading checks the header and the section bounds only, so it takes the same time for any level size;
+	 * the pages of a big level are read as the game first touches them.
+	 */
+	class Level
+	{
+		public:
+			/**
+			 * @brief Maps a level file
+			 * @param path File written by `compileLevel`
+			 * @throws std::runtime_error if the file is not a level or its sections do not fit in it
+			 */
+			explicit Level(std::filesystem::path const& path);
+
+			unsigned int width() const noexcept;
+			unsigned int height() const noexcept;
+
+			/** @brief Number of obstacle cells */
+			uint64_t obstacleCells() const noexcept;
+
+			std::span<const LevelFormat::Spawn> spawns() const noexcept;
+			std::span<const LevelFormat::Run> runs() const noexcept;
+
+			/**
+			 * @brief Whether there is an obstacle at a position; false outside the board
+			 */
+			bool blocked(unsigned int x, unsigned int y) const noexcept
+			{
+				return x < m_width && y < m_height && (m_bitmap[y * m_rowWords + x / 64] >> (x % 64) & 1);
+			}
+
+		private:
+			MappedFile m_file;
+			unsigned int m_width = 0;
+			unsigned int m_height = 0;
+			uint64_t m_obstacleCells = 0;
+			uint64_t m_rowWords = 0;
+			std::span<const LevelFormat::Spawn> m_spawns;
+			std::span<const LevelFormat::Run> m_runs;
+			const uint64_t* m_bitmap = nullptr;
+	};
+
+	/**
+	 * @brief Compiles a text map into a level file
+	 * @param map One line per board row: `#` is an obstacle, `<`, `>`, `^` or `v` a spawn facing that way, anything else is free.
+	 *            The outermost ring is the border whatever it holds; short lines are padded with free cells.
+	 * @param path Destination file
+	 * @return Snake::LevelFormat::Header Header of the written file
+	 * @throws std::runtime_error if the map is smaller than Snake::Options allows, has no spawn, a spawn without
+	 *         room for the initial snake behind it, or the file cannot be written
+	 */
+	LevelFormat::Header compileLevel(std::istream& map, std::filesystem::path const& path);
+
+	/**
+	 * @brief Entry point of `--compile-level`: compiles the text map into the level file given by `--level`
+	 * @param options Parsed command line
+	 * @return int Process exit code
+	 */
+	int runCompileLevel(Options const& options);
+
+	/**
+	 * @class Obstacles
+	 * @brief The obstacles of a Snake::Level as one solid object.
+	 *
+	 * @details
+	 * Has no positioned cells: collisions ask `Obstacles::covers`, which reads the level's bitmap, and
+	 * `Obstacles::paint` points every obstacle square of the screen buffer at a single shared cell.
+	 * Neither costs memory per obstacle square.
+	 */
+	class Obstacles : public BaseObject
+	{
+		public:
+			/**
+			 * @param level Level to take the obstacles from; must outlive the object
+			 */
+			explicit Obstacles(Level const& level);
+
+			/**
+			 * @brief Same as Snake::Border: running into an obstacle ends the game
+			 */
+			CollisionResult getCollisionResult(BaseObject const& other) const override;
+
+			bool covers(unsigned int x, unsigned int y) const override;
+
+			/**
+			 * @brief Counts the shared obstacle cell; the level itself is mapped, not allocated
+			 */
+			void accountMemory(MemoryReport& report) const override;
+
+			/**
+			 * @brief Draws every obstacle into the buffer
+			 */
+			void paint(ScreenBuffer& buffer) const;
+
+			/**
+			 * @brief Draws the obstacle at a position back, if there is one, e.g. after a dead snake's head covered it
+			 */
+			void repaint(ScreenBuffer& buffer, Position position) const;
+
+			Level const& level() const noexcept;
+
+		private:
+			Level const& m_level;
+			CellPtr m_cell;
+	};
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+#include <boost/log/trivial.hpp>
+
+/**
+ * @brief Lowest severity compiled into the binary
+ *
+ * Log statements below this level are discarded at compile time by `SNAKE_LOG`.
+ * Set through the `SNAKE_LOG_MIN_SEVERITY` CMake cache variable.
+ */
+#ifndef SNAKE_LOG_MIN_SEVERITY
+#define SNAKE_LOG_MIN_SEVERITY ::boost::log::trivial::trace
+#endif
+
+/**
+ * @brief Logs a message asynchronously, e.g. `SNAKE_LOG(info) << "Snake grew";`
+ *
+ * Drop-in replacement for `BOOST_LOG_TRIVIAL` that never touches the sinks on the calling thread.
+ */
+#define SNAKE_LOG(severity)                                                        \
+	if constexpr (::boost::log::trivial::severity < SNAKE_LOG_MIN_SEVERITY) {}     \
+	else ::Snake::Log::Record(::boost::log::trivial::severity)
+
+namespace Snake
+{
+	/**
+	 * @namespace Snake::Log
+	 * @brief Asynchronous logging pipeline in front of `Boost::log`.
+	 *
+	 * Records are formatted into fixed size slots of a bounded lock-free queue and written
+	 * to the configured sinks by a background writer thread.
+	 */
+	namespace Log
+	{
+		/**
+		 * @brief Alias to `boost::log::trivial::severity_level`
+		 */
+		using Severity = boost::log::trivial::severity_level;
+
+		/**
+		 * @enum OverflowPolicy
+		 * @brief What a producer does when the queue is full.
+		 *
+		 * @details
+		 * - Drop: Discard the record and count it (never blocks the caller)
+		 * - Block: Wait until the writer frees a slot
+		 */
+		enum class OverflowPolicy : uint8_t
+		{
+			Drop,
+			Block
+		};
+
+		/**
+		 * @brief Maximum message length in bytes; longer messages are cut short and end in `TRUNCATION_MARKER`
+		 */
+		constexpr std::size_t MESSAGE_CAPACITY = 240;
+
+		/**
+		 * @brief Ends a message that did not fit in `MESSAGE_CAPACITY`, so a cut record is never mistaken for a whole one
+		 */
+		constexpr char TRUNCATION_MARKER[] = " [truncated]";
+
+		/**
+		 * @brief Number of slots in the queue (must be a power of two)
+		 */
+		constexpr std::size_t QUEUE_CAPACITY = 1024;
+
+		/**
+		 * @brief Starts the writer thread, which then configures `Boost::log` from the given ini text
+		 * @param config Contents of `logging.ini`
+		 * @param policy Snake::Log::OverflowPolicy used when the queue is full
+		 *
+		 * Parsing the configuration happens on the writer thread so it stays off the startup path;
+		 * records logged meanwhile wait in the queue.
+		 */
+		void start(std::string config, OverflowPolicy policy = OverflowPolicy::Drop);
+
+		/**
+		 * @brief Drains pending records, flushes the sinks and joins the writer thread
+		 *
+		 * Safe to call multiple times. Records logged afterwards are written synchronously.
+		 */
+		void stop();
+
+		/**
+		 * @brief Number of records discarded because the queue was full
+		 */
+		uint64_t droppedCount() noexcept;
+
+		/**
+		 * @brief Bytes of the record queue and writer, which live in static storage
+		 *
+		 * Memory of the `Boost::log` sinks is not included.
+		 */
+		std::size_t memoryBytes() noexcept;
+
+		/**
+		 * @brief A single log statement being built on the caller's stack
+		 *
+		 * The message is formatted into a fixed buffer (no heap allocation) and enqueued on destruction.
+		 */
+		class Record
+		{
+			public:
+				/**
+				 * @brief Starts a record with the given severity
+				 * @param severity Snake::Log::Severity of the record
+				 */
+				explicit Record(Severity severity) noexcept;
+
+				Record(Record const&) = delete;
+				Record& operator=(Record const&) = delete;
+
+				/**
+				 * @brief Enqueues the formatted message
+				 */
+				~Record();
+
+				/**
+				 * @brief Appends a value to the message using its stream operator
+				 */
+				template <typename T>
+				Record& operator<<(T const& value)
+				{
+					m_stream << value;
+
+					return *this;
+				}
+
+			private:
+				/**
+				 * @brief Stream buffer writing into a fixed array; the room for `TRUNCATION_MARKER` is kept free
+				 * until a write does not fit, which appends the marker and fails the stream
+				 */
+				class FixedBuffer : public std::streambuf
+				{
+					public:
+						FixedBuffer() noexcept;
+						const char* data() const noexcept;
+						std::size_t size() const noexcept;
+
+					protected:
+						int_type overflow(int_type ch) override;
+
+					private:
+						char m_data[MESSAGE_CAPACITY];
+						bool m_truncated = false;
+				};
+
+				Severity m_severity;
+				FixedBuffer m_buffer;
+				std::ostream m_stream;
+		};
+	};
+};
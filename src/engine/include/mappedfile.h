@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace Snake
+{
+	/**
+	 * @class MappedFile
+	 * @brief Read only view of a whole file, memory mapped where the platform allows it.
+	 *
+	 * Windows falls back to reading the file into memory.
+	 */
+	class MappedFile
+	{
+		public:
+			/**
+			 * @brief Maps the file
+			 * @param path File to map
+			 * @throws std::runtime_error if the file cannot be opened, is empty or cannot be mapped
+			 */
+			explicit MappedFile(std::filesystem::path const& path);
+
+			/**
+			 * @brief Unmaps the file
+			 */
+			~MappedFile();
+
+			MappedFile(MappedFile const&) = delete;
+			MappedFile& operator=(MappedFile const&) = delete;
+
+			const uint8_t* data() const noexcept;
+			size_t size() const noexcept;
+
+		private:
+			const uint8_t* m_data = nullptr;
+			size_t m_size = 0;
+
+			/** @brief File contents when memory mapping is not available */
+			std::vector<uint8_t> m_fallback;
+	};
+};
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "controller.h"
+#include "options.h"
+#include "snapshot.h"
+#include "workers.h"
+
+namespace Snake
+{
+	class Obstacles;
+
+	/**
+	 * @class PlayoutBoard
+	 * @brief Flat copy of one game for search: an occupancy board and a ring buffer of snake cells.
+	 *
+	 * @details
+	 * Follows the rules of Snake::Game exactly (see Snake::BatchEnv for the same rules in batch form),
+	 * including food placement from the game's own random generator state, so a line of moves played
+	 * here ends where the real game would.
+	 *
+	 * Every `PlayoutBoard::step` pushes what it overwrote on an undo log, and `PlayoutBoard::undo` reverts
+	 * it, so a search walks down and back up from one copy of the root instead of copying the board for
+	 * every playout. A step that kills the snake leaves the board in its dying state; only `undo` may follow.
+	 */
+	class PlayoutBoard
+	{
+		public:
+			/**
+			 * @brief Result of `PlayoutBoard::step`
+			 */
+			enum Outcome : uint8_t
+			{
+				MOVED,
+				ATE,
+				HIT_WALL,
+				HIT_SELF
+			};
+
+			/** @brief Board value of border and obstacle cells */
+			static constexpr uint8_t WALL = 0xFF;
+
+			/** @brief Food cell meaning there is no food on the board */
+			static constexpr uint32_t NO_FOOD = UINT32_MAX;
+
+			/**
+			 * @brief Loads the state captured by `Snake::Game::snapshot`
+			 * @param snapshot Game snapshot
+			 * @param width Board width including the border
+			 * @param height Board height including the border
+			 * @param obstacles Level obstacles, walls like the border; nullptr without a level
+			 */
+			void load(GameSnapshot const& snapshot, unsigned int width, unsigned int height, Obstacles const* obstacles = nullptr);
+
+			/**
+			 * @brief Plays one tick
+			 * @param direction Snake::Snake::Direction as an integer; the reverse of the current direction is ignored
+			 */
+			Outcome step(unsigned int direction) noexcept;
+
+			/**
+			 * @brief Reverts the most recent step not reverted yet
+			 */
+			void undo() noexcept;
+
+			/** @brief Steps that can still be undone */
+			size_t depth() const noexcept
+			{
+				return m_undo.size();
+			}
+
+			/** @brief Board width including the border */
+			unsigned int width() const noexcept
+			{
+				return m_width;
+			}
+
+			/** @brief Board height including the border */
+			unsigned int height() const noexcept
+			{
+				return m_height;
+			}
+
+			/** @brief Cell index (`y * width + x`) of the head */
+			uint32_t head() const noexcept
+			{
+				return m_body[m_headSlot];
+			}
+
+			/** @brief Cell index of the tail */
+			uint32_t tail() const noexcept
+			{
+				return m_body[(m_headSlot + m_length - 1) % m_capacity];
+			}
+
+			/** @brief Food cell, or `NO_FOOD` */
+			uint32_t food() const noexcept
+			{
+				return m_food;
+			}
+
+			/** @brief Current direction as a Snake::Snake::Direction integer */
+			unsigned int direction() const noexcept
+			{
+				return m_direction;
+			}
+
+			/** @brief Snake length in cells */
+			uint32_t length() const noexcept
+			{
+				return m_length;
+			}
+
+			/** @brief 0 for a free cell, `WALL` for the border and obstacles, otherwise the number of snake segments on it */
+			uint8_t cell(uint32_t index) const noexcept
+			{
+				return m_board[index];
+			}
+
+			/** @brief Offset of the neighbouring cell in a direction */
+			int32_t offset(unsigned int direction) const noexcept
+			{
+				return m_offsets[direction];
+			}
+
+		private:
+			struct Undo
+			{
+				uint64_t rng;
+				uint32_t food;
+				uint32_t tail;
+				uint32_t frames;
+				uint8_t direction;
+				Outcome outcome;
+			};
+
+			unsigned int m_width = 0;
+			unsigned int m_height = 0;
+
+			/** @brief Ring buffer capacity: every interior cell plus a duplicated tail */
+			uint32_t m_capacity = 0;
+
+			int32_t m_offsets[4] = {};
+
+			/** @brief Level obstacles the walls were built with */
+			Obstacles const* m_obstacles = nullptr;
+
+			/** @brief Cells that are not walls */
+			uint32_t m_freeCells = 0;
+
+			std::vector<uint8_t> m_board;
+			std::vector<uint32_t> m_body;
+			uint32_t m_headSlot = 0;
+			uint32_t m_length = 0;
+			uint8_t m_direction = 0;
+			uint32_t m_food = NO_FOOD;
+			uint32_t m_frames = 0;
+			uint64_t m_rng = 0;
+
+			std::vector<Undo> m_undo;
+
+			/** @brief Same draws as `Snake::Game::insertFood` */
+			void spawnFood() noexcept;
+	};
+
+	/**
+	 * @class MctsSearch
+	 * @brief Root parallel Monte Carlo tree search over Snake::PlayoutBoard.
+	 *
+	 * @details
+	 * Each thread of the pool grows its own tree from the same root, so threads share nothing but the
+	 * work counters of Snake::WorkerPool; at the end the visit counts of the root moves are summed and the
+	 * most visited move wins. Work is handed out in small batches of iterations that threads steal from
+	 * each other, until the time budget runs out.
+	 *
+	 * An iteration descends by UCT, expands a node once it has been visited, then plays out at most
+	 * `s_PlayoutDepth` ticks with a random policy that avoids immediate death and leans towards the food.
+	 * A playout scores the food eaten (discounted by depth), 0 if the snake dies, and a bonus for
+	 * surviving that grows as the head nears the food.
+	 */
+	class MctsSearch
+	{
+		public:
+			/**
+			 * @brief Starts the worker threads
+			 * @param threads Search threads including the caller, 0 uses all cores
+			 * @param seed Seed of the playout policies
+			 */
+			MctsSearch(unsigned int threads, uint64_t seed);
+
+			/**
+			 * @brief Searches for the best move from `root`
+			 * @param root Position to search from
+			 * @param budget Wall clock time to spend
+			 * @return Snake::Snake::Direction of the most visited move, the current direction if nothing was searched
+			 */
+			unsigned int search(PlayoutBoard const& root, std::chrono::nanoseconds budget);
+
+			/** @brief Search threads including the caller */
+			unsigned int threads() const noexcept;
+
+			/** @brief Playouts run by every search so far */
+			uint64_t playouts() const noexcept;
+
+		private:
+			struct Node
+			{
+				uint32_t firstChild;
+				uint32_t visits;
+				float value;
+				uint8_t direction;
+				uint8_t children;
+				bool dead;
+			};
+
+			/** @brief State owned by one search thread */
+			struct Tree
+			{
+				PlayoutBoard board;
+				std::vector<Node> nodes;
+				std::vector<uint32_t> path;
+				uint64_t rng;
+				uint64_t playouts = 0;
+
+				/** @brief Search the tree was last reset for */
+				uint64_t search = 0;
+			};
+
+			/** @brief Maximum ticks played out from a leaf */
+			static constexpr unsigned int s_PlayoutDepth = 48;
+
+			/** @brief Iterations per unit of work handed out by the pool */
+			static constexpr unsigned int s_BatchIterations = 32;
+
+			/** @brief Nodes per tree; expansion stops once a tree is full */
+			static constexpr uint32_t s_MaxNodes = 1u << 18;
+
+			/** @brief UCT exploration constant */
+			static constexpr float s_Exploration = 0.7f;
+
+			WorkerPool m_pool;
+			std::vector<std::unique_ptr<Tree>> m_trees;
+			PlayoutBoard const* m_root = nullptr;
+			uint64_t m_search = 0;
+
+			/** @brief Iterations per second of the whole pool, measured by the previous searches */
+			double m_rate = 0.0;
+
+			void prepare(Tree& tree) const;
+			void expand(Tree& tree, uint32_t node) const;
+			void iterate(Tree& tree) const;
+			float playout(Tree& tree) const;
+	};
+
+	/**
+	 * @class MctsController
+	 * @brief Plays with Snake::MctsSearch, spending a fixed share of every tick on the search.
+	 */
+	class MctsController : public Controller
+	{
+		public:
+			/**
+			 * @brief Creates the bot
+			 * @param threads Search threads, 0 uses all cores
+			 * @param seed Seed of the playout policies
+			 * @param budget Search time per tick
+			 */
+			MctsController(unsigned int threads, uint64_t seed, std::chrono::nanoseconds budget);
+
+			Input::KeyKind nextKey(Game const& game) override;
+
+			/**
+			 * @brief Playouts per second per thread
+			 */
+			std::string report() const override;
+
+		private:
+			MctsSearch m_search;
+			std::chrono::nanoseconds m_budget;
+			GameSnapshot m_snapshot;
+			PlayoutBoard m_root;
+			uint64_t m_decisions = 0;
+			std::chrono::nanoseconds m_searched{ 0 };
+	};
+
+	/**
+	 * @brief Runs `--mcts-bench`: searches the starting position with 1, 2, 4, ... threads and reports playouts per second per thread
+	 * @param options Snake::Options with the board size, seed and maximum thread count
+	 * @return int Process exit code
+	 */
+	int runMctsBench(Options const& options);
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Snake
+{
+	/**
+	 * @enum MemorySubsystem
+	 * @brief Parts of the engine whose memory Snake::MemoryReport tells apart.
+	 *
+	 * @details
+	 * - ScreenBuffer: the cell pointer grid and the object list of Snake::ScreenBuffer
+	 * - Objects: the game objects themselves, their cell lists and collision pairs
+	 * - Cells: Snake::PositionedCell and Snake::Cell blocks, including shared pointer control blocks
+	 * - History: previous/new positions of moved objects, vacated cells and the rewind buffer
+	 * - Logging: the record queue of Snake::Log
+	 */
+	enum class MemorySubsystem : uint8_t
+	{
+		ScreenBuffer,
+		Objects,
+		Cells,
+		History,
+		Logging,
+		Count
+	};
+
+	/**
+	 * @class MemoryReport
+	 * @brief Live bytes and allocations per Snake::MemorySubsystem.
+	 *
+	 * @details
+	 * Filled on demand by walking the structures that own memory (see `Game::memoryReport`), so keeping
+	 * the numbers costs nothing while the game runs. Containers count their capacity, not their size;
+	 * allocator bookkeeping and padding between blocks are not counted.
+	 */
+	class MemoryReport
+	{
+		public:
+			/**
+			 * @brief Bytes and number of heap blocks of one subsystem
+			 */
+			struct Usage
+			{
+				uint64_t bytes = 0;
+				uint64_t allocations = 0;
+			};
+
+			/**
+			 * @brief Size of a shared pointer control block as laid out by libstdc++ and libc++: vtable pointer and two counters
+			 */
+			static constexpr size_t s_SharedControlBytes = sizeof(void*) + 2 * sizeof(int);
+
+			/**
+			 * @brief Adds memory to a subsystem
+			 * @param subsystem Snake::MemorySubsystem owning the memory
+			 * @param bytes Bytes held
+			 * @param allocations Heap blocks holding them, 0 for static storage
+			 */
+			void add(MemorySubsystem subsystem, uint64_t bytes, uint64_t allocations = 1) noexcept;
+
+			/**
+			 * @brief Adds the storage of a vector, if it has any
+			 */
+			template <typename T, typename Allocator>
+			void addVector(MemorySubsystem subsystem, std::vector<T, Allocator> const& vector) noexcept
+			{
+				if (vector.capacity() > 0)
+				{
+					add(subsystem, vector.capacity() * sizeof(T));
+				}
+			}
+
+			/**
+			 * @brief Adds an object created by `std::make_shared`, which shares one block with its control block
+			 */
+			template <typename T>
+			void addShared(MemorySubsystem subsystem, uint64_t count = 1) noexcept
+			{
+				add(subsystem, count * (sizeof(T) + s_SharedControlBytes), count);
+			}
+
+			Usage const& usage(MemorySubsystem subsystem) const noexcept;
+
+			/**
+			 * @brief Sum over every subsystem
+			 */
+			Usage total() const noexcept;
+
+			/**
+			 * @brief Formats the subsystems as a human readable table, one per line
+			 * @return std::string Report text
+			 */
+			std::string report() const;
+
+			/**
+			 * @brief Formats every subsystem on a single line, for the log
+			 * @return std::string Summary text
+			 */
+			std::string summary() const;
+
+			/**
+			 * @brief Display name of a subsystem
+			 */
+			static const char* s_Name(MemorySubsystem subsystem) noexcept;
+
+		private:
+			std::array<Usage, static_cast<size_t>(MemorySubsystem::Count)> m_usage{};
+	};
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include "memory.h"
 #include "screen.h"
 
 namespace Snake
@@ -55,6 +56,27 @@ namespace Snake
 		ANIMATED = 1 << 1
 	};
 
+	/**
+	 * @enum CollisionLayer
+	 * @brief Collision layers (used as flags) that game objects belong to and collide with.
+	 *
+	 * @details
+	 * - WALL: Border and level obstacles
+	 * - SNAKE: Snakes
+	 * - FOOD: Food items
+	 * - ALL: Every layer, the default of both the layer and the mask
+	 *
+	 * Two objects are paired for collision checks only if each one's layer is in the other's mask.
+	 */
+	enum class CollisionLayer : uint16_t
+	{
+		NONE = 0,
+		WALL = 1 << 0,
+		SNAKE = 1 << 1,
+		FOOD = 1 << 2,
+		ALL = 0xFFFF
+	};
+
 	/**
 	 * @brief Bitwise AND operator for Attributes enum
 	 */
@@ -174,6 +196,42 @@ namespace Snake
 			 */
 			CollisionType getCollisionType() const noexcept;
 
+			/**
+			 * @brief Gets the layers the object belongs to
+			 * @return uint16_t Combination of Snake::CollisionLayer values
+			 */
+			uint16_t getCollisionLayer() const noexcept;
+
+			/**
+			 * @brief Gets the layers the object collides with
+			 * @return uint16_t Combination of Snake::CollisionLayer values
+			 */
+			uint16_t getCollisionMask() const noexcept;
+
+			/**
+			 * @brief Sets the layers the object belongs to and collides with
+			 * @param layer Combination of Snake::CollisionLayer values the object belongs to
+			 * @param mask Combination of Snake::CollisionLayer values the object collides with
+			 *
+			 * For an object already added to a Snake::ScreenBuffer use `ScreenBuffer::setCollisionFilter`,
+			 * so pairs cached for the buffer's objects are rebuilt.
+			 */
+			void setCollisionFilter(uint16_t layer, uint16_t mask) noexcept;
+
+			/**
+			 * @brief Sets the layers the object belongs to and collides with
+			 * @param layer Snake::CollisionLayer the object belongs to
+			 * @param mask Snake::CollisionLayer the object collides with
+			 */
+			void setCollisionFilter(CollisionLayer layer, CollisionLayer mask) noexcept;
+
+			/**
+			 * @brief Checks if the layers and masks of two objects let them collide
+			 * @param other Reference to the other Snake::BaseObject
+			 * @return true if each object's layer is in the other's mask
+			 */
+			bool canCollideWith(BaseObject const& other) const noexcept;
+
 			/**
 			 * @brief Determines the result of a collision with another object
 			 * @param other Reference to the other Snake::BaseObject involved in the collision
@@ -190,7 +248,40 @@ namespace Snake
 			 * Iterates through the object's cells and collects positions of those marked as detectors (Snake::Cell::detector = true).
 			 */
 			PosVector getDetectorCellsPos() const;
+
+			/**
+			 * @brief Checks if the object occupies a position without a positioned cell there
+			 * @param x X coordinate
+			 * @param y Y coordinate
+			 * @return true if the position belongs to the object
+			 *
+			 * For objects too large to keep a cell per square (e.g. Snake::Obstacles). Objects without
+			 * positioned cells are collided through this instead of `BaseObject::cells`. Default: false.
+			 */
+			virtual bool covers(unsigned int x, unsigned int y) const;
+
+			/**
+			 * @brief Adds the memory held by the object to a report
+			 * @param report Snake::MemoryReport to add to
+			 *
+			 * Counts the cell list, the positioned cells, each distinct Snake::Cell block once, and the position history.
+			 * The object itself is counted by its owner.
+			 */
+			virtual void accountMemory(MemoryReport& report) const;
 		protected:
+			/**
+			 * @brief Block backing the cells created by `BaseObject::makePooledPCell`
+			 *
+			 * Declared before `m_cells` so it outlives the pointers into it.
+			 */
+			std::unique_ptr<PositionedCell[]> m_pCellPool;
+
+			/** @brief Capacity of `m_pCellPool` */
+			size_t m_pCellPoolSize = 0;
+
+			/** @brief Number of `m_pCellPool` entries handed out */
+			size_t m_pCellPoolUsed = 0;
+
 			/**
 			 * @brief Positioned cells constituting this object
 			 */
@@ -242,6 +333,30 @@ namespace Snake
 			 */
 			static PCellPtr s_MakePCell(unsigned int x, unsigned int y, CellPtr cell);
 
+			/**
+			 * @brief Allocates storage for `count` positioned cells in a single block
+			 * @param count Number of cells the object is about to create
+			 *
+			 * Also reserves `m_cells`, so building an object of known size costs two allocations.
+			 */
+			void reservePCells(size_t count);
+
+			/**
+			 * @brief Like `BaseObject::s_MakePCell` but takes the cell from the block reserved by `BaseObject::reservePCells`
+			 * @param x X coordinate of the PositionedCell
+			 * @param y Y coordinate of the PositionedCell
+			 * @param cell Snake::CellPtr Shared pointer to the Cell for this PositionedCell
+			 * @return Snake::PCellPtr Non-deleting pointer into the block, or a heap allocated one once the block is used up
+			 */
+			PCellPtr makePooledPCell(unsigned int x, unsigned int y, CellPtr cell);
+
+			/**
+			 * @brief Forgets the last move, so no positions are reported as vacated
+			 *
+			 * For objects that were put in place rather than moved, e.g. by a restored snapshot.
+			 */
+			void settlePositions();
+
 		private:
 			/**
 			 * @brief Attributes (flags) of the object
@@ -257,6 +372,20 @@ namespace Snake
 			 */
 			CollisionType m_collisionType;
 
+			/**
+			 * @brief Layers the object belongs to
+			 *
+			 * Default: Snake::CollisionLayer::ALL
+			 */
+			uint16_t m_collisionLayer = static_cast<uint16_t>(CollisionLayer::ALL);
+
+			/**
+			 * @brief Layers the object collides with
+			 *
+			 * Default: Snake::CollisionLayer::ALL
+			 */
+			uint16_t m_collisionMask = static_cast<uint16_t>(CollisionLayer::ALL);
+
 			/**
 			 * @brief Positions occupied by the object's cells before the last move
 			 *
@@ -307,6 +436,22 @@ namespace Snake
 			 */
 			CollisionResult getCollisionResult(BaseObject const &other) const override;
 
+			/**
+			 * @brief Number of animation steps taken so far
+			 */
+			size_t animationFrame() const noexcept;
+
+			/**
+			 * @brief Jumps to an animation step, recoloring the border as if `frame` steps had been taken
+			 * @param frame Value previously returned by `Border::animationFrame`
+			 */
+			void setAnimationFrame(size_t frame);
+
+			/**
+			 * @brief Also counts the whole glyph block and the color sequence
+			 */
+			void accountMemory(MemoryReport& report) const override;
+
 		protected:
 			/**
 			 * @brief Animates the border by cycling through a color sequence
@@ -321,6 +466,23 @@ namespace Snake
 			 */
 			std::vector<uint8_t> m_colorSequence;
 
+			/** @brief Number of distinct border glyphs (two lines and four corners) */
+			static constexpr size_t s_GlyphCount = 6;
+
+			/**
+			 * @brief Cells shared by all border positions, one per glyph, in a single allocation
+			 *
+			 * Order: horizontal, vertical, top-left, top-right, bottom-left, bottom-right.
+			 */
+			std::shared_ptr<Cell[]> m_glyphs;
+
+			/**
+			 * @brief Creates the positioned cells around a board, see Snake::withBoard
+			 * @tparam BoardType Snake::Board or Snake::DynamicBoard
+			 */
+			template <typename BoardType>
+			void build(BoardType board);
+
 			/**
 			 * @brief Generates the color sequence for border animation
 			 * @callergraph
@@ -372,6 +534,11 @@ namespace Snake
 			void setDirection(Direction direction);
 			Position getHeadPosition() const;
 
+			/**
+			 * @brief Gets the snake's current movement direction
+			 */
+			Direction direction() const noexcept;
+
 			/**
 			 * @brief Determines the result of a collision with another object
 			 * @param other Reference to the other Snake::BaseObject involved in the collision
@@ -411,6 +578,17 @@ namespace Snake
 			void grow();
 			void logCells() const;
 
+			/**
+			 * @brief Puts the snake back into a previously captured shape
+			 * @param positions Cell positions, head first; must hold at least two cells
+			 * @param headGlyph Codepoint of the head cell
+			 * @param tailGlyph Codepoint of the tail cell
+			 * @param direction Movement direction
+			 *
+			 * Reuses the existing cells, only allocating when the snake was shorter than `positions`.
+			 */
+			void restore(PosVector const& positions, uint32_t headGlyph, uint32_t tailGlyph, Direction direction);
+
 		protected:
 			/**
 			 * @brief Moves the snake according to its current direction
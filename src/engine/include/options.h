@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Snake
+{
+	/**
+	 * @brief Command line options of the game
+	 *
+	 * Parsed once in `main` and handed to Snake::Game.
+	 */
+	struct Options
+	{
+		/**
+		 * @brief Print a breakdown of the startup phases on exit (`--startup-profile`)
+		 */
+		bool startupProfile = false;
+
+		/**
+		 * @brief Time budget from process start to first frame, in milliseconds (`--startup-budget=<ms>`)
+		 *
+		 * The clock starts while the engine's statics are initialized, before `main`; time spent before that
+		 * (loading the executable and its libraries) is not counted. Phases that push the total past this
+		 * budget are flagged in the startup report.
+		 */
+		unsigned int startupBudgetMs = 50;
+
+		/**
+		 * @brief Print the memory used per subsystem on exit (`--memory-report`), see Snake::MemoryReport
+		 */
+		bool memoryReport = false;
+
+		/**
+		 * @brief Record frame phases and write them as Chrome Trace Event JSON on exit (`--trace=<path>`), see Snake::Trace
+		 */
+		std::string tracePath;
+
+		/**
+		 * @brief File the always-on flight recorder dumps to on game over, Ctrl+C, a crash or a slow tick (`--flight-recorder=<path>`), see Snake::FlightRecorder
+		 */
+		std::string flightPath = "logs/snake.flight";
+
+		/**
+		 * @brief Flight recorder dump to print as text instead of running a game (`--decode-flight=<path>`)
+		 */
+		std::string decodeFlightPath;
+
+		/**
+		 * @brief Show tick time, frame size, frame rate, input latency, length and score on the row below the board (`--hud`), see Snake::PerformanceHud
+		 */
+		bool hud = false;
+
+		/**
+		 * @brief Check collisions and encode frames on `threads` threads (`--parallel-phases`), see Snake::FrameJobs
+		 */
+		bool parallelPhases = false;
+
+		/**
+		 * @brief Run the simulation without a terminal, without pacing and without rendering (`--headless`)
+		 */
+		bool headless = false;
+
+		/**
+		 * @brief Undo deaths by rewinding a couple of seconds instead of ending the game (`--casual`)
+		 */
+		bool casual = false;
+
+		/**
+		 * @brief Let Snake::AutopilotController steer instead of the keyboard or random input (`--autopilot`)
+		 */
+		bool autopilot = false;
+
+		/**
+		 * @brief Let Snake::MctsController steer instead of the keyboard or random input (`--mcts`)
+		 */
+		bool mcts = false;
+
+		/**
+		 * @brief Share of the tick time the MCTS bot searches for each tick, in percent (`--mcts-budget=<percent>`)
+		 */
+		unsigned int mctsBudget = 50;
+
+		/**
+		 * @brief Shared object of a bot plugin to steer instead of the keyboard or random input (`--bot=<path>`), see Snake::PluginController
+		 */
+		std::string botPath;
+
+		/**
+		 * @brief Share of the tick time a bot plugin may take per decision, in percent (`--bot-budget=<percent>`)
+		 */
+		unsigned int botBudget = 50;
+
+		/**
+		 * @brief Simulation ticks per second, 1 to 1000 (`--tick-rate=<hz>`)
+		 *
+		 * Paces interactive games; headless runs are not paced, but recordings and spectators they feed are timed by it.
+		 */
+		unsigned int tickRate = 4;
+
+		/**
+		 * @brief Most frames drawn per second in interactive games, 1 to 1000 (`--fps=<hz>`)
+		 *
+		 * Independent of the tick rate: a frame is drawn when ticks happened, at most this often, so ticks between two
+		 * frames are drawn together. The border animates once per frame.
+		 */
+		unsigned int fps = 30;
+
+		/**
+		 * @brief Benchmark the MCTS search with a growing number of threads (`--mcts-bench`), see Snake::runMctsBench
+		 */
+		bool mctsBench = false;
+
+		/**
+		 * @brief Game area width when there is no terminal to measure (`--size=<w>x<h>`)
+		 */
+		unsigned int width = 80;
+
+		/**
+		 * @brief Game area height when there is no terminal to measure (`--size=<w>x<h>`)
+		 */
+		unsigned int height = 24;
+
+		/**
+		 * @brief Number of ticks to simulate in headless mode, 0 runs until SIGINT (`--ticks=<n>`)
+		 */
+		uint64_t ticks = 1000000;
+
+		/**
+		 * @brief Input script replacing the keyboard (`--script=<path>`), see Snake::ScriptedController
+		 */
+		std::string scriptPath;
+
+		/**
+		 * @brief Replay file to play back instead of reading input (`--replay=<path>`), see Snake::ReplayReader
+		 */
+		std::string replayPath;
+
+		/**
+		 * @brief File to record the game's inputs to (`--record-replay=<path>`), see Snake::ReplayWriter
+		 */
+		std::string recordPath;
+
+		/**
+		 * @brief File to record rendered frames to (`--record-frames=<path>`), see Snake::FrameRecorder
+		 */
+		std::string framesPath;
+
+		/**
+		 * @brief Frame recording to play back instead of running a game (`--play=<path>`), see Snake::FramePlayer
+		 */
+		std::string playPath;
+
+		/**
+		 * @brief Tick to start playback at (`--seek=<tick>`)
+		 */
+		uint64_t seekTick = 0;
+
+		/**
+		 * @brief Unix domain socket to broadcast the game on (`--serve=<path>`), see Snake::SpectatorServer
+		 */
+		std::string servePath;
+
+		/**
+		 * @brief Socket of a running game to watch instead of playing (`--spectate=<path>`), see Snake::runSpectator
+		 */
+		std::string spectatePath;
+
+		/**
+		 * @brief POSIX shared memory segment to export every frame to (`--shm=<name>`), see Snake::SharedFrameWriter
+		 */
+		std::string shmName;
+
+		/**
+		 * @brief Export the recording given by `--play` to this asciicast file instead of playing it (`--asciicast=<path>`)
+		 */
+		std::string asciicastPath;
+
+		/**
+		 * @brief Level file to play on (`--level=<path>`), see Snake::Level; the output of `--compile-level` when that is given
+		 */
+		std::string levelPath;
+
+		/**
+		 * @brief Text map to compile into the level file given by `--level` instead of playing (`--compile-level=<path>`), see Snake::compileLevel
+		 */
+		std::string compileLevelPath;
+
+		/**
+		 * @brief Seed for food placement and generated input, 0 picks a random one (`--seed=<n>`)
+		 */
+		uint64_t seed = 0;
+
+		/**
+		 * @brief Number of games stepped together in batch mode, 0 disables it (`--batch=<n>`), see Snake::BatchEnv
+		 */
+		size_t batchGames = 0;
+
+		/**
+		 * @brief Worker threads for parallel modes, 0 uses all cores (`--threads=<n>`)
+		 */
+		unsigned int threads = 0;
+
+		/** @brief Smallest board width that fits the border and the initial snake */
+		static constexpr unsigned int s_MinWidth = 12;
+
+		/** @brief Smallest board height that fits the border and the initial snake */
+		static constexpr unsigned int s_MinHeight = 5;
+
+		/**
+		 * @brief Parses the command line
+		 * @param argc Argument count as received by `main`
+		 * @param argv Argument vector as received by `main`
+		 * @return Snake::Options Parsed options
+		 * @throws std::invalid_argument on unknown or malformed arguments
+		 */
+		static Options parse(int argc, char* argv[]);
+
+		/**
+		 * @brief Usage text listing all supported options
+		 */
+		static std::string usage();
+	};
+};
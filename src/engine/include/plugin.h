@@ -0,0 +1,101 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "controller.h"
+#include "snakebot.h"
+
+namespace Snake
+{
+	class Obstacles;
+
+	/**
+	 * @class PluginController
+	 * @brief Lets a bot loaded from a shared object steer (`--bot=<path>`), through the C ABI of snakebot.h.
+	 *
+	 * @details
+	 * The view handed to the bot is owned here and kept in sync incrementally: a usual tick writes the new
+	 * head and clears the old tail, the snake ring only moves its head index, and the board is rebuilt only
+	 * when the snake did not just move (new game, rewind).
+	 *
+	 * `decide` runs on a thread of the controller's own, and each tick waits for its answer at most the budget.
+	 * A missing answer is taken as if the bot had kept its direction. A call still running at the next tick
+	 * keeps the view, so that tick's budget first goes to letting it finish. `SNAKE_BOT_STRIKES` ticks in a
+	 * row without an answer disqualify the bot for the rest of the run, so even a bot that never returns
+	 * cannot hold up the game: its thread is abandoned at exit, and the plugin stays loaded for it.
+	 */
+	class PluginController : public Controller
+	{
+		public:
+			/**
+			 * @brief Loads the plugin and checks its ABI version
+			 * @param path Shared object exporting `SNAKE_BOT_ENTRY`
+			 * @param budget Longest a decision may take
+			 * @throws std::runtime_error if the plugin cannot be loaded or was built for another ABI, or on Windows
+			 */
+			PluginController(std::filesystem::path const& path, std::chrono::nanoseconds budget);
+
+			/**
+			 * @brief Destroys the bot and unloads the plugin
+			 */
+			~PluginController() override;
+
+			PluginController(PluginController const&) = delete;
+			PluginController& operator=(PluginController const&) = delete;
+
+			Input::KeyKind nextKey(Game const& game) override;
+
+			/**
+			 * @brief Decision times, overruns and whether the bot was disqualified
+			 */
+			std::string report() const override;
+
+		private:
+			/** @brief State shared with the thread running `decide` */
+			struct Call;
+
+			void* m_library = nullptr;
+			SnakeBotApi const* m_api = nullptr;
+
+			/** @brief State returned by `SnakeBotApi::create` for the current board */
+			void* m_bot = nullptr;
+			bool m_created = false;
+
+			std::chrono::nanoseconds m_budget;
+
+			/** @brief Level obstacles the walls were built with */
+			Obstacles const* m_obstacles = nullptr;
+
+			SnakeBotView m_view{};
+			std::vector<uint8_t> m_cells;
+			std::vector<uint32_t> m_body;
+
+			/** @brief Snake segments on each cell; a snake that just grew has two on its tail */
+			std::vector<uint8_t> m_segments;
+
+			/** @brief Shared with `m_thread`, which outlives the controller if a call never returns */
+			std::shared_ptr<Call> m_call;
+			std::thread m_thread;
+
+			uint64_t m_overruns = 0;
+			uint64_t m_invalid = 0;
+			unsigned int m_strikes = 0;
+			bool m_disqualified = false;
+
+			void reset(unsigned int width, unsigned int height, Obstacles const* obstacles);
+			void syncSnake(Game const& game);
+			void syncFood(Game const& game);
+			void addSegment(uint32_t cell) noexcept;
+			void removeSegment(uint32_t cell) noexcept;
+			void destroyBot() noexcept;
+
+			/** @brief Counts a tick without an answer in time, and disqualifies the bot after `SNAKE_BOT_STRIKES` in a row */
+			void strike(uint64_t tick);
+	};
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace Snake
+{
+	/**
+	 * @class StartupProfile
+	 * @brief Records how long each startup phase takes, up to the first rendered frame.
+	 *
+	 * Phases are consecutive: each `mark` closes the phase that started at the previous mark. The clock
+	 * starts at process start, while the engine's statics are initialized, so the first phase, `process`,
+	 * covers everything `main` did before the profile was constructed (option parsing, for one).
+	 */
+	class StartupProfile
+	{
+		public:
+			/**
+			 * @brief Closes the `process` phase
+			 */
+			StartupProfile();
+
+			/**
+			 * @brief Closes the current phase
+			 * @param phase Name of the phase that just finished (must outlive the profile)
+			 */
+			void mark(const char* phase);
+
+			/**
+			 * @brief Total time from process start to the last mark
+			 * @return std::chrono::microseconds Elapsed time
+			 */
+			std::chrono::microseconds total() const noexcept;
+
+			/**
+			 * @brief Formats the phases as a human readable table
+			 * @param budgetMs Startup budget in milliseconds; phases crossing it are flagged
+			 * @return std::string Report text
+			 */
+			std::string report(unsigned int budgetMs) const;
+
+		private:
+			/**
+			 * @brief A finished phase and the time it ended
+			 */
+			struct Phase
+			{
+				const char* name;
+				std::chrono::steady_clock::time_point end;
+			};
+
+			std::chrono::steady_clock::time_point m_start;
+			std::vector<Phase> m_phases;
+	};
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Snake
+{
+	/**
+	 * @class Rng
+	 * @brief Small, fast, seedable pseudo random generator (SplitMix64).
+	 *
+	 * @details
+	 * The whole state is a single 64 bit word, so it is cheap to snapshot and can be kept in
+	 * structure-of-arrays form (see the static helpers) when many independent streams are needed.
+	 */
+	class Rng
+	{
+		public:
+			/**
+			 * @brief Creates a generator
+			 * @param seed Initial state; equal seeds produce equal sequences
+			 */
+			explicit constexpr Rng(uint64_t seed = 0) noexcept : m_state(seed) {}
+
+			/**
+			 * @brief Next 64 random bits
+			 */
+			constexpr uint64_t next() noexcept
+			{
+				return s_Next(m_state);
+			}
+
+			/**
+			 * @brief Uniform integer in `[0, bound)`
+			 * @param bound Exclusive upper bound, must be greater than 0
+			 */
+			constexpr uint32_t below(uint32_t bound) noexcept
+			{
+				return s_Below(m_state, bound);
+			}
+
+			/**
+			 * @brief Current state, enough to resume the sequence later with `Rng::setState`
+			 */
+			constexpr uint64_t state() const noexcept
+			{
+				return m_state;
+			}
+
+			/**
+			 * @brief Restores a state captured with `Rng::state`
+			 */
+			constexpr void setState(uint64_t state) noexcept
+			{
+				m_state = state;
+			}
+
+			/**
+			 * @brief Advances a raw state word and returns the next 64 random bits
+			 * @param state State to advance in place
+			 */
+			static constexpr uint64_t s_Next(uint64_t& state) noexcept
+			{
+				uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+
+				return z ^ (z >> 31);
+			}
+
+			/**
+			 * @brief Uniform integer in `[0, bound)` from a raw state word (multiply-shift, no division)
+			 * @param state State to advance in place
+			 * @param bound Exclusive upper bound, must be greater than 0
+			 */
+			static constexpr uint32_t s_Below(uint64_t& state, uint32_t bound) noexcept
+			{
+				return static_cast<uint32_t>(((s_Next(state) >> 32) * bound) >> 32);
+			}
+
+			/**
+			 * @brief Derives the seed of an independent stream, e.g. one per game of a batch
+			 * @param seed Base seed
+			 * @param stream Stream number
+			 */
+			static constexpr uint64_t s_StreamSeed(uint64_t seed, uint64_t stream) noexcept
+			{
+				uint64_t state = seed ^ (stream * 0xD1B54A32D192ED03ull);
+
+				return s_Next(state);
+			}
+
+		private:
+			uint64_t m_state;
+	};
+};
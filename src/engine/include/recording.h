@@ -0,0 +1,253 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "mappedfile.h"
+#include "options.h"
+#include "screen.h"
+
+namespace Snake
+{
+	/**
+	 * @namespace Snake::FrameFormat
+	 * @brief Layout of rendered frame recordings.
+	 *
+	 * @details
+	 * - Header: magic `SNKF`, version byte, then width, height, frame time in milliseconds and keyframe interval as varints
+	 * - Frames, one per tick, each starting with a kind byte:
+	 *   - KEYFRAME: the whole board as runs of `(varint length, cell)`
+	 *   - DELTA: `varint n` recolors of `(fg from, fg to)` bytes applied to every cell at once, then
+	 *     `varint n` changed cells of `(varint index gap, cell)`
+	 * - Index: `(fixed64 frame, fixed64 file offset)` per keyframe
+	 * - Trailer: fixed64 index offset, fixed64 frame count, magic `SNKI`
+	 *
+	 * A cell is a varint index into a palette rebuilt from every keyframe; the index one past the end
+	 * appends a new entry: varint codepoint, flags byte, fg byte unless DEFAULT_FG, bg byte unless DEFAULT_BG.
+	 *
+	 * Recolors make the animated border cost a few bytes per frame instead of one cell per border square.
+	 * Varints are Snake::Varint.
+	 */
+	namespace FrameFormat
+	{
+		constexpr char MAGIC[4] = { 'S', 'N', 'K', 'F' };
+		constexpr char INDEX_MAGIC[4] = { 'S', 'N', 'K', 'I' };
+		constexpr uint8_t VERSION = 1;
+		constexpr uint8_t KEYFRAME = 0;
+		constexpr uint8_t DELTA = 1;
+		constexpr size_t TRAILER_SIZE = 8 + 8 + sizeof(INDEX_MAGIC);
+	};
+
+	/**
+	 * @class FrameEncoder
+	 * @brief Encodes Snake::ScreenBuffer frames as Snake::FrameFormat keyframes and deltas.
+	 *
+	 * Keeps the previous frame and the palette, so frames must be encoded in order and a delta is only
+	 * meaningful to a decoder that saw every frame since the last keyframe.
+	 */
+	class FrameEncoder
+	{
+		public:
+			/**
+			 * @param width Board width
+			 * @param height Board height
+			 */
+			FrameEncoder(unsigned int width, unsigned int height);
+
+			/**
+			 * @brief Appends the current contents of the buffer as the next frame
+			 * @param buffer Screen buffer after rendering, so vacated cells are already cleared
+			 * @param keyframe Encode the whole board instead of the changes since the previous frame
+			 * @param out Destination bytes
+			 */
+			void encode(ScreenBuffer const& buffer, bool keyframe, std::vector<uint8_t>& out);
+
+		private:
+			std::vector<PackedCell> m_current;
+			std::vector<PackedCell> m_previous;
+			std::vector<PackedCell> m_palette;
+
+			void encodeKeyframe(std::vector<uint8_t>& out);
+			void encodeDelta(std::vector<uint8_t>& out);
+			void encodeCell(PackedCell const& cell, std::vector<uint8_t>& out);
+	};
+
+	/**
+	 * @class FrameDecoder
+	 * @brief Decodes Snake::FrameFormat keyframes and deltas back into cells.
+	 */
+	class FrameDecoder
+	{
+		public:
+			/**
+			 * @brief Sets the board size and blanks the frame
+			 */
+			void reset(unsigned int width, unsigned int height);
+
+			/**
+			 * @brief Decodes one frame and applies it to the current cells
+			 * @param data Encoded bytes
+			 * @param size Number of valid bytes in `data`
+			 * @param offset Start of the frame; advanced past it
+			 * @throws std::runtime_error on truncated or malformed frames
+			 */
+			void decode(const uint8_t* data, size_t size, size_t& offset);
+
+			/** @brief Cells of the last decoded frame, row by row */
+			const std::vector<PackedCell>& cells() const noexcept;
+
+		private:
+			std::vector<PackedCell> m_cells;
+			std::vector<PackedCell> m_palette;
+
+			PackedCell decodeCell(const uint8_t* data, size_t size, size_t& offset);
+	};
+
+	/**
+	 * @class FrameRecorder
+	 * @brief Records Snake::ScreenBuffer frames as keyframes plus per-frame deltas.
+	 *
+	 * Frames are streamed to disk as they are recorded; `FrameRecorder::finish` appends the keyframe index.
+	 */
+	class FrameRecorder
+	{
+		public:
+			/**
+			 * @brief Opens the recording
+			 * @param path Destination file
+			 * @param width Board width
+			 * @param height Board height
+			 * @param frameMs Time between frames, used for playback and export
+			 * @param keyframeInterval Frames between keyframes; bounds the cost of a seek
+			 * @throws std::runtime_error if the file cannot be created
+			 */
+			FrameRecorder(std::filesystem::path const& path, unsigned int width, unsigned int height,
+				unsigned int frameMs, unsigned int keyframeInterval = s_DefaultKeyframeInterval);
+
+			/**
+			 * @brief Finishes the recording if `FrameRecorder::finish` was not called
+			 */
+			~FrameRecorder();
+
+			/**
+			 * @brief Records the current contents of the buffer as the next frame
+			 * @param buffer Screen buffer after rendering, so vacated cells are already cleared
+			 */
+			void frame(ScreenBuffer const& buffer);
+
+			/**
+			 * @brief Writes the keyframe index and closes the file
+			 * @throws std::runtime_error if the file cannot be written
+			 */
+			void finish();
+
+			/** @brief Frames recorded so far */
+			uint64_t frames() const noexcept;
+
+			/** @brief Bytes written so far */
+			uint64_t bytes() const noexcept;
+
+			/** @brief Default frames between keyframes */
+			static constexpr unsigned int s_DefaultKeyframeInterval = 256;
+
+		private:
+			std::filesystem::path m_path;
+			std::ofstream m_out;
+			unsigned int m_width;
+			unsigned int m_height;
+			unsigned int m_keyframeInterval;
+			uint64_t m_frames = 0;
+			uint64_t m_offset = 0;
+			bool m_finished = false;
+
+			FrameEncoder m_encoder;
+
+			/** @brief (frame, offset) of every keyframe */
+			std::vector<std::pair<uint64_t, uint64_t>> m_index;
+
+			/** @brief Encoding scratch, reused between frames */
+			std::vector<uint8_t> m_bytes;
+
+			void write();
+	};
+
+	/**
+	 * @class FramePlayer
+	 * @brief Decodes a frame recording and seeks through it using the keyframe index.
+	 *
+	 * Seeking costs at most one keyframe plus the deltas up to the target frame.
+	 */
+	class FramePlayer
+	{
+		public:
+			/**
+			 * @brief Maps the recording and decodes its first frame
+			 * @param path Recording written by Snake::FrameRecorder
+			 * @throws std::runtime_error if the file is not a finished recording
+			 */
+			explicit FramePlayer(std::filesystem::path const& path);
+
+			unsigned int width() const noexcept;
+			unsigned int height() const noexcept;
+			unsigned int frameMs() const noexcept;
+			uint64_t frameCount() const noexcept;
+
+			/** @brief Index of the frame returned by `FramePlayer::cells` */
+			uint64_t position() const noexcept;
+
+			/** @brief Cells of the current frame, row by row */
+			const std::vector<PackedCell>& cells() const noexcept;
+
+			/**
+			 * @brief Decodes the next frame
+			 * @return false if the current frame is the last one
+			 */
+			bool next();
+
+			/**
+			 * @brief Moves to a frame, clamped to the last one
+			 * @param frame Frame to decode
+			 *
+			 * Steps forward when the target is ahead and no closer keyframe exists, otherwise restarts from the nearest keyframe.
+			 */
+			void seek(uint64_t frame);
+
+		private:
+			MappedFile m_file;
+			unsigned int m_width = 0;
+			unsigned int m_height = 0;
+			unsigned int m_frameMs = 0;
+			uint64_t m_frameCount = 0;
+			uint64_t m_position = 0;
+
+			/** @brief Offset of the frame after `m_position` */
+			size_t m_offset = 0;
+
+			/** @brief End of the frame data, where the index starts */
+			size_t m_end = 0;
+
+			std::vector<std::pair<uint64_t, uint64_t>> m_index;
+			FrameDecoder m_decoder;
+
+			void decodeFrame();
+			uint64_t varint(size_t& offset) const;
+	};
+
+	/**
+	 * @brief Converts a frame recording to an asciicast v2 file
+	 * @param player Recording to convert; played from its first frame
+	 * @param out Destination stream
+	 */
+	void exportAsciicast(FramePlayer& player, std::ostream& out);
+
+	/**
+	 * @brief Entry point of `--play`: plays a recording on the terminal, or exports it with `--asciicast`
+	 * @param options Parsed command line
+	 * @return int Process exit code
+	 */
+	int playRecording(Options const& options);
+};
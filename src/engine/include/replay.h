@@ -0,0 +1,196 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "controller.h"
+#include "mappedfile.h"
+#include "objects.h"
+
+namespace Snake
+{
+	/**
+	 * @namespace Snake::ReplayFormat
+	 * @brief Layout of replay files.
+	 *
+	 * @details
+	 * - Header: magic `SNKR`, version byte, seed as 8 little endian bytes, then width, height and checksum interval as varints
+	 * - Records: a varint `(ticks since previous record << 3) | tag`, where tag is
+	 *   - 0-3: input, a Snake::Snake::Direction applied at that tick
+	 *   - CHECKSUM: followed by a varint state checksum taken after that tick
+	 *   - END: the tick count at which the game ended in a game over
+	 *   - STOPPED: the tick count at which the recording stopped with the game still running, on Enter, Ctrl+C or `--ticks`
+	 *
+	 * Exactly one END or STOPPED record ends the file.
+	 *
+	 * Varints are unsigned LEB128: 7 bits per byte, high bit set on all but the last byte.
+	 */
+	namespace ReplayFormat
+	{
+		constexpr char MAGIC[4] = { 'S', 'N', 'K', 'R' };
+		constexpr uint8_t VERSION = 2;
+		constexpr uint8_t TAG_CHECKSUM = 4;
+		constexpr uint8_t TAG_END = 5;
+		constexpr uint8_t TAG_STOPPED = 6;
+		constexpr unsigned int TAG_BITS = 3;
+	};
+
+	/**
+	 * @class ReplayWriter
+	 * @brief Records a game as seed, board size and the inputs that drove it.
+	 *
+	 * Records are kept in memory and written to disk by `ReplayWriter::finish`.
+	 */
+	class ReplayWriter
+	{
+		public:
+			/**
+			 * @brief Starts a replay
+			 * @param path Destination file
+			 * @param seed Seed of the game's Snake::Rng
+			 * @param width Board width
+			 * @param height Board height
+			 * @param checksumInterval Ticks between state checksums
+			 */
+			ReplayWriter(std::filesystem::path path, uint64_t seed, unsigned int width, unsigned int height, unsigned int checksumInterval);
+
+			/**
+			 * @brief Records an input
+			 * @param tick Tick the input is applied at
+			 * @param direction Direction requested by the input
+			 */
+			void input(uint64_t tick, Snake::Direction direction);
+
+			/**
+			 * @brief Records a state checksum if `tick` falls on the checksum interval
+			 * @param tick Tick that just finished
+			 * @param checksum Value of `Snake::Game::stateChecksum` after that tick
+			 */
+			void checksum(uint64_t tick, uint32_t checksum);
+
+			/**
+			 * @brief Ticks between state checksums
+			 */
+			unsigned int checksumInterval() const noexcept;
+
+			/**
+			 * @brief Writes the end record and the file
+			 * @param ticks Total ticks played
+			 * @param gameOver Whether the game ended in a game over, rather than being stopped while running
+			 * @throws std::runtime_error if the file cannot be written
+			 */
+			void finish(uint64_t ticks, bool gameOver);
+
+		private:
+			std::filesystem::path m_path;
+			unsigned int m_checksumInterval;
+			uint64_t m_lastTick = 0;
+			std::vector<uint8_t> m_bytes;
+
+			void record(uint64_t tick, uint8_t tag);
+	};
+
+	/**
+	 * @class ReplayReader
+	 * @brief Memory maps a replay file and walks its records.
+	 */
+	class ReplayReader
+	{
+		public:
+			/**
+			 * @brief A decoded record
+			 */
+			struct Record
+			{
+				uint64_t tick;
+				uint8_t tag;
+				uint32_t checksum;
+			};
+
+			/**
+			 * @brief Maps the file, parses its header and checks that its records decode up to one END or STOPPED record
+			 * @param path Replay file
+			 * @throws std::runtime_error if the file cannot be mapped, is not a replay or is truncated or corrupt
+			 */
+			explicit ReplayReader(std::filesystem::path const& path);
+
+			uint64_t seed() const noexcept;
+			unsigned int width() const noexcept;
+			unsigned int height() const noexcept;
+			unsigned int checksumInterval() const noexcept;
+
+			/**
+			 * @brief Whether the recorded game ended in a game over, rather than being stopped while running
+			 */
+			bool endsInGameOver() const noexcept;
+
+			/**
+			 * @brief Decodes the next record without consuming it
+			 * @return The record, or std::nullopt after the end record
+			 */
+			std::optional<Record> peek() const;
+
+			/**
+			 * @brief Consumes the record returned by the last `ReplayReader::peek`
+			 */
+			void advance();
+
+		private:
+			MappedFile m_file;
+			size_t m_offset = 0;
+			mutable size_t m_nextOffset = 0; // end of the record returned by peek()
+			uint64_t m_tick = 0;
+
+			uint64_t m_seed = 0;
+			unsigned int m_width = 0;
+			unsigned int m_height = 0;
+			unsigned int m_checksumInterval = 0;
+			bool m_endsInGameOver = false;
+
+			uint64_t varint(size_t& offset) const;
+
+			/** @brief Decodes the record at `offset` following one at `tick`, and moves `offset` past it */
+			Record decode(size_t& offset, uint64_t tick) const;
+	};
+
+	/**
+	 * @class ReplayController
+	 * @brief Feeds the inputs of a replay back into Snake::Game and checks its state checksums.
+	 */
+	class ReplayController : public Controller
+	{
+		public:
+			/**
+			 * @brief Creates the controller
+			 * @param reader Replay to play back; must outlive the controller
+			 */
+			explicit ReplayController(ReplayReader& reader);
+
+			Input::KeyKind nextKey(Game const& game) override;
+
+			/**
+			 * @brief Compares the game state after a tick against the recorded checksum, if any
+			 * @param tick Tick that just finished
+			 * @param checksum Value of `Snake::Game::stateChecksum`
+			 * @return false if a recorded checksum for that tick does not match
+			 */
+			bool verify(uint64_t tick, uint32_t checksum);
+
+			/**
+			 * @brief Whether the replay's end record has been reached
+			 * @param ticks Ticks played so far
+			 */
+			bool finished(uint64_t ticks) const;
+
+			/**
+			 * @brief Checksum expected by the last failed `ReplayController::verify`
+			 */
+			uint32_t expectedChecksum() const noexcept;
+
+		private:
+			ReplayReader& m_reader;
+			uint32_t m_expected = 0;
+	};
+};
@@ -5,6 +5,7 @@
 #include<memory>
 
 #include "glyphs.h"
+#include "memory.h"
 
 namespace Snake
 {
@@ -49,6 +50,35 @@ namespace Snake
 		constexpr bool operator!=(Cell const& o) const noexcept;
 	};
 
+	/**
+	 * @brief Flat, self contained copy of the visible part of a Snake::Cell
+	 *
+	 * Used where frames leave the screen buffer: recordings and their playback.
+	 */
+	struct PackedCell
+	{
+		static constexpr uint8_t DEFAULT_FG = 1;
+		static constexpr uint8_t DEFAULT_BG = 2;
+
+		uint32_t codepoint = TGLYPHS::SPACE;
+		uint8_t fg = 0xFF;
+		uint8_t bg = 0xFF;
+		uint8_t flags = DEFAULT_FG | DEFAULT_BG;
+
+		constexpr bool operator==(PackedCell const& o) const noexcept = default;
+
+		/**
+		 * @brief Packs the visible attributes of a Snake::Cell
+		 */
+		static constexpr PackedCell s_Pack(Cell const& cell) noexcept
+		{
+			return PackedCell{
+				cell.codepoint, cell.fg, cell.bg,
+				static_cast<uint8_t>((cell.default_fg ? DEFAULT_FG : 0) | (cell.default_bg ? DEFAULT_BG : 0))
+			};
+		}
+	};
+
 	/**
 	 * @brief Shared pointer to a Cell
 	 *
@@ -74,12 +104,30 @@ namespace Snake
 		CellPtr cell;
 	};
 
+	/**
+	 * @brief Deleter for Snake::PCellPtr
+	 *
+	 * Pooled cells live in a block owned by their Snake::BaseObject and are not deleted individually.
+	 */
+	struct PCellDeleter
+	{
+		bool pooled = false;
+
+		void operator()(PositionedCell* pCell) const noexcept
+		{
+			if (!pooled)
+			{
+				delete pCell;
+			}
+		}
+	};
+
 	/**
 	 * @brief Unique pointer to a PositionedCell
 	 *
 	 * Positioned cells are owned by Snake::BaseObject instances and thus must be unique.
 	 */
-	using PCellPtr = std::unique_ptr<PositionedCell>;
+	using PCellPtr = std::unique_ptr<PositionedCell, PCellDeleter>;
 
 	/**
 	 * @class ScreenBuffer
@@ -162,6 +210,24 @@ namespace Snake
 			 */
 			const std::vector<BaseObject*>& getObjects() const noexcept;
 
+			/**
+			 * @brief Counter bumped whenever the set of objects or their collision layers change
+			 * @return uint64_t Equal values mean `getObjects` returns the same objects, colliding the same way
+			 *
+			 * Lets Snake::Game keep its collision pairs across ticks.
+			 */
+			uint64_t getObjectsVersion() const noexcept;
+
+			/**
+			 * @brief Sets the collision layer and mask of an object in the buffer
+			 * @param obj Pointer to the BaseObject to change
+			 * @param layer Combination of Snake::CollisionLayer values the object belongs to
+			 * @param mask Combination of Snake::CollisionLayer values the object collides with
+			 *
+			 * Like `BaseObject::setCollisionFilter`, but also bumps the objects version.
+			 */
+			void setCollisionFilter(BaseObject* obj, uint16_t layer, uint16_t mask);
+
 			/**
 			 * @brief Checks if the position (x, y) is empty (i.e., contains the empty cell `m_emptyCell`)
 			 * @param x X coordinate
@@ -177,6 +243,28 @@ namespace Snake
 			 * Called by Snake::Terminal::render during rendering to determine which cells need to be redrawn as empty.
 			 */
 			PosVector getPositionsToClear() const;
+
+			/**
+			 * @brief Every cell of the buffer, row by row
+			 *
+			 * For full-board passes, which index it with Snake::Board or Snake::DynamicBoard instead of calling `ScreenBuffer::get` per cell.
+			 */
+			std::vector<CellPtr> const& cells() const noexcept;
+
+			/**
+			 * @brief Copies the visible contents of the buffer, row by row
+			 * @param out Resized to `width() * height()` cells
+			 */
+			void snapshot(std::vector<PackedCell>& out) const;
+
+			/**
+			 * @brief Adds the cell grid, the object list and the empty cell to a report
+			 * @param report Snake::MemoryReport to add to
+			 *
+			 * The cells of the objects are counted by the objects.
+			 */
+			void accountMemory(MemoryReport& report) const;
+
 			CellPtr getEmptyCellPtr() const noexcept;
 			void clearPositions(const PosVector &positions);
 			void dumpBuffer() const;
@@ -192,6 +280,7 @@ namespace Snake
 			unsigned int m_height = 0;
 			std::vector<CellPtr> m_buffer;
 			std::vector<BaseObject*> m_objects;
+			uint64_t m_objectsVersion = 0;
 			static std::string s_ToUnicode(uint32_t codepoint) noexcept;
 
 			void clear();
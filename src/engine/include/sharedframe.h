@@ -0,0 +1,204 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "screen.h"
+
+namespace Snake
+{
+	/**
+	 * @namespace Snake::SharedFrameFormat
+	 * @brief Layout of the shared memory segment written by Snake::SharedFrameWriter.
+	 *
+	 * @details
+	 * - Header, then `slots` slots of `slotBytes` bytes each, starting at `HEADER_BYTES`
+	 * - Slot: a Snake::SharedFrameFormat::Slot, then `width * height` Snake::PackedCell row by row, starting at `SLOT_HEADER_BYTES`
+	 *
+	 * Frames are written round robin: frame `n` (counting from 0) goes to slot `n % slots`.
+	 * Every slot is a seqlock: its sequence is `2n + 1` while frame `n` is being written and `2n + 2`
+	 * once it is complete. Readers load `Header::latest`, copy the slot of the newest frame and keep
+	 * the copy only if the sequence was the same even number before and after.
+	 *
+	 * All fields use the native byte order; the segment is only meant for processes on the same machine.
+	 */
+	namespace SharedFrameFormat
+	{
+		constexpr char MAGIC[4] = { 'S', 'N', 'K', 'M' };
+		constexpr uint32_t VERSION = 1;
+		constexpr uint32_t NO_FOOD = UINT32_MAX;
+
+		struct Header
+		{
+			char magic[4];
+			uint32_t version;
+			uint32_t width;
+			uint32_t height;
+			uint32_t slots;
+			uint32_t slotBytes;
+			uint32_t cellBytes;
+
+			/** @brief Process id of the writer, so a later run can tell a segment left by a crash from a live one */
+			uint32_t writerPid;
+
+			/** @brief Frames published so far; the newest one is in slot `(latest - 1) % slots` */
+			std::atomic<uint64_t> latest;
+		};
+
+		/**
+		 * @brief Game state of one frame
+		 */
+		struct Metadata
+		{
+			uint64_t tick;
+			uint32_t frames;     ///< Frames since the current game started
+			uint32_t length;     ///< Snake length in cells
+			uint32_t headX;
+			uint32_t headY;
+			uint32_t foodX;      ///< `NO_FOOD` if there is no food on the board
+			uint32_t foodY;      ///< `NO_FOOD` if there is no food on the board
+			uint32_t direction;  ///< Snake::Snake::Direction
+			uint32_t gameOver;   ///< 1 if the tick ended the game
+		};
+
+		struct Slot
+		{
+			std::atomic<uint64_t> sequence;
+			Metadata metadata;
+		};
+
+		static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory needs address free atomics");
+		static_assert(sizeof(PackedCell) == 8, "PackedCell layout is part of the format");
+
+		/** @brief Offset of the first slot; one cache line so the header is never shared with a slot */
+		constexpr size_t HEADER_BYTES = 64;
+
+		/** @brief Offset of the cells within a slot */
+		constexpr size_t SLOT_HEADER_BYTES = 64;
+
+		static_assert(sizeof(Header) <= HEADER_BYTES && sizeof(Slot) <= SLOT_HEADER_BYTES);
+
+		/** @brief Bytes of a slot holding a board of the given size, rounded up to whole cache lines */
+		constexpr size_t s_SlotBytes(unsigned int width, unsigned int height) noexcept
+		{
+			return (SLOT_HEADER_BYTES + size_t(width) * height * sizeof(PackedCell) + 63) / 64 * 64;
+		}
+	};
+
+	/**
+	 * @class SharedFrameWriter
+	 * @brief Publishes every frame and its metadata to a POSIX shared memory ring.
+	 *
+	 * @details
+	 * External tools (overlays, recorders, bots written in other languages) map the segment and read the
+	 * newest frame whenever they like, without a socket or any help from the game. Publishing never waits:
+	 * a reader that is too slow just retries or misses frames.
+	 *
+	 * The writer keeps the cells that changed in each of the last `slots` frames, so only the cells that
+	 * changed since a slot was last written are packed into it. The board is repacked in full only when
+	 * objects were added to or removed from the buffer.
+	 */
+	class SharedFrameWriter
+	{
+		public:
+			/**
+			 * @brief Creates the segment, replacing one left behind by a run that is no longer alive
+			 * @param name Segment name as given to `shm_open`, e.g. `/snake`
+			 * @param width Board width
+			 * @param height Board height
+			 * @param slots Frames kept; more slots give slow readers longer to copy a frame before it is overwritten
+			 * @throws std::runtime_error if the segment cannot be created, is used by a running game or is not a frame segment, or on Windows
+			 */
+			SharedFrameWriter(std::string const& name, unsigned int width, unsigned int height, unsigned int slots = s_DefaultSlots);
+
+			/**
+			 * @brief Unmaps and unlinks the segment; readers that still have it mapped keep the last frames
+			 */
+			~SharedFrameWriter();
+
+			SharedFrameWriter(SharedFrameWriter const&) = delete;
+			SharedFrameWriter& operator=(SharedFrameWriter const&) = delete;
+
+			/**
+			 * @brief Publishes the current contents of the buffer as the next frame
+			 * @param buffer Screen buffer after rendering, so vacated cells are already cleared
+			 * @param vacated Cells vacated since the previous frame
+			 * @param metadata Game state of the frame
+			 *
+			 * Besides `vacated`, only the cells of movable and animated objects are taken to have changed,
+			 * unless the buffer's objects version did.
+			 */
+			void frame(ScreenBuffer const& buffer, PosVector const& vacated, SharedFrameFormat::Metadata const& metadata);
+
+			/** @brief Frames published so far */
+			uint64_t frames() const noexcept;
+
+			static constexpr unsigned int s_DefaultSlots = 4;
+
+		private:
+			std::string m_name;
+			unsigned int m_width;
+			unsigned int m_height;
+			unsigned int m_slots;
+			size_t m_size = 0;
+			uint8_t* m_base = nullptr;
+			uint64_t m_frames = 0;
+
+			/** @brief Cells changed by each of the last `m_slots` frames, frame `n` at `n % m_slots` */
+			std::vector<PosVector> m_changed;
+
+			/** @brief Whether each of the last `m_slots` frames changed the whole board, indexed like `m_changed` */
+			std::vector<uint8_t> m_changedAll;
+
+			/** @brief `ScreenBuffer::getObjectsVersion` at the previous frame */
+			uint64_t m_objectsVersion = 0;
+
+			SharedFrameFormat::Header& header() const noexcept;
+			SharedFrameFormat::Slot& slot(unsigned int index) const noexcept;
+	};
+
+	/**
+	 * @class SharedFrameReader
+	 * @brief Reads the newest frame from a segment written by Snake::SharedFrameWriter.
+	 */
+	class SharedFrameReader
+	{
+		public:
+			/**
+			 * @brief Maps an existing segment read-only
+			 * @param name Segment name given to the writer
+			 * @throws std::runtime_error if the segment does not exist or has an unknown layout, or on Windows
+			 */
+			explicit SharedFrameReader(std::string const& name);
+
+			~SharedFrameReader();
+
+			SharedFrameReader(SharedFrameReader const&) = delete;
+			SharedFrameReader& operator=(SharedFrameReader const&) = delete;
+
+			unsigned int width() const noexcept;
+			unsigned int height() const noexcept;
+
+			/**
+			 * @brief Copies the newest complete frame
+			 * @param cells Resized to `width() * height()` cells
+			 * @param metadata Game state of the frame
+			 * @param frame Index of the frame, counting from 0
+			 * @return false if nothing has been published yet
+			 *
+			 * Retries while the writer overwrites the slot being copied, so the result is never torn.
+			 */
+			bool read(std::vector<PackedCell>& cells, SharedFrameFormat::Metadata& metadata, uint64_t& frame) const;
+
+		private:
+			size_t m_size = 0;
+			const uint8_t* m_base = nullptr;
+			unsigned int m_width = 0;
+			unsigned int m_height = 0;
+			unsigned int m_slots = 0;
+			size_t m_slotBytes = 0;
+	};
+};
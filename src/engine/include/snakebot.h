@@ -0,0 +1,117 @@
+#pragma once
+
+/**
+ * @file snakebot.h
+ * @brief C ABI of bot plugins loaded with `--bot=<path>`, see Snake::PluginController.
+ *
+ * @details
+ * A plugin is a shared object exporting `snake_bot_api` (`SNAKE_BOT_ENTRY`), a `SnakeBotEntry` returning a
+ * static `SnakeBotApi`. The game calls `create` once with the board size, `decide` once per tick and
+ * `destroy` before unloading. `create` and `destroy` run on the game thread and `decide` on a thread of its
+ * own; no two calls ever overlap.
+ *
+ * `decide` gets a `SnakeBotView` of memory the game owns and keeps up to date itself; nothing is copied per
+ * tick, and the pointers stay valid until `decide` returns. The game waits at most `budgetNs` for an answer
+ * and otherwise goes on as if the bot kept its direction; a late call still running at the next tick uses
+ * up that tick's budget before the bot is asked again. A bot that misses `SNAKE_BOT_STRIKES` ticks in a row is not asked again, so a `decide`
+ * that never returns costs the game three budgets and is then left running until the game exits.
+ *
+ * The header is plain C, so plugins can be written in C, C++, Rust, Zig, ... without the engine's headers.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Version of this header; a plugin built against another version is refused */
+#define SNAKE_BOT_ABI_VERSION 1
+
+/** @brief Name of the exported `SnakeBotEntry` */
+#define SNAKE_BOT_ENTRY "snake_bot_api"
+
+/** @brief Consecutive ticks without an answer in time after which a bot is not asked again */
+#define SNAKE_BOT_STRIKES 3
+
+/** @brief `SnakeBotView::food` when no food is on the board */
+#define SNAKE_BOT_NO_FOOD UINT32_MAX
+
+/** @brief Contents of a board cell in `SnakeBotView::cells` */
+enum SnakeBotCell
+{
+	SNAKE_BOT_FREE = 0,
+	SNAKE_BOT_WALL = 1,   /**< border or level obstacle */
+	SNAKE_BOT_SNAKE = 2,
+	SNAKE_BOT_FOOD = 3
+};
+
+/** @brief Answers of `SnakeBotApi::decide`; the directions match Snake::Snake::Direction */
+enum SnakeBotMove
+{
+	SNAKE_BOT_UP = 0,
+	SNAKE_BOT_DOWN = 1,
+	SNAKE_BOT_LEFT = 2,
+	SNAKE_BOT_RIGHT = 3,
+	SNAKE_BOT_KEEP = 4    /**< keep going in the current direction */
+};
+
+/**
+ * @brief Read only state of the game before a tick. Cells are indexed `y * width + x`, the border included
+ */
+typedef struct SnakeBotView
+{
+	uint32_t width;
+	uint32_t height;
+
+	/** @brief `width * height` SnakeBotCell values, row by row */
+	const uint8_t* cells;
+
+	/** @brief Ring of snake cells: segment `i` (0 is the head) is `body[(bodyHead + i) % bodyCapacity]` */
+	const uint32_t* body;
+	uint32_t bodyCapacity;
+	uint32_t bodyHead;
+	uint32_t length;
+
+	/** @brief Food cell, or `SNAKE_BOT_NO_FOOD` */
+	uint32_t food;
+
+	/** @brief Current SnakeBotMove direction */
+	uint32_t direction;
+
+	/** @brief Ticks since the run started */
+	uint64_t tick;
+
+	/** @brief Longest `decide` may take, in nanoseconds */
+	uint64_t budgetNs;
+} SnakeBotView;
+
+typedef struct SnakeBotApi
+{
+	/** @brief `SNAKE_BOT_ABI_VERSION` the plugin was built with */
+	uint32_t abiVersion;
+
+	/** @brief Shown in logs and reports */
+	const char* name;
+
+	/** @brief Creates the bot's state for a board; may return NULL if the bot keeps none */
+	void* (*create)(uint32_t width, uint32_t height);
+
+	/** @brief Picks the move for the upcoming tick */
+	uint32_t (*decide)(void* bot, const SnakeBotView* view);
+
+	/** @brief Frees what `create` returned; may be NULL */
+	void (*destroy)(void* bot);
+} SnakeBotApi;
+
+typedef const SnakeBotApi* (*SnakeBotEntry)(void);
+
+/** @brief Cell of segment `i` of the snake, 0 being the head */
+static inline uint32_t snake_bot_segment(const SnakeBotView* view, uint32_t i)
+{
+	return view->body[(view->bodyHead + i) % view->bodyCapacity];
+}
+
+#ifdef __cplusplus
+}
+#endif
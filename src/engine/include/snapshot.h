@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "screen.h"
+
+namespace Snake
+{
+	/**
+	 * @brief Flat copy of the whole simulation state of Snake::Game
+	 *
+	 * A fixed header of `HEADER_WORDS` words followed by one packed position per snake cell, head first.
+	 * Filled by `Snake::Game::snapshot` and applied by `Snake::Game::restore`.
+	 */
+	struct GameSnapshot
+	{
+		/**
+		 * @brief Header word indices
+		 */
+		enum Word : size_t
+		{
+			TICKS_LO,
+			TICKS_HI,
+			FRAMES,
+			RNG_LO,
+			RNG_HI,
+			ANIMATION,  ///< Border animation frame
+			DIRECTION,  ///< Snake::Snake::Direction
+			FOOD,       ///< Packed food position, or `NO_FOOD`
+			HEAD_GLYPH,
+			TAIL_GLYPH,
+			HEADER_WORDS
+		};
+
+		static constexpr uint32_t NO_FOOD = UINT32_MAX;
+
+		std::vector<uint32_t> words;
+
+		/** @brief Number of snake cells stored after the header */
+		size_t length() const noexcept
+		{
+			return words.size() - HEADER_WORDS;
+		}
+
+		/** @brief Packs a board position into one word; boards are at most 0xFFFF cells wide and high */
+		static constexpr uint32_t s_Pack(unsigned int x, unsigned int y) noexcept
+		{
+			return x | (y << 16);
+		}
+
+		static constexpr Position s_Unpack(uint32_t packed) noexcept
+		{
+			return { packed & 0xFFFF, packed >> 16 };
+		}
+	};
+
+	/**
+	 * @class RewindBuffer
+	 * @brief Ring of the most recent snapshots, delta compressed against their predecessor.
+	 *
+	 * @details
+	 * Snapshots are stored in groups of `keyframeInterval`: a full copy followed by deltas. A delta holds a
+	 * bit mask of the changed header words, those words, and the snake as `k` new head cells plus the first
+	 * `m` cells of the previous snake, which is how a snake that moved or grew looks. Whole groups are evicted
+	 * once the ring holds more than `capacity` snapshots, and their storage is reused, so pushing does not
+	 * allocate once the ring is warm.
+	 *
+	 * Reading a snapshot replays at most one group of deltas.
+	 */
+	class RewindBuffer
+	{
+		public:
+			/**
+			 * @brief Creates an empty ring
+			 * @param capacity Snapshots kept at least, once that many have been pushed
+			 * @param keyframeInterval Snapshots per group
+			 */
+			explicit RewindBuffer(size_t capacity, size_t keyframeInterval = 16);
+
+			/**
+			 * @brief Appends a snapshot as the newest entry
+			 */
+			void push(GameSnapshot const& snapshot);
+
+			/** @brief Number of snapshots held */
+			size_t size() const noexcept;
+
+			/**
+			 * @brief Decodes a snapshot
+			 * @param back 0 for the newest snapshot, 1 for the one before, ...
+			 * @param out Receives the snapshot
+			 * @return false if fewer than `back + 1` snapshots are held
+			 */
+			bool get(size_t back, GameSnapshot& out) const;
+
+			/**
+			 * @brief Decodes a snapshot and drops every newer one, so the next push continues from it
+			 * @param back 0 for the newest snapshot, 1 for the one before, ...
+			 * @param out Receives the snapshot
+			 * @return false if fewer than `back + 1` snapshots are held
+			 */
+			bool rewind(size_t back, GameSnapshot& out);
+
+			/** @brief Drops every snapshot */
+			void clear() noexcept;
+
+			/** @brief Bytes currently used by the encoded snapshots */
+			size_t bytes() const noexcept;
+
+			/**
+			 * @brief Adds every group, including reusable ones, and the last snapshot to a report
+			 * @param report Snake::MemoryReport to add to, as Snake::MemorySubsystem::History
+			 */
+			void accountMemory(MemoryReport& report) const;
+
+		private:
+			struct Group
+			{
+				std::vector<uint32_t> data;
+
+				/** @brief Start of every snapshot in `data` */
+				std::vector<uint32_t> offsets;
+			};
+
+			size_t m_capacity;
+			size_t m_keyframeInterval;
+			size_t m_size = 0;
+			std::deque<Group> m_groups;
+			std::vector<Group> m_free;
+
+			/** @brief Newest snapshot, the base of the next delta */
+			GameSnapshot m_last;
+
+			void encodeDelta(Group& group, GameSnapshot const& snapshot) const;
+			void decode(size_t groupIndex, size_t entry, GameSnapshot& out) const;
+			static void s_ApplyDelta(const uint32_t* delta, GameSnapshot& out);
+	};
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "options.h"
+#include "recording.h"
+#include "screen.h"
+
+namespace Snake
+{
+	/**
+	 * @namespace Snake::SpectatorFormat
+	 * @brief Stream sent to every spectator.
+	 *
+	 * @details
+	 * - Hello: magic `SNKS`, version byte, then width, height and frame time in milliseconds as varints
+	 * - Frames: `varint length` followed by one Snake::FrameFormat KEYFRAME or DELTA frame
+	 *
+	 * A client starts at the most recent keyframe; palette state is the same as in frame recordings.
+	 */
+	namespace SpectatorFormat
+	{
+		constexpr char MAGIC[4] = { 'S', 'N', 'K', 'S' };
+		constexpr uint8_t VERSION = 1;
+	};
+
+	/**
+	 * @class SpectatorServer
+	 * @brief Broadcasts the rendered frames to local spectators over a Unix domain socket.
+	 *
+	 * @details
+	 * `SpectatorServer::frame` encodes each frame once, on the game thread, into an immutable shared message
+	 * and hands it to a server thread; every client queues pointers to the same messages and sends
+	 * them straight from there with vectored, non-blocking writes. The game thread only takes a mutex for
+	 * a couple of pointer pushes, so it never waits on a spectator.
+	 *
+	 * A client more than `s_MaxBacklog` frames behind drops its queue and continues from the latest
+	 * keyframe. A client that takes no bytes at all for `s_StallTimeout` is disconnected.
+	 */
+	class SpectatorServer
+	{
+		public:
+			/**
+			 * @brief Creates the socket and starts the server thread
+			 * @param path Socket path; a stale socket file left by an earlier run is replaced
+			 * @param width Board width
+			 * @param height Board height
+			 * @param frameMs Time between frames, for the clients' information
+			 * @throws std::runtime_error if the socket cannot be created
+			 */
+			SpectatorServer(std::filesystem::path const& path, unsigned int width, unsigned int height, unsigned int frameMs);
+
+			/**
+			 * @brief Disconnects every client, stops the thread and removes the socket file
+			 */
+			~SpectatorServer();
+
+			SpectatorServer(SpectatorServer const&) = delete;
+			SpectatorServer& operator=(SpectatorServer const&) = delete;
+
+			/**
+			 * @brief Broadcasts the current contents of the buffer as the next frame
+			 * @param buffer Screen buffer after rendering, so vacated cells are already cleared
+			 */
+			void frame(ScreenBuffer const& buffer);
+
+			/** @brief Clients currently connected */
+			size_t clients() const noexcept;
+
+			/** @brief Frames between keyframes, where new and lagging clients start */
+			static constexpr unsigned int s_KeyframeInterval = 64;
+
+			/** @brief Queued frames beyond which a client skips to the latest keyframe */
+			static constexpr size_t s_MaxBacklog = 2 * s_KeyframeInterval;
+
+			/** @brief Time without progress after which a client is disconnected */
+			static constexpr std::chrono::seconds s_StallTimeout{ 5 };
+
+		private:
+			using Message = std::shared_ptr<const std::vector<uint8_t>>;
+
+			struct Client;
+
+			std::filesystem::path m_path;
+			FrameEncoder m_encoder;
+			uint64_t m_frames = 0;
+
+			/** @brief Sent first to every client */
+			Message m_hello;
+
+			/** @brief Guards `m_latest` and `m_pending` */
+			std::mutex m_mutex;
+
+			/** @brief Most recent keyframe and every frame after it */
+			std::vector<Message> m_latest;
+
+			/** @brief Frames the server thread has not picked up yet */
+			std::vector<Message> m_pending;
+
+			int m_listen = -1;
+
+			/** @brief Self pipe waking the server thread: read end, write end */
+			int m_wake[2] = { -1, -1 };
+
+			std::atomic<size_t> m_clients{ 0 };
+			std::atomic<bool> m_stop{ false };
+			std::thread m_thread;
+
+			void serve();
+	};
+
+	/**
+	 * @brief Entry point of `--spectate`: connects to a Snake::SpectatorServer and draws its frames
+	 * @param options Parsed command line
+	 * @return int Process exit code
+	 */
+	int runSpectator(Options const& options);
+};
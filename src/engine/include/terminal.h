@@ -1,12 +1,15 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 #if defined(_WIN32)
 #include <windows.h>
 #endif
 
+#include "framejobs.h"
 #include "screen.h"
+#include "ttywriter.h"
 
 namespace Snake
 {
@@ -16,7 +19,87 @@ namespace Snake
 			Terminal();
 			~Terminal();
 			void clearScreen();
+			/**
+			 * @brief Draws the buffer: `Terminal::s_EncodeBuffer` into a reused string, handed to the Snake::TtyWriter as one frame
+			 * @param buffer Screen buffer of the current frame
+			 *
+			 * Never waits for the terminal. After the writer dropped a frame or failed, the frame repaints the whole screen.
+			 */
 			void render(ScreenBuffer& buffer);
+
+			/**
+			 * @brief Draws a buffer whose vacated cells the caller already cleared, e.g. over several ticks
+			 * @param buffer Screen buffer of the current frame
+			 * @param vacated Positions to erase on screen since the last render
+			 */
+			void render(ScreenBuffer const& buffer, PosVector const& vacated);
+
+			/**
+			 * @brief Appends the escape sequences that draw the buffer: vacated cells as spaces, then every visible cell
+			 * @param out Destination string
+			 * @param buffer Screen buffer of the current frame; its vacated positions are cleared
+			 * @param clipWidth Visible columns; cells beyond them are skipped
+			 * @param clipHeight Visible rows; cells beyond them are skipped
+			 *
+			 * Needs no terminal, so it can be measured apart from the write.
+			 */
+			static void s_EncodeBuffer(std::string& out, ScreenBuffer& buffer, unsigned int clipWidth, unsigned int clipHeight);
+
+			/**
+			 * @brief Like `Terminal::s_EncodeBuffer`, but erases the given positions and leaves the buffer alone
+			 * @param out Destination string
+			 * @param buffer Screen buffer of the current frame
+			 * @param vacated Positions to draw as spaces before the visible cells
+			 * @param clipWidth Visible columns; cells beyond them are skipped
+			 * @param clipHeight Visible rows; cells beyond them are skipped
+			 * @param jobs Threads to encode bands of `s_EncodeBandRows` rows on, joined in row order; nullptr encodes on the caller
+			 */
+			static void s_EncodeFrame(std::string& out, ScreenBuffer const& buffer, PosVector const& vacated, unsigned int clipWidth, unsigned int clipHeight,
+				FrameJobs* jobs = nullptr);
+
+			/** @brief Rows per band when `Terminal::s_EncodeFrame` runs on Snake::FrameJobs */
+			static constexpr unsigned int s_EncodeBandRows = 8;
+
+			/**
+			 * @brief Encodes the frames of `Terminal::render` on these threads from now on
+			 * @param jobs Threads, or nullptr to encode on the game thread; must stay alive while frames are rendered
+			 */
+			void setFrameJobs(FrameJobs* jobs) noexcept;
+
+			/**
+			 * @brief Draws a flat frame, e.g. one decoded from a recording
+			 * @param cells Frame of `width * height` cells, row by row
+			 * @param previous Frame currently on screen, or nullptr to repaint everything
+			 * @param width Frame width
+			 * @param height Frame height
+			 */
+			void renderCells(const PackedCell* cells, const PackedCell* previous, unsigned int width, unsigned int height);
+
+			/**
+			 * @brief Appends the escape sequences that turn `previous` into `cells` on screen
+			 * @param out Destination string
+			 * @param cells Frame of `width * height` cells, row by row
+			 * @param previous Frame currently on screen, or nullptr if the screen is blank
+			 * @param width Frame width
+			 * @param height Frame height
+			 * @param clipWidth Visible columns; cells beyond them are skipped
+			 * @param clipHeight Visible rows; cells beyond them are skipped
+			 *
+			 * Needs no terminal, so it also serves exports such as asciicast.
+			 */
+			static void s_EncodeCells(std::string& out, const PackedCell* cells, const PackedCell* previous,
+				unsigned int width, unsigned int height, unsigned int clipWidth, unsigned int clipHeight);
+
+			/**
+			 * @brief Size of the last frame handed to the writer, in bytes
+			 */
+			std::size_t lastFrameBytes() const noexcept;
+			/**
+			 * @brief Writes a line of text on the terminal row below the board, replacing what was there
+			 * @param text Text to show; empty clears the row. Kept, and drawn again by full repaints
+			 */
+			void status(std::string_view text);
+
 			void hideCursor();
 			void showCursor();
 			void moveCursor(unsigned int row, unsigned int col);
@@ -27,8 +110,38 @@ namespace Snake
 		private:
 			unsigned int m_width = 0;
 			unsigned int m_height = 0;
+
+			/** @brief Writes all output off the game thread */
+			TtyWriter m_writer;
+
+			/** @brief Encoded frame, reused between renders */
+			std::string m_frame;
+
+			/** @brief Text of the status row, for full repaints */
+			std::string m_status;
+
+			std::size_t m_lastFrameBytes = 0;
+
+			FrameJobs* m_jobs = nullptr;
+
+			/**
+			 * @brief Hands `m_frame` to the writer
+			 */
+			void submitFrame();
+
 			static std::string toUnicode(uint32_t codepoint) noexcept;
-			void recoverFromOutputFailure();
+			static void s_AppendCursor(std::string& out, unsigned int row, unsigned int col);
+
+			/**
+			 * @brief Appends the terminal setup: alternate screen, no line wrap, cleared screen, hidden cursor, focus reporting
+			 */
+			static void s_AppendSetup(std::string& out);
+
+			/**
+			 * @brief Clears `m_frame`, then starts it with the setup and the status row if the writer asks for a resync
+			 * @return true if the frame has to draw everything
+			 */
+			bool beginFrame();
 
 #ifdef _WIN32
 			HANDLE m_hStdin;
@@ -48,10 +161,14 @@ namespace Snake
 		constexpr const char* ALTERNATE_SCREEN = "\x1b[?1049h";
 		constexpr const char* EXIT_ALTERNATE_SCREEN = "\x1b[?1049l";
 		constexpr const char* TERMINAL_RESET = "\033c";
+		constexpr const char* DISABLE_LINE_WRAP = "\x1b[?7l";
 		constexpr const char* CLEAR_SCREEN = "\x1b[2J";
 		constexpr const char* CURSOR_HOME = "\x1b[H";
 		constexpr const char* HIDE_CURSOR = "\x1b[?25l";
 		constexpr const char* SHOW_CURSOR = "\x1b[?25h";
+		constexpr const char* ENABLE_FOCUS_REPORTING = "\x1b[?1004h"; // focus changes arrive as ESC [ I / ESC [ O
+		constexpr const char* DISABLE_FOCUS_REPORTING = "\x1b[?1004l";
+		constexpr const char* CLEAR_LINE = "\x1b[2K";
 		constexpr const char* RESET_ATTRS = "\x1b[0m";
 		constexpr const char* FG_COLOR_256 = "\x1b[38;5;";
 		constexpr const char* BG_COLOR_256 = "\x1b[48;5;";
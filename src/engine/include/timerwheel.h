@@ -0,0 +1,243 @@
+#pragma once
+
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace Snake
+{
+	/**
+	 * @class TimerWheel
+	 * @brief Hierarchical timer wheel counting game ticks, for timed game events such as food spawning.
+	 *
+	 * @details
+	 * `s_Levels` wheels of `s_Slots` slots each: level 0 holds the timers due in the next 64 ticks one tick
+	 * per slot, level 1 those due in the next 4096 ticks 64 ticks per slot, and so on. Scheduling links the
+	 * timer into one slot and cancelling unlinks it, both O(1). `advance` fires the slot of the new tick, and
+	 * once every 64 ticks moves the next slot of a higher level down; a timer moves down at most `s_Levels - 1`
+	 * times, so however many are pending an advance never scans them.
+	 *
+	 * Timers live in a pool reused through a free list and are identified by index and generation, so a
+	 * stale Snake::TimerWheel::TimerId of a fired or cancelled timer is simply ignored.
+	 *
+	 * Coroutines returning Snake::TimerWheel::Script can `co_await wheel.ticks(n)` to run a sequence over
+	 * several ticks. Everything runs on the thread that calls `advance`; timers are not thread safe.
+	 */
+	class TimerWheel
+	{
+		public:
+			/** @brief Identifies a scheduled timer; 0 is never a valid one */
+			using TimerId = uint64_t;
+
+			using Callback = std::function<void()>;
+
+			static constexpr unsigned int s_SlotBits = 6;
+			static constexpr unsigned int s_Slots = 1u << s_SlotBits;
+			static constexpr unsigned int s_Levels = 5;
+
+			/** @brief Longest delay a timer can be scheduled with, about 12 days at 1000 Hz */
+			static constexpr uint64_t s_MaxDelay = (uint64_t(1) << (s_SlotBits * s_Levels)) - 1;
+
+			class Script;
+			class Delay;
+
+			TimerWheel();
+
+			TimerWheel(TimerWheel const&) = delete;
+			TimerWheel& operator=(TimerWheel const&) = delete;
+
+			/**
+			 * @brief Calls `callback` from the `delay`th `advance` from now
+			 * @param delay Ticks, 1 to `s_MaxDelay`
+			 * @param callback Runs inside `advance`; may schedule and cancel timers
+			 * @return TimerId To cancel the timer with
+			 * @throws std::invalid_argument if `delay` is out of range
+			 */
+			TimerId schedule(uint64_t delay, Callback callback);
+
+			/**
+			 * @brief Cancels a pending timer
+			 * @return false if the timer already fired or was cancelled
+			 */
+			bool cancel(TimerId id) noexcept;
+
+			/**
+			 * @brief Moves on by one tick and fires the timers now due
+			 *
+			 * Timers due on the same tick fire in an order that depends only on how they were scheduled and
+			 * cancelled, so games stay deterministic, but is otherwise unspecified.
+			 */
+			void advance();
+
+			/** @brief Ticks advanced since construction */
+			uint64_t now() const noexcept;
+
+			/** @brief Timers scheduled and not yet fired or cancelled */
+			std::size_t pending() const noexcept;
+
+			/**
+			 * @brief Awaitable resuming the calling Snake::TimerWheel::Script `n` ticks later, or at once if `n` is 0
+			 */
+			Delay ticks(uint64_t n) noexcept;
+
+		private:
+			static constexpr uint32_t s_None = UINT32_MAX;
+
+			struct Timer
+			{
+				uint64_t due = 0;
+				Callback callback;
+				uint32_t prev = s_None;
+				uint32_t next = s_None;
+				uint32_t generation = 1;
+				/** @brief Slot the timer is linked into as `level * s_Slots + slot`, `s_None` if free */
+				uint32_t slot = s_None;
+			};
+
+			uint64_t m_now = 0;
+			std::size_t m_pending = 0;
+			std::vector<Timer> m_timers;
+			uint32_t m_free = s_None;
+			/** @brief First timer of each slot's list, indexed as `Timer::slot` */
+			std::array<uint32_t, s_Levels * s_Slots> m_heads;
+
+			/** @brief Links a timer into the slot matching its distance from `m_now` */
+			void link(uint32_t index) noexcept;
+			void unlink(uint32_t index) noexcept;
+
+			/** @brief Moves the timers of a slot of `level` down to the levels below */
+			void cascade(unsigned int level) noexcept;
+	};
+
+	/**
+	 * @class TimerWheel::Script
+	 * @brief Coroutine driven by a Snake::TimerWheel, e.g. `TimerWheel::Script blink() { show(); co_await wheel.ticks(4); hide(); }`.
+	 *
+	 * @details
+	 * A script runs as soon as it is called, up to its first `co_await`, and is resumed by `advance`.
+	 * The Script owns the coroutine: destroying or reassigning it stops the sequence where it is and
+	 * cancels its pending timer, so the wheel must outlive it. An exception thrown by the script
+	 * propagates out of the call or of the `advance` that resumed it.
+	 */
+	class TimerWheel::Script
+	{
+		public:
+			struct promise_type
+			{
+				TimerWheel* wheel = nullptr;
+				TimerId timer = 0;
+
+				Script get_return_object() noexcept
+				{
+					return Script(std::coroutine_handle<promise_type>::from_promise(*this));
+				}
+
+				std::suspend_never initial_suspend() noexcept
+				{
+					return {};
+				}
+
+				/** @brief Stays suspended at the end so `Script::done` can tell, until the Script destroys it */
+				std::suspend_always final_suspend() noexcept
+				{
+					return {};
+				}
+
+				void return_void() noexcept
+				{}
+
+				void unhandled_exception()
+				{
+					throw;
+				}
+			};
+
+			Script() noexcept = default;
+
+			Script(Script&& other) noexcept
+				: m_handle(std::exchange(other.m_handle, nullptr))
+			{}
+
+			Script& operator=(Script&& other) noexcept
+			{
+				if (this != &other)
+				{
+					stop();
+					m_handle = std::exchange(other.m_handle, nullptr);
+				}
+
+				return *this;
+			}
+
+			~Script()
+			{
+				stop();
+			}
+
+			/** @brief Whether the script ran to its end, or is empty */
+			bool done() const noexcept
+			{
+				return !m_handle || m_handle.done();
+			}
+
+		private:
+			std::coroutine_handle<promise_type> m_handle;
+
+			explicit Script(std::coroutine_handle<promise_type> handle) noexcept
+				: m_handle(handle)
+			{}
+
+			void stop() noexcept
+			{
+				if (m_handle)
+				{
+					if (m_handle.promise().wheel)
+					{
+						m_handle.promise().wheel->cancel(m_handle.promise().timer);
+					}
+
+					m_handle.destroy();
+					m_handle = nullptr;
+				}
+			}
+	};
+
+	/**
+	 * @class TimerWheel::Delay
+	 * @brief Returned by `TimerWheel::ticks`; only a Snake::TimerWheel::Script can await it
+	 */
+	class TimerWheel::Delay
+	{
+		public:
+			Delay(TimerWheel& wheel, uint64_t ticks) noexcept
+				: m_wheel(wheel), m_ticks(ticks)
+			{}
+
+			bool await_ready() const noexcept
+			{
+				return m_ticks == 0;
+			}
+
+			void await_suspend(std::coroutine_handle<Script::promise_type> handle)
+			{
+				handle.promise().wheel = &m_wheel;
+				handle.promise().timer = m_wheel.schedule(m_ticks, [handle]() { handle.resume(); });
+			}
+
+			void await_resume() const noexcept
+			{}
+
+		private:
+			TimerWheel& m_wheel;
+			uint64_t m_ticks;
+	};
+
+	inline TimerWheel::Delay TimerWheel::ticks(uint64_t n) noexcept
+	{
+		return Delay(*this, n);
+	}
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+/**
+ * @brief Records the enclosing scope as a trace event, e.g. `SNAKE_TRACE_SCOPE("update");`
+ *
+ * Costs one relaxed load when tracing is off. The name must be a string literal.
+ */
+#define SNAKE_TRACE_SCOPE(name) SNAKE_TRACE_SCOPE_NAMED(name, SNAKE_TRACE_CAT(snakeTraceScope_, __LINE__))
+#define SNAKE_TRACE_SCOPE_NAMED(name, var) ::Snake::Trace::Scope var(name)
+
+// Two levels, so `__LINE__` is expanded before it is pasted
+#define SNAKE_TRACE_CAT(a, b) SNAKE_TRACE_CAT_I(a, b)
+#define SNAKE_TRACE_CAT_I(a, b) a##b
+
+namespace Snake
+{
+	/**
+	 * @namespace Snake::Trace
+	 * @brief Opt-in timeline of what each thread did, exported as Chrome Trace Event JSON (`--trace=<path>`).
+	 *
+	 * @details
+	 * Every thread that records gets a ring of `EVENTS_PER_THREAD` events, allocated once on its first event;
+	 * recording writes one slot and never locks or allocates. When a ring is full the oldest events are
+	 * overwritten, so a trace always ends with the most recent events. Scopes are stored as complete events
+	 * (start and duration), so an overwritten begin never leaves an end without it.
+	 *
+	 * The file opens in `chrome://tracing` or https://ui.perfetto.dev.
+	 */
+	namespace Trace
+	{
+		/**
+		 * @brief Events kept per thread, about 24 bytes each
+		 */
+		constexpr std::size_t EVENTS_PER_THREAD = 1 << 18;
+
+		/**
+		 * @brief Whether events are recorded; set by `Trace::start`
+		 */
+		extern std::atomic<bool> g_enabled;
+
+		/**
+		 * @brief Starts recording and names the calling thread "game"
+		 *
+		 * Call before the threads to trace are started.
+		 */
+		void start();
+
+		/**
+		 * @brief Stops recording and writes every thread's events as Chrome Trace Event JSON
+		 * @param path Destination file
+		 * @return false if the file could not be written
+		 *
+		 * Call once the traced threads are done, e.g. after the game is destroyed.
+		 */
+		bool write(std::filesystem::path const& path);
+
+		/**
+		 * @brief Names the calling thread in the trace
+		 * @param name String literal
+		 */
+		void nameThread(const char* name);
+
+		/**
+		 * @brief Records a zero length event, e.g. a key arriving
+		 * @param name String literal
+		 */
+		void instant(const char* name);
+
+		/**
+		 * @brief Records a finished span of the calling thread
+		 * @param name String literal
+		 * @param start When the span began
+		 * @param end When the span ended
+		 */
+		void complete(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+		/**
+		 * @brief Records its own lifetime as a span, see `SNAKE_TRACE_SCOPE`
+		 */
+		class Scope
+		{
+			public:
+				explicit Scope(const char* name) noexcept
+					: m_name(g_enabled.load(std::memory_order_relaxed) ? name : nullptr)
+				{
+					if (m_name)
+					{
+						m_start = std::chrono::steady_clock::now();
+					}
+				}
+
+				~Scope()
+				{
+					if (m_name)
+					{
+						complete(m_name, m_start, std::chrono::steady_clock::now());
+					}
+				}
+
+				Scope(Scope const&) = delete;
+				Scope& operator=(Scope const&) = delete;
+
+			private:
+				const char* m_name;
+				std::chrono::steady_clock::time_point m_start;
+		};
+	};
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace Snake
+{
+	/**
+	 * @class TtyWriter
+	 * @brief Writes terminal output from a background thread, so a terminal that stops reading never blocks the game.
+	 *
+	 * @details
+	 * Output is either control bytes (`TtyWriter::write`: setup, status line, ...), which are never dropped,
+	 * or frames (`TtyWriter::frame`), of which at most one waits behind the one being written. A newer frame replaces
+	 * a waiting one; the dropped frame's changes are then missing on screen, so `TtyWriter::takeResync` asks the
+	 * caller for a full repaint. A frame already partly written is always finished, so escape sequences stay whole.
+	 *
+	 * On POSIX the thread opens the terminal again with `O_NONBLOCK`, which leaves the flags of stdin and stdout
+	 * alone, and waits for it to drain with poll. A failed write is logged and the unwritten output discarded;
+	 * recovery is again a resync, with no waiting on the game thread. Output that is not a terminal is written with
+	 * blocking writes, still off the game thread. On Windows output is written synchronously.
+	 */
+	class TtyWriter
+	{
+		public:
+			/**
+			 * @brief Opens the terminal and starts the writer thread
+			 */
+			TtyWriter();
+
+			/**
+			 * @brief Waits up to `s_CloseTimeout` for pending output, then stops the thread
+			 */
+			~TtyWriter();
+
+			TtyWriter(TtyWriter const&) = delete;
+			TtyWriter& operator=(TtyWriter const&) = delete;
+
+			/**
+			 * @brief Queues control bytes, which are never dropped
+			 *
+			 * A frame still waiting is committed ahead of them, so output keeps the order of the calls.
+			 */
+			void write(std::string_view bytes);
+
+			/**
+			 * @brief Queues a frame, replacing one that is still waiting
+			 * @param frame Encoded frame; swapped with a free buffer, so its capacity is reused for the next one
+			 */
+			void frame(std::string& frame);
+
+			/**
+			 * @brief Whether a frame was dropped or output failed since the last call
+			 * @return true once per such event; the next frame should repaint the whole screen
+			 */
+			bool takeResync() noexcept;
+
+			/**
+			 * @brief Waits until all queued output is written
+			 * @param timeout Longest wait
+			 * @return false if output was still pending after `timeout`
+			 */
+			bool flush(std::chrono::milliseconds timeout);
+
+			/** @brief Frames replaced before they were written */
+			uint64_t framesDropped() const noexcept;
+
+			/** @brief Longest wait for pending output on destruction */
+			static constexpr std::chrono::milliseconds s_CloseTimeout{ 1000 };
+
+		private:
+			/** @brief Guards `m_control`, `m_frame`, `m_hasFrame` and `m_busy` */
+			std::mutex m_mutex;
+
+			/** @brief Signalled when the thread has written everything */
+			std::condition_variable m_drained;
+
+			std::string m_control;
+			std::string m_frame;
+			bool m_hasFrame = false;
+
+			/** @brief The thread holds output it has not finished writing */
+			bool m_busy = false;
+
+			std::atomic<bool> m_resync{ false };
+			std::atomic<uint64_t> m_dropped{ 0 };
+			std::atomic<bool> m_stop{ false };
+
+			/** @brief Descriptor written to: the terminal opened non-blocking, or a duplicate of stdout */
+			int m_fd = -1;
+
+			/** @brief Status flags of the duplicated stdout before O_NONBLOCK was set on it, -1 if not a duplicate */
+			int m_stdoutFlags = -1;
+
+			/** @brief Self pipe waking the thread: read end, write end */
+			int m_wake[2] = { -1, -1 };
+
+			std::thread m_thread;
+
+			void run();
+			void wake() noexcept;
+	};
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace Snake
+{
+	/**
+	 * @namespace Snake::Varint
+	 * @brief Unsigned LEB128 encoding shared by the binary file formats.
+	 *
+	 * 7 bits per byte, high bit set on all but the last byte.
+	 */
+	namespace Varint
+	{
+		/**
+		 * @brief Appends `value` to `out`
+		 */
+		inline void append(std::vector<uint8_t>& out, uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				out.push_back(static_cast<uint8_t>(value | 0x80));
+				value >>= 7;
+			}
+
+			out.push_back(static_cast<uint8_t>(value));
+		}
+
+		/**
+		 * @brief Decodes the varint at `offset` and moves `offset` past it
+		 * @throws std::runtime_error if the data ends before the varint does
+		 */
+		inline uint64_t read(const uint8_t* data, size_t size, size_t& offset)
+		{
+			uint64_t value = 0;
+
+			for (unsigned int shift = 0; shift < 64; shift += 7)
+			{
+				if (offset >= size)
+					throw std::runtime_error("Truncated varint");
+
+				uint8_t byte = data[offset++];
+				value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+				if ((byte & 0x80) == 0)
+				{
+					return value;
+				}
+			}
+
+			throw std::runtime_error("Malformed varint");
+		}
+
+		/**
+		 * @brief Whether a whole varint starts at `offset`, for streams that arrive in pieces
+		 */
+		inline bool complete(const uint8_t* data, size_t size, size_t offset)
+		{
+			for (size_t i = offset; i < size && i < offset + 10; ++i)
+			{
+				if ((data[i] & 0x80) == 0)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		/**
+		 * @brief Appends `value` as 8 little endian bytes
+		 */
+		inline void appendFixed64(std::vector<uint8_t>& out, uint64_t value)
+		{
+			for (int i = 0; i < 8; ++i)
+			{
+				out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+			}
+		}
+
+		/**
+		 * @brief Reads 8 little endian bytes at `data`
+		 */
+		inline uint64_t readFixed64(const uint8_t* data) noexcept
+		{
+			uint64_t value = 0;
+
+			for (int i = 0; i < 8; ++i)
+			{
+				value |= static_cast<uint64_t>(data[i]) << (8 * i);
+			}
+
+			return value;
+		}
+	};
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Snake
+{
+	/**
+	 * @class WorkerPool
+	 * @brief Persistent worker threads for data parallel loops.
+	 *
+	 * @details
+	 * Threads are started once and sleep between jobs. The calling thread takes part in every job,
+	 * so a pool of size 1 runs everything inline.
+	 *
+	 * Every thread starts a job with an equal, contiguous share of the chunks in its own slot and claims
+	 * them front to back. A thread that runs out steals the back half of the largest remaining share, so
+	 * threads stay busy when some chunks are slower than others (or a thread got descheduled) without
+	 * all of them contending on one counter.
+	 */
+	class WorkerPool
+	{
+		public:
+			/**
+			 * @brief Starts the workers
+			 * @param threads Total number of threads taking part in a job, including the caller. 0 uses all cores.
+			 */
+			explicit WorkerPool(unsigned int threads = 0);
+
+			/**
+			 * @brief Stops and joins the workers
+			 */
+			~WorkerPool();
+
+			WorkerPool(WorkerPool const&) = delete;
+			WorkerPool& operator=(WorkerPool const&) = delete;
+
+			/**
+			 * @brief Number of threads taking part in a job, including the caller
+			 */
+			unsigned int size() const noexcept;
+
+			/**
+			 * @brief Index of the calling thread within the job it is running
+			 * @return 0 for the thread that called `parallelFor`, `1` to `size() - 1` for the workers
+			 *
+			 * Lets a job keep per thread state, e.g. one search tree per thread.
+			 */
+			static unsigned int s_ThreadIndex() noexcept;
+
+			/**
+			 * @brief Calls `fn(begin, end)` over `[0, count)` in chunks of `grain` items, in parallel
+			 * @param count Number of items
+			 * @param grain Items per chunk
+			 * @param fn Callable taking `(size_t begin, size_t end)`; must be safe to call concurrently
+			 *
+			 * Returns once every chunk has been processed.
+			 * @throws std::length_error if `count` does not fit in 32 bits
+			 */
+			template <typename Fn>
+			void parallelFor(size_t count, size_t grain, Fn&& fn)
+			{
+				Job job{
+					&fn,
+					[](void* ctx, size_t begin, size_t end) { (*static_cast<std::remove_reference_t<Fn>*>(ctx))(begin, end); },
+					count,
+					grain == 0 ? 1 : grain
+				};
+
+				run(job);
+			}
+
+		private:
+			/**
+			 * @brief Type erased parallel loop
+			 */
+			struct Job
+			{
+				void* ctx;
+				void (*invoke)(void*, size_t, size_t);
+				size_t count;
+				size_t grain;
+			};
+
+			/**
+			 * @brief Items of the current job not claimed yet by one thread, packed as `begin | end << 32`
+			 *
+			 * The owner advances `begin`, thieves lower `end`; both with a compare and swap on the same word.
+			 */
+			struct alignas(64) Slot
+			{
+				std::atomic<uint64_t> range{0};
+			};
+
+			std::vector<std::thread> m_threads;
+			Job m_job{};
+
+			/** @brief One slot per thread, the caller's first */
+			std::unique_ptr<Slot[]> m_slots;
+
+			/** @brief Workers that have not finished the current job yet */
+			alignas(64) std::atomic<unsigned int> m_active{0};
+
+			/** @brief Bumped for every job; workers sleep on it */
+			std::atomic<uint32_t> m_generation{0};
+
+			std::atomic<bool> m_stop{false};
+
+			void run(Job const& job);
+			void work(Job const& job, unsigned int self);
+
+			/**
+			 * @brief Moves the back half of the largest share of another thread into `self`'s slot
+			 * @return false if no thread has chunks left to take
+			 */
+			bool steal(unsigned int self, size_t grain);
+
+			void workerLoop(unsigned int index);
+	};
+};
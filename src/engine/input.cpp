@@ -1,4 +1,5 @@
 #include "include/input.h"
+#include "include/flightrecorder.h"
 
 #include <csignal>
 #include <unordered_map>
@@ -11,6 +12,7 @@
 #include <termios.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
 #endif
 
 namespace Snake
@@ -18,11 +20,14 @@ namespace Snake
 	namespace Input
 	{
 		std::atomic<bool> g_exitRequested{false};
+		std::atomic<bool> g_memoryReportRequested{false};
 		static const std::unordered_map<int, KeyKind> g_keyMap = {
 			{'A', KeyKind::ArrowUp},
 			{'B', KeyKind::ArrowDown},
 			{'C', KeyKind::ArrowRight},
-			{'D', KeyKind::ArrowLeft}
+			{'D', KeyKind::ArrowLeft},
+			{'I', KeyKind::FocusIn},
+			{'O', KeyKind::FocusOut}
 		};
 
 #ifndef _WIN32
@@ -102,6 +107,8 @@ namespace Snake
 								case 'B': return { KeyKind::ArrowDown, 0 };
 								case 'C': return { KeyKind::ArrowRight, 0 };
 								case 'D': return { KeyKind::ArrowLeft, 0 };
+								case 'I': return { KeyKind::FocusIn, 0 };
+								case 'O': return { KeyKind::FocusOut, 0 };
 							}
 						}
 					}
@@ -158,12 +165,50 @@ namespace Snake
 #endif
 		}
 
+		void waitForInput()
+		{
+#if defined(_WIN32)
+			WaitForSingleObject(GetStdHandle(STD_INPUT_HANDLE), INFINITE);
+#else
+			pollfd in{ STDIN_FILENO, POLLIN, 0 };
+
+			// EINTR (e.g. SIGINT) returns too, so the caller can check g_exitRequested
+			::poll(&in, 1, -1);
+#endif
+		}
+
+		void waitForInput(std::chrono::nanoseconds timeout)
+		{
+			if (timeout <= std::chrono::nanoseconds::zero())
+			{
+				return;
+			}
+
+			const auto ms = std::chrono::ceil<std::chrono::milliseconds>(timeout).count();
+
+#if defined(_WIN32)
+			WaitForSingleObject(GetStdHandle(STD_INPUT_HANDLE), static_cast<DWORD>(ms));
+#else
+			pollfd in{ STDIN_FILENO, POLLIN, 0 };
+
+			::poll(&in, 1, static_cast<int>(ms));
+#endif
+		}
+
 		void signalHandler(int signal)
 		{
 			if (signal == SIGINT)
 			{
 				g_exitRequested = true;
+
+				FlightRecorder::dump(FlightRecorder::Reason::Interrupt, signal); // here, not on the way out: a hung game never gets there
 			}
+#ifdef SIGUSR1
+			else if (signal == SIGUSR1)
+			{
+				g_memoryReportRequested = true;
+			}
+#endif
 		}
 
 		void restoreTerminal()
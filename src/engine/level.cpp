@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "include/glyphs.h"
+#include "include/level.h"
+
+namespace Snake
+{
+	namespace
+	{
+		constexpr uint64_t s_Align8(uint64_t offset) noexcept
+		{
+			return (offset + 7) & ~uint64_t(7);
+		}
+
+		/**
+		 * @brief Whether `count` items of `itemSize` bytes starting at `offset` fit in a file of `size` bytes, without overflowing
+		 */
+		constexpr bool s_SectionFits(uint64_t offset, uint64_t count, uint64_t itemSize, uint64_t size) noexcept
+		{
+			return offset % 8 == 0 && offset <= size && count <= (size - offset) / itemSize;
+		}
+
+		/**
+		 * @brief Whether a snake spawned at `spawn` lies inside the border and clear of obstacles
+		 * @param blocked Callable telling whether a position holds an obstacle
+		 */
+		template <typename Blocked>
+		bool s_SpawnFits(LevelFormat::Spawn const& spawn, unsigned int width, unsigned int height, Blocked&& blocked)
+		{
+			if (spawn.direction > static_cast<uint32_t>(::Snake::Snake::Direction::Right))
+			{
+				return false;
+			}
+
+			for (unsigned int i = 0; i < LevelFormat::SPAWN_LENGTH; ++i)
+			{
+				const auto [x, y] = LevelFormat::s_SpawnCell(spawn, i);
+
+				if (x == 0 || y == 0 || x >= width - 1 || y >= height - 1 || blocked(x, y))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+	};
+
+	Level::Level(std::filesystem::path const& path)
+		: m_file(path)
+	{
+		static_assert(std::endian::native == std::endian::little, "level files are read in place and are little-endian");
+
+		const uint64_t size = m_file.size();
+		LevelFormat::Header header;
+
+		if (size < sizeof(header))
+			throw std::runtime_error("Truncated level file " + path.string());
+
+		std::memcpy(&header, m_file.data(), sizeof(header));
+
+		if (std::memcmp(header.magic, LevelFormat::MAGIC, sizeof(header.magic)) != 0)
+			throw std::runtime_error("Not a level file: " + path.string());
+
+		if (header.version != LevelFormat::VERSION)
+			throw std::runtime_error("Unsupported level version " + std::to_string(header.version) + " in " + path.string());
+
+		if (header.width < Options::s_MinWidth || header.height < Options::s_MinHeight || header.spawnCount == 0)
+			throw std::runtime_error("Invalid level header in " + path.string());
+
+		m_width = header.width;
+		m_height = header.height;
+		m_obstacleCells = header.obstacleCells;
+		m_rowWords = LevelFormat::s_RowWords(header.width);
+
+		// Bounds of each section only; runs are clipped when drawn, so a damaged file cannot reach outside the board
+		if (!s_SectionFits(header.spawnsOffset, header.spawnCount, sizeof(LevelFormat::Spawn), size) ||
+			!s_SectionFits(header.runsOffset, header.runCount, sizeof(LevelFormat::Run), size) ||
+			!s_SectionFits(header.bitmapOffset, uint64_t(m_height) * m_rowWords, sizeof(uint64_t), size))
+			throw std::runtime_error("Truncated level file " + path.string());
+
+		// The mapping is page aligned and every section starts on an 8 byte boundary
+		m_spawns = { reinterpret_cast<const LevelFormat::Spawn*>(m_file.data() + header.spawnsOffset), header.spawnCount };
+		m_runs = { reinterpret_cast<const LevelFormat::Run*>(m_file.data() + header.runsOffset), static_cast<size_t>(header.runCount) };
+		m_bitmap = reinterpret_cast<const uint64_t*>(m_file.data() + header.bitmapOffset);
+
+		for (LevelFormat::Spawn const& spawn : m_spawns)
+		{
+			if (!s_SpawnFits(spawn, m_width, m_height, [this](unsigned int x, unsigned int y) { return blocked(x, y); }))
+				throw std::runtime_error("Spawn at " + std::to_string(spawn.x) + "," + std::to_string(spawn.y) + " does not fit the level in " + path.string());
+		}
+	}
+
+	unsigned int Level::width() const noexcept
+	{
+		return m_width;
+	}
+
+	unsigned int Level::height() const noexcept
+	{
+		return m_height;
+	}
+
+	uint64_t Level::obstacleCells() const noexcept
+	{
+		return m_obstacleCells;
+	}
+
+	std::span<const LevelFormat::Spawn> Level::spawns() const noexcept
+	{
+		return m_spawns;
+	}
+
+	std::span<const LevelFormat::Run> Level::runs() const noexcept
+	{
+		return m_runs;
+	}
+
+	LevelFormat::Header compileLevel(std::istream& map, std::filesystem::path const& path)
+	{
+		std::vector<std::string> lines;
+		size_t width = 0;
+
+		for (std::string line; std::getline(map, line); )
+		{
+			if (!line.empty() && line.back() == '\r')
+			{
+				line.pop_back();
+			}
+
+			width = std::max(width, line.size());
+			lines.push_back(std::move(line));
+		}
+
+		if (width < Options::s_MinWidth || lines.size() < Options::s_MinHeight || width > UINT32_MAX || lines.size() > UINT32_MAX)
+			throw std::runtime_error("Level must be at least " + std::to_string(Options::s_MinWidth) + "x" + std::to_string(Options::s_MinHeight) + " including the border");
+
+		LevelFormat::Header header{};
+		std::memcpy(header.magic, LevelFormat::MAGIC, sizeof(header.magic));
+		header.version = LevelFormat::VERSION;
+		header.width = static_cast<uint32_t>(width);
+		header.height = static_cast<uint32_t>(lines.size());
+
+		const uint64_t rowWords = LevelFormat::s_RowWords(header.width);
+		std::vector<uint64_t> bitmap(header.height * rowWords, 0);
+		std::vector<LevelFormat::Spawn> spawns;
+		std::vector<LevelFormat::Run> runs;
+
+		// The outermost ring belongs to the border, whatever the map has there
+		for (uint32_t y = 1; y + 1 < header.height; ++y)
+		{
+			std::string const& line = lines[y];
+
+			for (uint32_t x = 1; x + 1 < header.width; ++x)
+			{
+				const char c = x < line.size() ? line[x] : ' ';
+
+				switch (c)
+				{
+					case '#':
+						bitmap[y * rowWords + x / 64] |= uint64_t(1) << (x % 64);
+						++header.obstacleCells;
+
+						if (!runs.empty() && runs.back().y == y && runs.back().x + runs.back().length == x)
+						{
+							++runs.back().length;
+						}
+						else
+						{
+							runs.push_back({ y, x, 1 });
+						}
+						break;
+					case '^':
+						spawns.push_back({ x, y, static_cast<uint32_t>(::Snake::Snake::Direction::Up) });
+						break;
+					case 'v':
+						spawns.push_back({ x, y, static_cast<uint32_t>(::Snake::Snake::Direction::Down) });
+						break;
+					case '<':
+						spawns.push_back({ x, y, static_cast<uint32_t>(::Snake::Snake::Direction::Left) });
+						break;
+					case '>':
+						spawns.push_back({ x, y, static_cast<uint32_t>(::Snake::Snake::Direction::Right) });
+						break;
+					default:
+						break;
+				}
+			}
+		}
+
+		if (spawns.empty())
+			throw std::runtime_error("Level has no spawn point (one of < > ^ v)");
+
+		auto blocked = [&](unsigned int x, unsigned int y) { return (bitmap[y * rowWords + x / 64] >> (x % 64) & 1) != 0; };
+
+		for (LevelFormat::Spawn const& spawn : spawns)
+		{
+			if (!s_SpawnFits(spawn, header.width, header.height, blocked))
+				throw std::runtime_error("Spawn at " + std::to_string(spawn.x) + "," + std::to_string(spawn.y) + " needs " +
+					std::to_string(LevelFormat::SPAWN_LENGTH - 1) + " free cells behind it inside the border");
+		}
+
+		header.spawnCount = static_cast<uint32_t>(spawns.size());
+		header.runCount = runs.size();
+		header.spawnsOffset = sizeof(header);
+		header.runsOffset = s_Align8(header.spawnsOffset + spawns.size() * sizeof(LevelFormat::Spawn));
+		header.bitmapOffset = s_Align8(header.runsOffset + runs.size() * sizeof(LevelFormat::Run));
+
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+
+		if (!out.is_open())
+			throw std::runtime_error("Failed to create " + path.string());
+
+		const char padding[8] = {};
+
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(spawns.data()), static_cast<std::streamsize>(spawns.size() * sizeof(LevelFormat::Spawn)));
+		out.write(padding, static_cast<std::streamsize>(header.runsOffset - header.spawnsOffset - spawns.size() * sizeof(LevelFormat::Spawn)));
+		out.write(reinterpret_cast<const char*>(runs.data()), static_cast<std::streamsize>(runs.size() * sizeof(LevelFormat::Run)));
+		out.write(padding, static_cast<std::streamsize>(header.bitmapOffset - header.runsOffset - runs.size() * sizeof(LevelFormat::Run)));
+		out.write(reinterpret_cast<const char*>(bitmap.data()), static_cast<std::streamsize>(bitmap.size() * sizeof(uint64_t)));
+
+		if (!out.flush())
+			throw std::runtime_error("Failed to write " + path.string());
+
+		return header;
+	}
+
+	int runCompileLevel(Options const& options)
+	{
+		try
+		{
+			std::ifstream map(options.compileLevelPath);
+
+			if (!map.is_open())
+				throw std::runtime_error("Failed to open " + options.compileLevelPath);
+
+			const LevelFormat::Header header = compileLevel(map, options.levelPath);
+
+			const auto start = std::chrono::steady_clock::now();
+			Level level(options.levelPath);
+			const auto loaded = std::chrono::steady_clock::now() - start;
+
+			std::cout << "compiled " << options.levelPath << ": " << header.width << "x" << header.height << ", "
+				<< header.obstacleCells << " obstacle cells in " << header.runCount << " runs, "
+				<< header.spawnCount << " spawns, loads in "
+				<< std::chrono::duration_cast<std::chrono::microseconds>(loaded).count() << " us" << std::endl;
+
+			return 0;
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+
+			return 1;
+		}
+	}
+
+	Obstacles::Obstacles(Level const& level)
+		: BaseObject(CollisionType::SOLID, Attributes::NONE),
+		  m_level(level),
+		  m_cell(s_MakeCell(Cell{ .codepoint = TGLYPHS::OBSTACLE }))
+	{
+		setCollisionFilter(CollisionLayer::WALL, CollisionLayer::SNAKE);
+	}
+
+	CollisionResult Obstacles::getCollisionResult(BaseObject const& other) const
+	{
+		if (other.getCollisionType() == CollisionType::SELF ||
+			other.getCollisionType() == CollisionType::SOLID)
+		{
+			return CollisionResult::GAME_OVER; // e.g. ran into a wall
+		}
+
+		return CollisionResult::NONE;
+	}
+
+	bool Obstacles::covers(unsigned int x, unsigned int y) const
+	{
+		return m_level.blocked(x, y);
+	}
+
+	void Obstacles::accountMemory(MemoryReport& report) const
+	{
+		report.addShared<Cell>(MemorySubsystem::Cells);
+	}
+
+	void Obstacles::paint(ScreenBuffer& buffer) const
+	{
+		const unsigned int width = std::min(buffer.width(), m_level.width());
+		const unsigned int height = std::min(buffer.height(), m_level.height());
+
+		for (LevelFormat::Run const& run : m_level.runs())
+		{
+			if (run.y >= height || run.x >= width)
+			{
+				continue; // Skip out-of-bounds
+			}
+
+			const unsigned int end = run.x + std::min(run.length, width - run.x);
+
+			for (unsigned int x = run.x; x < end; ++x)
+			{
+				buffer.set(x, run.y, m_cell);
+			}
+		}
+	}
+
+	void Obstacles::repaint(ScreenBuffer& buffer, Position position) const
+	{
+		if (covers(position.first, position.second))
+		{
+			buffer.set(position.first, position.second, m_cell);
+		}
+	}
+
+	Level const& Obstacles::level() const noexcept
+	{
+		return m_level;
+	}
+};
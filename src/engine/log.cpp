@@ -0,0 +1,317 @@
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <sstream>
+#include <string_view>
+#include <thread>
+
+#include <boost/log/core.hpp>
+#include <boost/log/utility/setup/common_attributes.hpp>
+#include <boost/log/utility/setup/from_stream.hpp>
+
+#include "include/log.h"
+
+namespace Snake
+{
+	namespace Log
+	{
+		static_assert((QUEUE_CAPACITY & (QUEUE_CAPACITY - 1)) == 0, "QUEUE_CAPACITY must be a power of two");
+		static_assert(sizeof(TRUNCATION_MARKER) < MESSAGE_CAPACITY, "TRUNCATION_MARKER must leave room for a message");
+
+		/** @brief Bytes of the marker, without its terminator */
+		constexpr std::size_t MARKER_LENGTH = sizeof(TRUNCATION_MARKER) - 1;
+
+		namespace
+		{
+			/**
+			 * @brief Bounded multi-producer / single-consumer queue (Vyukov style)
+			 *
+			 * Each slot carries a sequence number telling producers and the consumer whose turn it is,
+			 * so neither side ever takes a lock.
+			 */
+			class RecordQueue
+			{
+				public:
+					RecordQueue() noexcept
+					{
+						for (std::size_t i = 0; i < QUEUE_CAPACITY; ++i)
+						{
+							m_slots[i].sequence.store(i, std::memory_order_relaxed);
+						}
+					}
+
+					bool tryPush(Severity severity, const char* text, std::size_t length) noexcept
+					{
+						std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+
+						for (;;)
+						{
+							Slot& slot = m_slots[pos & (QUEUE_CAPACITY - 1)];
+							std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+							std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+							if (diff == 0)
+							{
+								if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+								{
+									slot.severity = severity;
+									slot.length = static_cast<uint16_t>(length);
+									std::memcpy(slot.text, text, length);
+									slot.sequence.store(pos + 1, std::memory_order_release);
+
+									return true;
+								}
+							}
+							else if (diff < 0)
+							{
+								return false; // Full
+							}
+							else
+							{
+								pos = m_enqueuePos.load(std::memory_order_relaxed);
+							}
+						}
+					}
+
+					template <typename Fn>
+					bool tryPop(Fn&& consume) noexcept
+					{
+						Slot& slot = m_slots[m_dequeuePos & (QUEUE_CAPACITY - 1)];
+
+						if (slot.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1)
+						{
+							return false; // Empty
+						}
+
+						consume(slot.severity, std::string_view(slot.text, slot.length));
+						slot.sequence.store(m_dequeuePos + QUEUE_CAPACITY, std::memory_order_release);
+						++m_dequeuePos;
+
+						return true;
+					}
+
+				private:
+					struct Slot
+					{
+						std::atomic<std::size_t> sequence;
+						Severity severity;
+						uint16_t length;
+						char text[MESSAGE_CAPACITY];
+					};
+
+					std::array<Slot, QUEUE_CAPACITY> m_slots;
+					alignas(64) std::atomic<std::size_t> m_enqueuePos{0};
+					alignas(64) std::size_t m_dequeuePos = 0; // Only touched by the writer thread
+			};
+
+			/**
+			 * @brief Owns the queue and the background writer thread
+			 */
+			class Writer
+			{
+				public:
+					~Writer()
+					{
+						stop();
+					}
+
+					bool running() const noexcept
+					{
+						return m_running.load(std::memory_order_acquire);
+					}
+
+					void start(std::string config, OverflowPolicy policy)
+					{
+						if (running())
+						{
+							return;
+						}
+
+						m_policy = policy;
+						m_running.store(true, std::memory_order_release);
+						m_thread = std::thread(&Writer::loop, this, std::move(config));
+					}
+
+					void stop()
+					{
+						if (!m_thread.joinable())
+						{
+							return;
+						}
+
+						m_running.store(false, std::memory_order_release);
+						wake();
+						m_thread.join();
+					}
+
+					void push(Severity severity, const char* text, std::size_t length)
+					{
+						while (!m_queue.tryPush(severity, text, length))
+						{
+							if (m_policy == OverflowPolicy::Drop)
+							{
+								m_dropped.fetch_add(1, std::memory_order_relaxed);
+
+								return;
+							}
+
+							wake();
+							std::this_thread::yield();
+						}
+
+						wake();
+					}
+
+					uint64_t dropped() const noexcept
+					{
+						return m_dropped.load(std::memory_order_relaxed);
+					}
+
+				private:
+					RecordQueue m_queue;
+					OverflowPolicy m_policy = OverflowPolicy::Drop;
+					std::atomic<bool> m_running{false};
+					std::atomic<uint32_t> m_signal{0};
+					std::atomic<uint64_t> m_dropped{0};
+					uint64_t m_reportedDropped = 0;
+					std::thread m_thread;
+
+					void wake() noexcept
+					{
+						m_signal.fetch_add(1, std::memory_order_release);
+						m_signal.notify_one();
+					}
+
+					/**
+					 * @brief Writes every queued record, then flushes the sinks once for the whole batch
+					 * @return true if anything was written
+					 */
+					bool drain()
+					{
+						bool wrote = false;
+
+						while (m_queue.tryPop([](Severity severity, std::string_view text) {
+							BOOST_LOG_SEV(::boost::log::trivial::logger::get(), severity) << text;
+						}))
+						{
+							wrote = true;
+						}
+
+						uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+
+						if (dropped != m_reportedDropped)
+						{
+							BOOST_LOG_TRIVIAL(warning) << "Log queue overflow, dropped " << (dropped - m_reportedDropped) << " records";
+							m_reportedDropped = dropped;
+							wrote = true;
+						}
+
+						if (wrote)
+						{
+							boost::log::core::get()->flush();
+						}
+
+						return wrote;
+					}
+
+					void loop(std::string config)
+					{
+						try
+						{
+							std::istringstream stream(config);
+
+							boost::log::add_common_attributes();
+							boost::log::init_from_stream(stream);
+						}
+						catch (const std::exception& e)
+						{
+							BOOST_LOG_TRIVIAL(error) << "Invalid logging configuration: " << e.what();
+						}
+
+						for (;;)
+						{
+							uint32_t seen = m_signal.load(std::memory_order_acquire);
+
+							drain();
+
+							if (!running())
+							{
+								drain(); // Records pushed while we were shutting down
+
+								return;
+							}
+
+							m_signal.wait(seen, std::memory_order_acquire);
+						}
+					}
+			};
+
+			Writer g_writer;
+		}
+
+		void start(std::string config, OverflowPolicy policy)
+		{
+			g_writer.start(std::move(config), policy);
+		}
+
+		void stop()
+		{
+			g_writer.stop();
+		}
+
+		uint64_t droppedCount() noexcept
+		{
+			return g_writer.dropped();
+		}
+
+		std::size_t memoryBytes() noexcept
+		{
+			return sizeof(g_writer);
+		}
+
+		Record::FixedBuffer::FixedBuffer() noexcept
+		{
+			setp(m_data, m_data + MESSAGE_CAPACITY - MARKER_LENGTH);
+		}
+
+		Record::FixedBuffer::int_type Record::FixedBuffer::overflow(int_type)
+		{
+			if (!m_truncated)
+			{
+				std::memcpy(pptr(), TRUNCATION_MARKER, MARKER_LENGTH);
+				pbump(static_cast<int>(MARKER_LENGTH));
+				m_truncated = true;
+			}
+
+			return traits_type::eof();
+		}
+
+		const char* Record::FixedBuffer::data() const noexcept
+		{
+			return m_data;
+		}
+
+		std::size_t Record::FixedBuffer::size() const noexcept
+		{
+			return static_cast<std::size_t>(pptr() - pbase());
+		}
+
+		Record::Record(Severity severity) noexcept
+			: m_severity(severity),
+			  m_stream(&m_buffer)
+		{}
+
+		Record::~Record()
+		{
+			if (g_writer.running())
+			{
+				g_writer.push(m_severity, m_buffer.data(), m_buffer.size());
+
+				return;
+			}
+
+			// Logger not started (or already stopped): write synchronously
+			BOOST_LOG_SEV(::boost::log::trivial::logger::get(), m_severity) << std::string_view(m_buffer.data(), m_buffer.size());
+		}
+	};
+};
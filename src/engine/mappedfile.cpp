@@ -0,0 +1,75 @@
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "include/mappedfile.h"
+
+namespace Snake
+{
+	MappedFile::MappedFile(std::filesystem::path const& path)
+	{
+#if defined(_WIN32)
+		std::ifstream in(path, std::ios::binary);
+
+		if (!in.is_open())
+			throw std::runtime_error("Failed to open " + path.string());
+
+		m_fallback.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+		if (m_fallback.empty())
+			throw std::runtime_error("Empty file " + path.string());
+
+		m_data = m_fallback.data();
+		m_size = m_fallback.size();
+#else
+		int fd = ::open(path.c_str(), O_RDONLY);
+
+		if (fd < 0)
+			throw std::runtime_error("Failed to open " + path.string());
+
+		struct stat st;
+
+		if (::fstat(fd, &st) != 0 || st.st_size == 0)
+		{
+			::close(fd);
+			throw std::runtime_error("Failed to read " + path.string());
+		}
+
+		void* mapped = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd); // the mapping keeps the file alive
+
+		if (mapped == MAP_FAILED)
+			throw std::runtime_error("Failed to map " + path.string());
+
+		m_data = static_cast<const uint8_t*>(mapped);
+		m_size = static_cast<size_t>(st.st_size);
+#endif
+	}
+
+	MappedFile::~MappedFile()
+	{
+#if !defined(_WIN32)
+		if (m_data != nullptr)
+		{
+			::munmap(const_cast<uint8_t*>(m_data), m_size);
+		}
+#endif
+	}
+
+	const uint8_t* MappedFile::data() const noexcept
+	{
+		return m_data;
+	}
+
+	size_t MappedFile::size() const noexcept
+	{
+		return m_size;
+	}
+};
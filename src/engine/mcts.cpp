@@ -0,0 +1,617 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+#include "include/batch.h"
+#include "include/game.h"
+#include "include/mcts.h"
+#include "include/random.h"
+
+namespace Snake
+{
+	void PlayoutBoard::load(GameSnapshot const& snapshot, unsigned int width, unsigned int height, Obstacles const* obstacles)
+	{
+		if (width != m_width || height != m_height || obstacles != m_obstacles)
+		{
+			m_width = width;
+			m_height = height;
+			m_obstacles = obstacles;
+			m_capacity = (width - 2) * (height - 2) + 2;
+			m_freeCells = (width - 2) * (height - 2);
+
+			// Up, Down, Left, Right like Snake::Snake::Direction
+			m_offsets[0] = -static_cast<int32_t>(width);
+			m_offsets[1] = static_cast<int32_t>(width);
+			m_offsets[2] = -1;
+			m_offsets[3] = 1;
+
+			m_board.assign(static_cast<size_t>(width) * height, 0);
+			m_body.assign(m_capacity, 0);
+
+			for (unsigned int x = 0; x < width; ++x)
+			{
+				m_board[x] = WALL;
+				m_board[(height - 1) * width + x] = WALL;
+			}
+
+			for (unsigned int y = 0; y < height; ++y)
+			{
+				m_board[y * width] = WALL;
+				m_board[y * width + width - 1] = WALL;
+			}
+
+			if (obstacles)
+			{
+				for (LevelFormat::Run const& run : obstacles->level().runs())
+				{
+					for (uint32_t x = run.x; x < run.x + run.length && x < width - 1 && run.y < height - 1; ++x)
+					{
+						m_freeCells -= m_board[run.y * width + x] != WALL;
+						m_board[run.y * width + x] = WALL;
+					}
+				}
+			}
+		}
+		else
+		{
+			// Only the old snake needs clearing, the walls never change
+			for (uint32_t i = 0; i < m_length; ++i)
+			{
+				const uint32_t cell = m_body[(m_headSlot + i) % m_capacity];
+
+				if (m_board[cell] != WALL)
+				{
+					--m_board[cell];
+				}
+			}
+		}
+
+		m_headSlot = 0;
+		m_length = static_cast<uint32_t>(std::min<size_t>(snapshot.length(), m_capacity));
+
+		for (uint32_t i = 0; i < m_length; ++i)
+		{
+			const Position position = GameSnapshot::s_Unpack(snapshot.words[GameSnapshot::HEADER_WORDS + i]);
+			const uint32_t cell = position.second * width + position.first;
+
+			m_body[i] = cell;
+
+			if (m_board[cell] != WALL)
+			{
+				++m_board[cell];
+			}
+		}
+
+		const uint32_t food = snapshot.words[GameSnapshot::FOOD];
+		const Position foodPosition = GameSnapshot::s_Unpack(food);
+
+		m_direction = static_cast<uint8_t>(snapshot.words[GameSnapshot::DIRECTION]);
+		m_food = food == GameSnapshot::NO_FOOD ? NO_FOOD : foodPosition.second * width + foodPosition.first;
+		m_frames = snapshot.words[GameSnapshot::FRAMES];
+		m_rng = snapshot.words[GameSnapshot::RNG_LO] | (static_cast<uint64_t>(snapshot.words[GameSnapshot::RNG_HI]) << 32);
+		m_undo.clear();
+	}
+
+	void PlayoutBoard::spawnFood() noexcept
+	{
+		if (m_length >= m_freeCells)
+		{
+			return; // No empty cell left
+		}
+
+		uint32_t x, y;
+
+		do
+		{
+			x = Rng::s_Below(m_rng, m_width - 2) + 1;
+			y = Rng::s_Below(m_rng, m_height - 2) + 1;
+		} while (m_board[y * m_width + x] != 0);
+
+		m_food = y * m_width + x;
+	}
+
+	PlayoutBoard::Outcome PlayoutBoard::step(unsigned int direction) noexcept
+	{
+		Undo undo{ m_rng, m_food, 0, m_frames, m_direction, MOVED };
+
+		// Snake::Game::update spawns food before moving
+		if (m_frames != 0 && m_frames % BatchEnv::FOOD_FREQ == 0 && m_food == NO_FOOD)
+		{
+			spawnFood();
+		}
+
+		if (direction != (m_direction ^ 1u))
+		{
+			m_direction = static_cast<uint8_t>(direction);
+		}
+
+		const uint32_t newHead = static_cast<uint32_t>(static_cast<int32_t>(head()) + m_offsets[m_direction]);
+		const uint32_t tailSlot = (m_headSlot + m_length - 1) % m_capacity;
+
+		undo.tail = m_body[tailSlot];
+		--m_board[undo.tail];
+
+		m_headSlot = (m_headSlot + m_capacity - 1) % m_capacity;
+		m_body[m_headSlot] = newHead;
+
+		// Collisions in Snake::Game pair order: border, food, self
+		if (m_board[newHead] == WALL)
+		{
+			undo.outcome = HIT_WALL;
+		}
+		else
+		{
+			++m_board[newHead];
+
+			if (newHead == m_food)
+			{
+				// Snake::grow duplicates the tail into the slot the old tail just left
+				const uint32_t tail = m_body[(m_headSlot + m_length - 1) % m_capacity];
+
+				m_body[(m_headSlot + m_length) % m_capacity] = tail;
+				++m_board[tail];
+				++m_length;
+
+				m_food = NO_FOOD;
+				undo.outcome = ATE;
+			}
+			else if (m_board[newHead] > 1)
+			{
+				undo.outcome = HIT_SELF;
+			}
+		}
+
+		++m_frames;
+		m_undo.push_back(undo);
+
+		return undo.outcome;
+	}
+
+	void PlayoutBoard::undo() noexcept
+	{
+		const Undo undo = m_undo.back();
+		m_undo.pop_back();
+
+		if (undo.outcome != HIT_WALL)
+		{
+			--m_board[head()];
+		}
+
+		if (undo.outcome == ATE)
+		{
+			--m_length;
+			--m_board[m_body[(m_headSlot + m_length) % m_capacity]];
+		}
+
+		m_headSlot = (m_headSlot + 1) % m_capacity;
+		m_body[(m_headSlot + m_length - 1) % m_capacity] = undo.tail;
+		++m_board[undo.tail];
+
+		m_rng = undo.rng;
+		m_food = undo.food;
+		m_frames = undo.frames;
+		m_direction = undo.direction;
+	}
+
+	MctsSearch::MctsSearch(unsigned int threads, uint64_t seed)
+		: m_pool(threads)
+	{
+		// Separate allocations, so threads never write to the same cache line
+		for (unsigned int i = 0; i < m_pool.size(); ++i)
+		{
+			m_trees.push_back(std::make_unique<Tree>());
+			m_trees.back()->rng = Rng::s_StreamSeed(seed, 2 + i); // 0 and 1 are the game's and RandomController's
+			m_trees.back()->nodes.reserve(s_MaxNodes);
+		}
+	}
+
+	unsigned int MctsSearch::threads() const noexcept
+	{
+		return m_pool.size();
+	}
+
+	uint64_t MctsSearch::playouts() const noexcept
+	{
+		uint64_t total = 0;
+
+		for (const auto& tree : m_trees)
+		{
+			total += tree->playouts;
+		}
+
+		return total;
+	}
+
+	void MctsSearch::prepare(Tree& tree) const
+	{
+		tree.board = *m_root;
+		tree.nodes.clear();
+		tree.nodes.push_back(Node{ 0, 0, 0.0f, static_cast<uint8_t>(m_root->direction()), 0, false });
+		tree.search = m_search;
+
+		expand(tree, 0);
+	}
+
+	void MctsSearch::expand(Tree& tree, uint32_t node) const
+	{
+		if (tree.nodes.size() + 3 > s_MaxNodes)
+		{
+			return;
+		}
+
+		// Every direction but the reverse one, which the snake ignores
+		const unsigned int reverse = tree.board.direction() ^ 1u;
+		const auto first = static_cast<uint32_t>(tree.nodes.size());
+
+		for (unsigned int direction = 0; direction < 4; ++direction)
+		{
+			if (direction != reverse)
+			{
+				tree.nodes.push_back(Node{ 0, 0, 0.0f, static_cast<uint8_t>(direction), 0, false });
+			}
+		}
+
+		tree.nodes[node].firstChild = first;
+		tree.nodes[node].children = 3;
+	}
+
+	void MctsSearch::iterate(Tree& tree) const
+	{
+		PlayoutBoard& board = tree.board;
+		uint32_t node = 0;
+		float value = 0.0f;
+		bool dead = false;
+
+		tree.path.clear();
+		tree.path.push_back(0);
+
+		for (;;)
+		{
+			Node& current = tree.nodes[node];
+
+			if (current.children == 0)
+			{
+				if (current.visits == 0 || tree.nodes.size() + 3 > s_MaxNodes)
+				{
+					break;
+				}
+
+				expand(tree, node);
+			}
+
+			// UCT, unvisited children first
+			const Node& parent = tree.nodes[node];
+			const float logVisits = std::log(static_cast<float>(parent.visits + 1));
+			uint32_t best = parent.firstChild;
+			float bestScore = -1.0f;
+
+			for (uint32_t child = parent.firstChild; child < parent.firstChild + parent.children; ++child)
+			{
+				const Node& candidate = tree.nodes[child];
+				const float score = candidate.visits == 0
+					? 1e6f - static_cast<float>(Rng::s_Below(tree.rng, 1024))
+					: candidate.value / candidate.visits + s_Exploration * std::sqrt(logVisits / candidate.visits);
+
+				if (score > bestScore)
+				{
+					bestScore = score;
+					best = child;
+				}
+			}
+
+			node = best;
+			tree.path.push_back(node);
+
+			if (tree.nodes[node].dead)
+			{
+				dead = true;
+				break;
+			}
+
+			const PlayoutBoard::Outcome outcome = board.step(tree.nodes[node].direction);
+
+			if (outcome == PlayoutBoard::HIT_WALL || outcome == PlayoutBoard::HIT_SELF)
+			{
+				tree.nodes[node].dead = true;
+				dead = true;
+				break;
+			}
+
+			if (outcome == PlayoutBoard::ATE)
+			{
+				value += std::pow(0.97f, static_cast<float>(board.depth()));
+			}
+		}
+
+		if (dead)
+		{
+			value = 0.0f;
+		}
+		else
+		{
+			value += playout(tree);
+		}
+
+		for (uint32_t visited : tree.path)
+		{
+			++tree.nodes[visited].visits;
+			tree.nodes[visited].value += value;
+		}
+
+		while (board.depth() > 0)
+		{
+			board.undo();
+		}
+
+		++tree.playouts;
+	}
+
+	float MctsSearch::playout(Tree& tree) const
+	{
+		PlayoutBoard& board = tree.board;
+		float value = 0.0f;
+
+		for (unsigned int i = 0; i < s_PlayoutDepth; ++i)
+		{
+			// Moves that do not die right away; the tail cell is free unless the snake just grew
+			const uint32_t head = board.head();
+			const uint32_t tail = board.tail();
+			const unsigned int reverse = board.direction() ^ 1u;
+			const uint32_t food = board.food();
+			unsigned int safe[3];
+			unsigned int closer[3];
+			unsigned int safeCount = 0;
+			unsigned int closerCount = 0;
+
+			for (unsigned int direction = 0; direction < 4; ++direction)
+			{
+				if (direction == reverse)
+				{
+					continue;
+				}
+
+				const uint32_t target = static_cast<uint32_t>(static_cast<int32_t>(head) + board.offset(direction));
+				const uint8_t cell = board.cell(target);
+
+				if (cell != 0 && !(target == tail && cell == 1))
+				{
+					continue;
+				}
+
+				safe[safeCount++] = direction;
+
+				if (food != PlayoutBoard::NO_FOOD)
+				{
+					const int headX = static_cast<int>(head % board.width()), headY = static_cast<int>(head / board.width());
+					const int targetX = static_cast<int>(target % board.width()), targetY = static_cast<int>(target / board.width());
+					const int foodX = static_cast<int>(food % board.width()), foodY = static_cast<int>(food / board.width());
+
+					if (std::abs(targetX - foodX) + std::abs(targetY - foodY) < std::abs(headX - foodX) + std::abs(headY - foodY))
+					{
+						closer[closerCount++] = direction;
+					}
+				}
+			}
+
+			if (safeCount == 0)
+			{
+				return 0.0f; // every move dies
+			}
+
+			const uint64_t roll = Rng::s_Next(tree.rng);
+			const unsigned int direction = (closerCount > 0 && (roll & 1))
+				? closer[(roll >> 8) % closerCount]
+				: safe[(roll >> 8) % safeCount];
+
+			const PlayoutBoard::Outcome outcome = board.step(direction);
+
+			if (outcome == PlayoutBoard::HIT_WALL || outcome == PlayoutBoard::HIT_SELF)
+			{
+				return 0.0f;
+			}
+
+			if (outcome == PlayoutBoard::ATE)
+			{
+				value += std::pow(0.97f, static_cast<float>(board.depth()));
+			}
+		}
+
+		// Survived: a bonus that grows as the head nears the food
+		float survival = 0.5f;
+
+		if (board.food() != PlayoutBoard::NO_FOOD)
+		{
+			const int dx = static_cast<int>(board.head() % board.width()) - static_cast<int>(board.food() % board.width());
+			const int dy = static_cast<int>(board.head() / board.width()) - static_cast<int>(board.food() / board.width());
+
+			survival += 0.2f * (1.0f - static_cast<float>(std::abs(dx) + std::abs(dy)) / static_cast<float>(board.width() + board.height()));
+		}
+
+		return value + survival;
+	}
+
+	unsigned int MctsSearch::search(PlayoutBoard const& root, std::chrono::nanoseconds budget)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		const auto deadline = start + budget;
+		const uint64_t before = playouts();
+
+		m_root = &root;
+		++m_search;
+
+		// Rounds sized to the time left by the measured rate, so few batches are handed out after the deadline
+		for (auto now = start; now < deadline; now = std::chrono::steady_clock::now())
+		{
+			const double seconds = std::chrono::duration<double>(deadline - now).count();
+			const size_t estimate = static_cast<size_t>(m_rate * seconds / s_BatchIterations);
+			const size_t batches = std::max<size_t>(m_pool.size() * 4, estimate);
+
+			m_pool.parallelFor(batches, 1, [this, deadline](size_t begin, size_t end)
+			{
+				Tree& tree = *m_trees[WorkerPool::s_ThreadIndex()];
+
+				if (tree.search != m_search)
+				{
+					prepare(tree);
+				}
+
+				for (size_t batch = begin; batch < end; ++batch)
+				{
+					if (std::chrono::steady_clock::now() >= deadline)
+					{
+						return;
+					}
+
+					for (unsigned int i = 0; i < s_BatchIterations; ++i)
+					{
+						iterate(tree);
+					}
+				}
+			});
+		}
+
+		const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if (elapsed > 0)
+		{
+			m_rate = static_cast<double>(playouts() - before) / elapsed;
+		}
+
+		// Sum the root move visits of every tree that took part
+		uint64_t visits[4] = {};
+
+		for (const auto& tree : m_trees)
+		{
+			if (tree->search != m_search)
+			{
+				continue;
+			}
+
+			const Node& rootNode = tree->nodes.front();
+
+			for (uint32_t child = rootNode.firstChild; child < rootNode.firstChild + rootNode.children; ++child)
+			{
+				visits[tree->nodes[child].direction] += tree->nodes[child].visits;
+			}
+		}
+
+		unsigned int best = root.direction();
+
+		for (unsigned int direction = 0; direction < 4; ++direction)
+		{
+			if (visits[direction] > visits[best])
+			{
+				best = direction;
+			}
+		}
+
+		return best;
+	}
+
+	MctsController::MctsController(unsigned int threads, uint64_t seed, std::chrono::nanoseconds budget)
+		: m_search(threads, seed),
+		  m_budget(budget)
+	{}
+
+	Input::KeyKind MctsController::nextKey(Game const& game)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		game.snapshot(m_snapshot);
+		m_root.load(m_snapshot, game.width(), game.height(), game.obstacles());
+
+		const unsigned int direction = m_search.search(m_root, m_budget);
+
+		m_searched += std::chrono::steady_clock::now() - start;
+		++m_decisions;
+
+		if (direction == m_root.direction())
+		{
+			return Input::KeyKind::None;
+		}
+
+		return static_cast<Input::KeyKind>(static_cast<unsigned int>(Input::KeyKind::ArrowUp) + direction);
+	}
+
+	std::string MctsController::report() const
+	{
+		std::ostringstream out;
+		const double seconds = std::chrono::duration<double>(m_searched).count();
+		const double perThread = seconds > 0 ? m_search.playouts() / seconds / m_search.threads() : 0.0;
+
+		out << "decisions:   " << m_decisions << "\n"
+			<< "playouts:    " << m_search.playouts() << "\n"
+			<< "playouts/s:  " << static_cast<uint64_t>(perThread) << " per thread (" << m_search.threads() << " threads)\n";
+
+		return out.str();
+	}
+
+	int runMctsBench(Options const& options)
+	{
+		static constexpr unsigned int s_Searches = 10;
+		static constexpr std::chrono::milliseconds s_SearchTime{ 100 };
+
+		const uint64_t seed = options.seed != 0 ? options.seed : std::random_device{}();
+		const unsigned int maxThreads = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+
+		// The starting position of Snake::Game: head in the middle, body extending to the right, moving left
+		GameSnapshot start;
+		start.words.assign(GameSnapshot::HEADER_WORDS, 0);
+		start.words[GameSnapshot::DIRECTION] = 2;
+		start.words[GameSnapshot::FOOD] = GameSnapshot::NO_FOOD;
+
+		const uint64_t rng = Rng::s_StreamSeed(seed, 0);
+		start.words[GameSnapshot::RNG_LO] = static_cast<uint32_t>(rng);
+		start.words[GameSnapshot::RNG_HI] = static_cast<uint32_t>(rng >> 32);
+
+		for (unsigned int i = 0; i < BatchEnv::START_LENGTH; ++i)
+		{
+			start.words.push_back(GameSnapshot::s_Pack(options.width / 2 + i, options.height / 2));
+		}
+
+		PlayoutBoard root;
+		root.load(start, options.width, options.height);
+
+		std::cout << "board:       " << options.width << "x" << options.height << "\n"
+			<< "threads  playouts/s  per thread  scaling\n";
+
+		double single = 0.0;
+
+		for (unsigned int threads = 1; ; threads = std::min(threads * 2, maxThreads))
+		{
+			MctsSearch search(threads, seed);
+
+			// One untimed search warms up the trees and the rate estimate
+			search.search(root, s_SearchTime);
+
+			const uint64_t before = search.playouts();
+			const auto begin = std::chrono::steady_clock::now();
+
+			for (unsigned int i = 0; i < s_Searches; ++i)
+			{
+				search.search(root, s_SearchTime);
+			}
+
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+			const double rate = (search.playouts() - before) / seconds;
+
+			if (threads == 1)
+			{
+				single = rate;
+			}
+
+			std::cout << threads << "\t " << static_cast<uint64_t>(rate) << "\t     " << static_cast<uint64_t>(rate / threads)
+				<< "\t " << (single > 0 ? rate / single / threads : 0.0) << std::endl;
+
+			if (threads == maxThreads)
+			{
+				break;
+			}
+		}
+
+		return 0;
+	}
+};
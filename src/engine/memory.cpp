@@ -0,0 +1,87 @@
+#include <cstdio>
+
+#include "include/memory.h"
+
+namespace Snake
+{
+	void MemoryReport::add(MemorySubsystem subsystem, uint64_t bytes, uint64_t allocations) noexcept
+	{
+		Usage& usage = m_usage[static_cast<size_t>(subsystem)];
+
+		usage.bytes += bytes;
+		usage.allocations += allocations;
+	}
+
+	MemoryReport::Usage const& MemoryReport::usage(MemorySubsystem subsystem) const noexcept
+	{
+		return m_usage[static_cast<size_t>(subsystem)];
+	}
+
+	MemoryReport::Usage MemoryReport::total() const noexcept
+	{
+		Usage total;
+
+		for (Usage const& usage : m_usage)
+		{
+			total.bytes += usage.bytes;
+			total.allocations += usage.allocations;
+		}
+
+		return total;
+	}
+
+	std::string MemoryReport::report() const
+	{
+		std::string out = "Memory:\n";
+		char line[128];
+
+		for (size_t i = 0; i < m_usage.size(); ++i)
+		{
+			std::snprintf(line, sizeof(line), "  %-14s %12llu bytes %10llu allocations\n", s_Name(static_cast<MemorySubsystem>(i)),
+				static_cast<unsigned long long>(m_usage[i].bytes), static_cast<unsigned long long>(m_usage[i].allocations));
+			out += line;
+		}
+
+		const Usage sum = total();
+
+		std::snprintf(line, sizeof(line), "  %-14s %12llu bytes %10llu allocations\n", "total",
+			static_cast<unsigned long long>(sum.bytes), static_cast<unsigned long long>(sum.allocations));
+		out += line;
+
+		return out;
+	}
+
+	std::string MemoryReport::summary() const
+	{
+		std::string out;
+		char item[64];
+
+		for (size_t i = 0; i < m_usage.size(); ++i)
+		{
+			std::snprintf(item, sizeof(item), "%s%s %llu B/%llu", i == 0 ? "" : ", ", s_Name(static_cast<MemorySubsystem>(i)),
+				static_cast<unsigned long long>(m_usage[i].bytes), static_cast<unsigned long long>(m_usage[i].allocations));
+			out += item;
+		}
+
+		return out;
+	}
+
+	const char* MemoryReport::s_Name(MemorySubsystem subsystem) noexcept
+	{
+		switch (subsystem)
+		{
+			case MemorySubsystem::ScreenBuffer:
+				return "screen buffer";
+			case MemorySubsystem::Objects:
+				return "objects";
+			case MemorySubsystem::Cells:
+				return "cells";
+			case MemorySubsystem::History:
+				return "history";
+			case MemorySubsystem::Logging:
+				return "logging";
+			default:
+				return "?";
+		}
+	}
+};
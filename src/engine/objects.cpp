@@ -1,6 +1,9 @@
+#include <memory>
+#include <set>
 #include <vector>
 
-#include <boost/log/trivial.hpp>
+#include "board.h"
+#include "log.h"
 
 #include "objects.h"
 #include "screen.h"
@@ -48,7 +51,7 @@ namespace Snake
 		  m_attributes(static_cast<uint16_t>(attrs))
 		{}
 
-	const std::vector<std::unique_ptr<PositionedCell>>& BaseObject::cells() const noexcept
+	const std::vector<PCellPtr>& BaseObject::cells() const noexcept
 	{
 		return m_cells;
 	}
@@ -127,11 +130,72 @@ namespace Snake
 		return detectors;
 	}
 
+	bool BaseObject::covers(unsigned int, unsigned int) const
+	{
+		return false;
+	}
+
+	void BaseObject::accountMemory(MemoryReport& report) const
+	{
+		report.addVector(MemorySubsystem::Objects, m_cells);
+
+		if (m_pCellPool)
+		{
+			report.add(MemorySubsystem::Cells, m_pCellPoolSize * sizeof(PositionedCell));
+		}
+
+		// Cells may point into one shared block (Snake::Border's glyphs); count each block once
+		std::set<CellPtr, std::owner_less<CellPtr>> blocks;
+		uint64_t unpooled = 0;
+
+		for (const PCellPtr& pCell : m_cells)
+		{
+			if (!pCell.get_deleter().pooled)
+			{
+				++unpooled;
+			}
+
+			blocks.insert(pCell->cell);
+		}
+
+		report.add(MemorySubsystem::Cells, unpooled * sizeof(PositionedCell), unpooled);
+		report.addShared<Cell>(MemorySubsystem::Cells, blocks.size());
+
+		report.addVector(MemorySubsystem::History, m_previousPositions);
+		report.addVector(MemorySubsystem::History, m_newPositions);
+	}
+
 	CollisionType BaseObject::getCollisionType() const noexcept
 	{
 		return m_collisionType;
 	}
 
+	uint16_t BaseObject::getCollisionLayer() const noexcept
+	{
+		return m_collisionLayer;
+	}
+
+	uint16_t BaseObject::getCollisionMask() const noexcept
+	{
+		return m_collisionMask;
+	}
+
+	void BaseObject::setCollisionFilter(uint16_t layer, uint16_t mask) noexcept
+	{
+		m_collisionLayer = layer;
+		m_collisionMask = mask;
+	}
+
+	void BaseObject::setCollisionFilter(CollisionLayer layer, CollisionLayer mask) noexcept
+	{
+		setCollisionFilter(static_cast<uint16_t>(layer), static_cast<uint16_t>(mask));
+	}
+
+	bool BaseObject::canCollideWith(BaseObject const& other) const noexcept
+	{
+		return (m_collisionLayer & other.m_collisionMask) != 0 && (other.m_collisionLayer & m_collisionMask) != 0;
+	}
+
 	void BaseObject::addPCell(PCellPtr& pCell)
 	{
 		m_cells.push_back(std::move(pCell));
@@ -144,7 +208,35 @@ namespace Snake
 
 	PCellPtr BaseObject::s_MakePCell(unsigned int x, unsigned int y, CellPtr cell)
 	{
-	    return std::make_unique<PositionedCell>(PositionedCell{ x, y, cell });
+	    return PCellPtr(new PositionedCell{ x, y, std::move(cell) });
+	}
+
+	void BaseObject::reservePCells(size_t count)
+	{
+		m_pCellPool = std::make_unique<PositionedCell[]>(count);
+		m_pCellPoolSize = count;
+		m_pCellPoolUsed = 0;
+
+		m_cells.reserve(m_cells.size() + count);
+	}
+
+	PCellPtr BaseObject::makePooledPCell(unsigned int x, unsigned int y, CellPtr cell)
+	{
+		if (m_pCellPoolUsed == m_pCellPoolSize)
+		{
+			return s_MakePCell(x, y, std::move(cell));
+		}
+
+		PositionedCell* pCell = &m_pCellPool[m_pCellPoolUsed++];
+		*pCell = PositionedCell{ x, y, std::move(cell) };
+
+		return PCellPtr(pCell, PCellDeleter{ .pooled = true });
+	}
+
+	void BaseObject::settlePositions()
+	{
+		m_previousPositions = capturePositions();
+		m_newPositions = m_previousPositions;
 	}
 
 	void Border::generateColorSequence()
@@ -167,38 +259,68 @@ namespace Snake
 	Border::Border(unsigned int width, unsigned int height) :
 		BaseObject(CollisionType::SOLID, Attributes::ANIMATED)
 	{
+		setCollisionFilter(CollisionLayer::WALL, CollisionLayer::SNAKE);
 		generateColorSequence();
+
+		// One Cell per glyph, all in a single allocation; positioned cells only point at them
+		m_glyphs = std::make_shared<Cell[]>(s_GlyphCount);
+
+		const uint32_t codepoints[s_GlyphCount] = {
+			TGLYPHS::HORIZ_DOUBLE_LINE, TGLYPHS::VERT_DOUBLE_LINE,
+			TGLYPHS::TOP_LEFT_DOUBLE_CORNER, TGLYPHS::TOP_RIGHT_DOUBLE_CORNER,
+			TGLYPHS::BOTTOM_LEFT_DOUBLE_CORNER, TGLYPHS::BOTTOM_RIGHT_DOUBLE_CORNER
+		};
+
+		for (size_t i = 0; i < s_GlyphCount; ++i)
+		{
+			m_glyphs[i] = Cell{ .codepoint = codepoints[i], .default_fg = false };
+		}
+
+		withBoard(width, height, [this](auto board) { build(board); });
+	}
+
+	template <typename BoardType>
+	void Border::build(BoardType board)
+	{
+		const unsigned int width = board.width();
+		const unsigned int height = board.height();
+
+		CellPtr horizontal(m_glyphs, &m_glyphs[0]);
+		CellPtr vertical(m_glyphs, &m_glyphs[1]);
+
+		reservePCells(2 * static_cast<size_t>(width) + 2 * static_cast<size_t>(height) - 4);
+
 		// Top and bottom rows
 		for (unsigned int x = 1; x < width - 1; ++x)
 		{
-			PCellPtr pTopCell = s_MakePCell(x, 0, s_MakeCell(Cell{ .codepoint = TGLYPHS::HORIZ_DOUBLE_LINE, .default_fg = false }));
+			PCellPtr pTopCell = makePooledPCell(x, 0, horizontal);
 			addPCell(pTopCell);
 
-			PCellPtr pBottomCell = s_MakePCell(x, height - 1, s_MakeCell(Cell{ .codepoint = TGLYPHS::HORIZ_DOUBLE_LINE, .default_fg = false }));
+			PCellPtr pBottomCell = makePooledPCell(x, height - 1, horizontal);
 			addPCell(pBottomCell);
 		}
 
 		// Left and right columns
 		for (unsigned int y = 1; y < height - 1; ++y)
 		{
-			PCellPtr pLeftCell = s_MakePCell(0, y, s_MakeCell(Cell{ .codepoint = TGLYPHS::VERT_DOUBLE_LINE, .default_fg = false }));
+			PCellPtr pLeftCell = makePooledPCell(0, y, vertical);
 			addPCell(pLeftCell);
 
-			PCellPtr pRightCell = s_MakePCell(width - 1, y, s_MakeCell(Cell{ .codepoint = TGLYPHS::VERT_DOUBLE_LINE, .default_fg = false }));
+			PCellPtr pRightCell = makePooledPCell(width - 1, y, vertical);
 			addPCell(pRightCell);
 		}
 
 		// Corners
-		PCellPtr pTopLeftCell = s_MakePCell(0, 0, s_MakeCell(Cell{ .codepoint = TGLYPHS::TOP_LEFT_DOUBLE_CORNER, .default_fg = false }));
+		PCellPtr pTopLeftCell = makePooledPCell(0, 0, CellPtr(m_glyphs, &m_glyphs[2]));
 		addPCell(pTopLeftCell);
 
-		PCellPtr pTopRightCell = s_MakePCell(width - 1, 0, s_MakeCell(Cell{ .codepoint = TGLYPHS::TOP_RIGHT_DOUBLE_CORNER, .default_fg = false }));
+		PCellPtr pTopRightCell = makePooledPCell(width - 1, 0, CellPtr(m_glyphs, &m_glyphs[3]));
 		addPCell(pTopRightCell);
 
-		PCellPtr pBottomLeftCell = s_MakePCell(0, height - 1, s_MakeCell(Cell{ .codepoint = TGLYPHS::BOTTOM_LEFT_DOUBLE_CORNER, .default_fg = false }));
+		PCellPtr pBottomLeftCell = makePooledPCell(0, height - 1, CellPtr(m_glyphs, &m_glyphs[4]));
 		addPCell(pBottomLeftCell);
 
-		PCellPtr pBottomRightCell = s_MakePCell(width - 1, height - 1, s_MakeCell(Cell{ .codepoint = TGLYPHS::BOTTOM_RIGHT_DOUBLE_CORNER, .default_fg = false }));
+		PCellPtr pBottomRightCell = makePooledPCell(width - 1, height - 1, CellPtr(m_glyphs, &m_glyphs[5]));
 		addPCell(pBottomRightCell);
 	}
 
@@ -213,14 +335,47 @@ namespace Snake
 		return CollisionResult::NONE; // No collision
 	}
 
+	size_t Border::animationFrame() const noexcept
+	{
+		return m_animationFrame;
+	}
+
+	void Border::setAnimationFrame(size_t frame)
+	{
+		if (frame == 0)
+		{
+			for (size_t i = 0; i < s_GlyphCount; ++i)
+			{
+				m_glyphs[i].fg = Cell{}.fg; // not animated yet
+			}
+
+			m_animationFrame = 0;
+
+			return;
+		}
+
+		m_animationFrame = frame - 1;
+		animate();
+	}
+
+	void Border::accountMemory(MemoryReport& report) const
+	{
+		BaseObject::accountMemory(report);
+
+		// The base counted the glyph block as a single Cell
+		report.add(MemorySubsystem::Cells, (s_GlyphCount - 1) * sizeof(Cell), 0);
+		report.addVector(MemorySubsystem::Objects, m_colorSequence);
+	}
+
 	void Border::animate()
 	{
 		uint8_t newColor = m_colorSequence[m_animationFrame % m_colorSequence.size()];
 
-		for (const PCellPtr& pCell : m_cells)
+		// Every border cell points at one of the shared glyph cells
+		for (size_t i = 0; i < s_GlyphCount; ++i)
 		{
-			pCell->cell->fg = newColor;
-			pCell->cell->default_fg = false;
+			m_glyphs[i].fg = newColor;
+			m_glyphs[i].default_fg = false;
 		}
 
 		m_animationFrame++;
@@ -229,15 +384,18 @@ namespace Snake
 	Snake::Snake(unsigned int startX, unsigned int startY)
 		: BaseObject(CollisionType::SELF, Attributes::MOVABLE | Attributes::ANIMATED)
 	{
-		PCellPtr pHeadCell = s_MakePCell(startX, startY, s_MakeCell(Cell{ .codepoint = TGLYPHS::SNAKE_HEAD_LEFT, .detector = true }));
+		setCollisionFilter(CollisionLayer::SNAKE, CollisionLayer::ALL);
+		reservePCells(m_length);
+
+		PCellPtr pHeadCell = makePooledPCell(startX, startY, s_MakeCell(Cell{ .codepoint = TGLYPHS::SNAKE_HEAD_LEFT, .detector = true }));
 		addPCell(pHeadCell);
 
 		for (unsigned int i = 1; i <= m_length - 2; ++i) {
-			PCellPtr pBodyCell = s_MakePCell(startX + i, startY, s_MakeCell(Cell{ .codepoint = TGLYPHS::SNAKE_BODY }));
+			PCellPtr pBodyCell = makePooledPCell(startX + i, startY, s_MakeCell(Cell{ .codepoint = TGLYPHS::SNAKE_BODY }));
 			addPCell(pBodyCell);
 		}
 
-		PCellPtr pTailCell = s_MakePCell(startX + m_length - 1, startY, s_MakeCell(Cell{ .codepoint = TGLYPHS::SNAKE_TAIL_RIGHT }));
+		PCellPtr pTailCell = makePooledPCell(startX + m_length - 1, startY, s_MakeCell(Cell{ .codepoint = TGLYPHS::SNAKE_TAIL_RIGHT }));
 		addPCell(pTailCell);
 	}
 
@@ -265,6 +423,11 @@ namespace Snake
 		return {0, 0}; // Fallback (shouldn't happen)
 	}
 
+	Snake::Direction Snake::direction() const noexcept
+	{
+		return m_currentDirection;
+	}
+
 	void Snake::move()
 	{
 		if (m_cells.empty())
@@ -347,7 +510,7 @@ namespace Snake
 		if (m_cells.size() < 2)
 		{
 			// Edge case: snake too small to grow properly
-			BOOST_LOG_TRIVIAL(warning) << "Snake too small to grow";
+			SNAKE_LOG(warning) << "Snake too small to grow";
 
 			return;
 		}
@@ -395,7 +558,7 @@ namespace Snake
 
 		m_length++; // Update length counter
 
-		BOOST_LOG_TRIVIAL(info) << "Snake grew! New length: " << m_length;
+		SNAKE_LOG(info) << "Snake grew! New length: " << m_length;
 	}
 
 	CollisionResult Snake::getCollisionResult(BaseObject const& other) const
@@ -414,16 +577,45 @@ namespace Snake
 		}
 	}
 
+	void Snake::restore(PosVector const& positions, uint32_t headGlyph, uint32_t tailGlyph, Direction direction)
+	{
+		// Body cells are interchangeable; only the count between head and tail changes
+		while (m_cells.size() > positions.size())
+		{
+			m_cells.erase(m_cells.end() - 2);
+		}
+
+		while (m_cells.size() < positions.size())
+		{
+			PCellPtr body = s_MakePCell(0, 0, s_MakeCell(Cell{ .codepoint = TGLYPHS::SNAKE_BODY }));
+			m_cells.insert(m_cells.end() - 1, std::move(body));
+		}
+
+		for (size_t i = 0; i < positions.size(); ++i)
+		{
+			m_cells[i]->x = positions[i].first;
+			m_cells[i]->y = positions[i].second;
+		}
+
+		m_cells.front()->cell->codepoint = headGlyph;
+		m_cells.back()->cell->codepoint = tailGlyph;
+		m_currentDirection = direction;
+		m_length = static_cast<unsigned int>(positions.size());
+
+		settlePositions();
+	}
+
 	void Snake::logCells() const
 	{
 		for (const PCellPtr& cell : m_cells) {
-			BOOST_LOG_TRIVIAL(info) << "Cell at (" << cell->x << ", " << cell->y << ")";
+			SNAKE_LOG(info) << "Cell at (" << cell->x << ", " << cell->y << ")";
 		}
 	}
 
 	Food::Food(unsigned int x, unsigned int y)
 		: BaseObject(CollisionType::TRIGGER, Attributes::NONE)
 	{
+		setCollisionFilter(CollisionLayer::FOOD, CollisionLayer::SNAKE);
 		PCellPtr pFoodCell = s_MakePCell(x, y, s_MakeCell(Cell{ .codepoint = TGLYPHS::FOOD }));
 		addPCell(pFoodCell);
 	}
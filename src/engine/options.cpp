@@ -0,0 +1,315 @@
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+#include "include/options.h"
+
+namespace Snake
+{
+	namespace
+	{
+		/**
+		 * @brief Parses the unsigned value of a `--name=value` argument
+		 */
+		uint64_t parseUnsigned(std::string_view arg, std::string_view value, uint64_t max = 0xFFFFFFFFull)
+		{
+			if (value.empty())
+			{
+				throw std::invalid_argument("Missing value for " + std::string(arg));
+			}
+
+			uint64_t result = 0;
+
+			for (char c : value)
+			{
+				if (c < '0' || c > '9')
+				{
+					throw std::invalid_argument("Invalid number for " + std::string(arg) + ": " + std::string(value));
+				}
+
+				if (result > (max - (c - '0')) / 10)
+				{
+					throw std::invalid_argument("Number out of range for " + std::string(arg));
+				}
+
+				result = result * 10 + (c - '0');
+			}
+
+			return result;
+		}
+
+		/**
+		 * @brief Parses a `<w>x<h>` board size
+		 */
+		void parseSize(std::string_view arg, std::string_view value, unsigned int& width, unsigned int& height)
+		{
+			size_t x = value.find('x');
+
+			if (x == std::string_view::npos)
+			{
+				throw std::invalid_argument("Expected <w>x<h> for " + std::string(arg));
+			}
+
+			width = static_cast<unsigned int>(parseUnsigned(arg, value.substr(0, x), 0xFFFF));
+			height = static_cast<unsigned int>(parseUnsigned(arg, value.substr(x + 1), 0xFFFF));
+
+			if (width < Options::s_MinWidth || height < Options::s_MinHeight)
+			{
+				throw std::invalid_argument("Board too small for " + std::string(arg));
+			}
+		}
+	}
+
+	Options Options::parse(int argc, char* argv[])
+	{
+		Options options;
+
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string_view arg(argv[i]);
+			std::string_view name = arg.substr(0, arg.find('='));
+			std::string_view value = name.size() < arg.size() ? arg.substr(name.size() + 1) : std::string_view();
+
+			if (name == "--startup-profile")
+			{
+				options.startupProfile = true;
+			}
+			else if (name == "--startup-budget")
+			{
+				options.startupBudgetMs = static_cast<unsigned int>(parseUnsigned(name, value));
+			}
+			else if (name == "--memory-report")
+			{
+				options.memoryReport = true;
+			}
+			else if (name == "--trace")
+			{
+				options.tracePath = value;
+			}
+			else if (name == "--flight-recorder")
+			{
+				if (value.empty())
+					throw std::invalid_argument("Missing value for " + std::string(name));
+
+				options.flightPath = value;
+			}
+			else if (name == "--decode-flight")
+			{
+				options.decodeFlightPath = value;
+			}
+			else if (name == "--hud")
+			{
+				options.hud = true;
+			}
+			else if (name == "--parallel-phases")
+			{
+				options.parallelPhases = true;
+			}
+			else if (name == "--headless")
+			{
+				options.headless = true;
+			}
+			else if (name == "--casual")
+			{
+				options.casual = true;
+			}
+			else if (name == "--autopilot")
+			{
+				options.autopilot = true;
+			}
+			else if (name == "--mcts")
+			{
+				options.mcts = true;
+			}
+			else if (name == "--mcts-budget")
+			{
+				options.mctsBudget = static_cast<unsigned int>(parseUnsigned(name, value, 100));
+			}
+			else if (name == "--bot")
+			{
+				options.botPath = value;
+			}
+			else if (name == "--bot-budget")
+			{
+				options.botBudget = static_cast<unsigned int>(parseUnsigned(name, value, 100));
+			}
+			else if (name == "--tick-rate")
+			{
+				options.tickRate = static_cast<unsigned int>(parseUnsigned(name, value, 1000));
+			}
+			else if (name == "--fps")
+			{
+				options.fps = static_cast<unsigned int>(parseUnsigned(name, value, 1000));
+			}
+			else if (name == "--mcts-bench")
+			{
+				options.mctsBench = true;
+			}
+			else if (name == "--size")
+			{
+				parseSize(name, value, options.width, options.height);
+			}
+			else if (name == "--ticks")
+			{
+				options.ticks = parseUnsigned(name, value, UINT64_MAX);
+			}
+			else if (name == "--script")
+			{
+				options.scriptPath = value;
+			}
+			else if (name == "--replay")
+			{
+				options.replayPath = value;
+			}
+			else if (name == "--record-replay")
+			{
+				options.recordPath = value;
+			}
+			else if (name == "--record-frames")
+			{
+				options.framesPath = value;
+			}
+			else if (name == "--play")
+			{
+				options.playPath = value;
+			}
+			else if (name == "--seek")
+			{
+				options.seekTick = parseUnsigned(name, value, UINT64_MAX);
+			}
+			else if (name == "--asciicast")
+			{
+				options.asciicastPath = value;
+			}
+			else if (name == "--serve")
+			{
+				options.servePath = value;
+			}
+			else if (name == "--spectate")
+			{
+				options.spectatePath = value;
+			}
+			else if (name == "--shm")
+			{
+				options.shmName = value;
+			}
+			else if (name == "--level")
+			{
+				options.levelPath = value;
+			}
+			else if (name == "--compile-level")
+			{
+				options.compileLevelPath = value;
+			}
+			else if (name == "--seed")
+			{
+				options.seed = parseUnsigned(name, value, UINT64_MAX);
+			}
+			else if (name == "--batch")
+			{
+				options.batchGames = static_cast<size_t>(parseUnsigned(name, value));
+			}
+			else if (name == "--threads")
+			{
+				options.threads = static_cast<unsigned int>(parseUnsigned(name, value, 1024));
+			}
+			else
+			{
+				throw std::invalid_argument("Unknown option: " + std::string(arg));
+			}
+		}
+
+		if (options.tickRate == 0 || options.fps == 0)
+		{
+			throw std::invalid_argument("--tick-rate and --fps must be at least 1");
+		}
+
+		if (!options.replayPath.empty() && (!options.recordPath.empty() || !options.scriptPath.empty()))
+		{
+			throw std::invalid_argument("--replay cannot be combined with --record-replay or --script");
+		}
+
+		if (options.casual && (!options.replayPath.empty() || !options.recordPath.empty()))
+		{
+			throw std::invalid_argument("--casual cannot be combined with replays");
+		}
+
+		if (options.autopilot && (!options.replayPath.empty() || !options.scriptPath.empty()))
+		{
+			throw std::invalid_argument("--autopilot cannot be combined with --replay or --script");
+		}
+
+		if (options.mcts && (options.autopilot || !options.replayPath.empty() || !options.scriptPath.empty()))
+		{
+			throw std::invalid_argument("--mcts cannot be combined with --autopilot, --replay or --script");
+		}
+
+		if (options.hud && options.headless)
+		{
+			throw std::invalid_argument("--hud needs a terminal and cannot be combined with --headless");
+		}
+
+		if (!options.botPath.empty() && (options.autopilot || options.mcts || !options.replayPath.empty() || !options.scriptPath.empty()))
+		{
+			throw std::invalid_argument("--bot cannot be combined with --autopilot, --mcts, --replay or --script");
+		}
+
+		if (!options.asciicastPath.empty() && options.playPath.empty())
+		{
+			throw std::invalid_argument("--asciicast needs a recording given with --play");
+		}
+
+		if (!options.compileLevelPath.empty() && options.levelPath.empty())
+		{
+			throw std::invalid_argument("--compile-level needs the level file to write given with --level");
+		}
+
+		if (!options.levelPath.empty() && (options.batchGames > 0 || options.mctsBench))
+		{
+			throw std::invalid_argument("--level cannot be combined with --batch or --mcts-bench");
+		}
+
+		return options;
+	}
+
+	std::string Options::usage()
+	{
+		return
+			"Usage: snake [options]\n"
+			"  --startup-profile        print startup phase timings on exit\n"
+			"  --startup-budget=<ms>    startup latency budget used by the profile (default 50)\n"
+			"  --memory-report          print the memory used per subsystem on exit (SIGUSR1 logs it at any time)\n"
+			"  --trace=<path>           write a Chrome trace of the frame phases on exit\n"
+			"  --flight-recorder=<path> where the flight recorder of the last ticks is dumped (default logs/snake.flight)\n"
+			"  --decode-flight=<path>   print a flight recorder dump as text\n"
+			"  --hud                    show tick time, frame size, fps, input latency and score below the board\n"
+			"  --parallel-phases        check collisions and encode frames on --threads threads, with the same results\n"
+			"  --headless               simulate without a terminal, as fast as possible\n"
+			"  --casual                 a death rewinds the game a couple of seconds instead of ending it\n"
+			"  --autopilot              let a pathfinding bot play instead of the keyboard or random input\n"
+			"  --mcts                   let a Monte Carlo tree search bot play (uses --threads)\n"
+			"  --mcts-budget=<percent>  share of each tick the MCTS bot searches for (default 50)\n"
+			"  --bot=<path>             let a bot plugin (a shared object, see snakebot.h) play\n"
+			"  --bot-budget=<percent>   share of each tick a bot plugin may take to decide (default 50)\n"
+			"  --tick-rate=<hz>         simulation ticks per second, 1 to 1000 (default 4)\n"
+			"  --fps=<hz>               most frames drawn per second, independent of the tick rate (default 30)\n"
+			"  --mcts-bench             report MCTS playouts per second per thread for 1, 2, 4, ... threads\n"
+			"  --size=<w>x<h>           board size in headless mode (default 80x24)\n"
+			"  --ticks=<n>              ticks to simulate in headless mode, 0 = until Ctrl+C (default 1000000)\n"
+			"  --script=<path>          read input from a script of '<tick> <up|down|left|right>' lines\n"
+			"  --replay=<path>          play back a recorded replay at full speed and verify its checksums\n"
+			"  --record-replay=<path>   record the game's inputs to a replay file\n"
+			"  --record-frames=<path>   record the rendered frames to a seekable recording\n"
+			"  --play=<path>            play a frame recording (arrows seek and change speed, space pauses)\n"
+			"  --seek=<tick>            tick to start playback at\n"
+			"  --asciicast=<path>       export the recording given by --play to an asciicast file\n"
+			"  --serve=<path>           broadcast the game to spectators on a Unix domain socket\n"
+			"  --spectate=<path>        watch a game broadcast with --serve\n"
+			"  --shm=<name>             export every frame and its game state to a shared memory ring\n"
+			"  --level=<path>           play on a level file; its size replaces the terminal or --size board\n"
+			"  --compile-level=<path>   compile a text map ('#' obstacle, '<>^v' spawns) into the file given by --level\n"
+			"  --seed=<n>               seed for food placement and generated input (default: random)\n"
+			"  --batch=<n>              step <n> games in parallel for --ticks steps and report steps per second\n"
+			"  --threads=<n>            worker threads for parallel modes (default: all cores)\n";
+	}
+};
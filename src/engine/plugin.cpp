@@ -0,0 +1,416 @@
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <dlfcn.h>
+#endif
+
+#include "include/game.h"
+#include "include/level.h"
+#include "include/log.h"
+#include "include/plugin.h"
+#include "include/trace.h"
+
+namespace Snake
+{
+	struct PluginController::Call
+	{
+		std::mutex mutex;
+		/** @brief Wakes the thread for a request or to stop, and the game for an answer */
+		std::condition_variable changed;
+
+		SnakeBotApi const* api = nullptr;
+		void* bot = nullptr;
+		/** @brief Copy of the controller's view for the call; its cells and body stay the controller's */
+		SnakeBotView view{};
+
+		bool pending = false;
+		bool running = false;
+		bool stop = false;
+		uint32_t move = SNAKE_BOT_KEEP;
+
+		uint64_t decisions = 0;
+		std::chrono::nanoseconds totalTime{ 0 };
+		std::chrono::nanoseconds worstTime{ 0 };
+
+		/** @brief The view's cells and body, kept here when a call outlives the controller */
+		std::vector<uint8_t> cells;
+		std::vector<uint32_t> body;
+
+		static void s_Run(std::shared_ptr<Call> call)
+		{
+			Trace::nameThread("bot");
+
+			std::unique_lock<std::mutex> lock(call->mutex);
+
+			while (true)
+			{
+				call->changed.wait(lock, [&call] { return call->pending || call->stop; });
+
+				if (call->stop)
+				{
+					return;
+				}
+
+				call->pending = false;
+				call->running = true;
+				lock.unlock();
+
+				const auto start = std::chrono::steady_clock::now();
+				const uint32_t move = call->api->decide(call->bot, &call->view);
+				const std::chrono::nanoseconds took = std::chrono::steady_clock::now() - start;
+
+				lock.lock();
+				call->move = move;
+				call->running = false;
+				++call->decisions;
+				call->totalTime += took;
+				call->worstTime = std::max(call->worstTime, took);
+				call->changed.notify_all();
+			}
+		}
+	};
+
+	PluginController::PluginController(std::filesystem::path const& path, std::chrono::nanoseconds budget)
+		: m_budget(budget)
+	{
+#if defined(_WIN32)
+		(void)path;
+
+		throw std::runtime_error("Bot plugins are not supported on Windows");
+#else
+		// RTLD_LOCAL: two plugins may export the same symbols without seeing each other's
+		m_library = ::dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+
+		if (!m_library)
+			throw std::runtime_error(std::string("Failed to load bot plugin: ") + ::dlerror());
+
+		auto entry = reinterpret_cast<SnakeBotEntry>(::dlsym(m_library, SNAKE_BOT_ENTRY));
+		m_api = entry ? entry() : nullptr;
+
+		if (!m_api || m_api->abiVersion != SNAKE_BOT_ABI_VERSION || !m_api->decide)
+		{
+			const std::string reason = !entry ? "it does not export " SNAKE_BOT_ENTRY
+				: !m_api || !m_api->decide ? "it returned no decide function"
+				: "it was built for ABI version " + std::to_string(m_api->abiVersion) + ", not " + std::to_string(SNAKE_BOT_ABI_VERSION);
+
+			::dlclose(m_library);
+
+			throw std::runtime_error("Failed to load bot plugin " + path.string() + ": " + reason);
+		}
+
+		SNAKE_LOG(info) << "Loaded bot " << (m_api->name ? m_api->name : "?") << " from " << path.string()
+			<< ", budget " << std::chrono::duration_cast<std::chrono::microseconds>(m_budget).count() << " us per decision";
+
+		m_call = std::make_shared<Call>();
+		m_call->api = m_api;
+		m_thread = std::thread(&Call::s_Run, m_call);
+#endif
+	}
+
+	PluginController::~PluginController()
+	{
+		bool hung = false;
+
+		if (m_call)
+		{
+			std::unique_lock<std::mutex> lock(m_call->mutex);
+
+			// A late call gets one more budget to return before it is given up on
+			hung = !m_call->changed.wait_for(lock, m_budget, [this] { return !m_call->running; });
+			m_call->stop = true;
+
+			if (hung)
+			{
+				m_call->cells = std::move(m_cells); // moving keeps the buffers the running call reads
+				m_call->body = std::move(m_body);
+			}
+
+			m_call->changed.notify_all();
+		}
+
+		if (hung)
+		{
+			SNAKE_LOG(warning) << "Bot " << (m_api->name ? m_api->name : "?") << " is still deciding; leaving it running and loaded";
+
+			m_thread.detach();
+
+			return;
+		}
+
+		if (m_thread.joinable())
+		{
+			m_thread.join();
+		}
+
+		destroyBot();
+
+#if !defined(_WIN32)
+		if (m_library)
+		{
+			::dlclose(m_library);
+		}
+#endif
+	}
+
+	void PluginController::destroyBot() noexcept
+	{
+		if (m_created && m_api->destroy)
+		{
+			m_api->destroy(m_bot);
+		}
+
+		m_bot = nullptr;
+		m_created = false;
+	}
+
+	Input::KeyKind PluginController::nextKey(Game const& game)
+	{
+		if (m_disqualified)
+		{
+			return Input::KeyKind::None;
+		}
+
+		// One budget per tick, also for finishing a late decision of an earlier tick: the view is in use until it returns
+		const auto deadline = std::chrono::steady_clock::now() + m_budget;
+
+		{
+			std::unique_lock<std::mutex> lock(m_call->mutex);
+
+			if (!m_call->changed.wait_until(lock, deadline, [this] { return !m_call->running; }))
+			{
+				lock.unlock();
+				strike(game.ticksElapsed());
+
+				return Input::KeyKind::None;
+			}
+		}
+
+		if (!m_created || game.width() != m_view.width || game.height() != m_view.height || game.obstacles() != m_obstacles)
+		{
+			reset(game.width(), game.height(), game.obstacles());
+		}
+
+		syncSnake(game);
+		syncFood(game);
+
+		m_view.direction = static_cast<uint32_t>(game.snake().direction());
+		m_view.tick = game.ticksElapsed();
+
+		std::unique_lock<std::mutex> lock(m_call->mutex);
+
+		m_call->view = m_view;
+		m_call->bot = m_bot;
+		m_call->pending = true;
+		m_call->changed.notify_all();
+
+		if (!m_call->changed.wait_until(lock, deadline, [this] { return !m_call->pending && !m_call->running; }))
+		{
+			m_call->pending = false; // withdrawn if the thread has not picked it up yet
+			lock.unlock();
+
+			strike(m_view.tick); // too late: the tick goes on as if the bot had kept its direction
+
+			return Input::KeyKind::None;
+		}
+
+		const uint32_t move = m_call->move;
+		lock.unlock();
+
+		m_strikes = 0;
+
+		if (move > SNAKE_BOT_KEEP)
+		{
+			++m_invalid;
+
+			return Input::KeyKind::None;
+		}
+
+		if (move == SNAKE_BOT_KEEP || move == m_view.direction)
+		{
+			return Input::KeyKind::None;
+		}
+
+		return static_cast<Input::KeyKind>(static_cast<unsigned int>(Input::KeyKind::ArrowUp) + move);
+	}
+
+	void PluginController::strike(uint64_t tick)
+	{
+		++m_overruns;
+
+		if (++m_strikes >= SNAKE_BOT_STRIKES)
+		{
+			m_disqualified = true;
+
+			SNAKE_LOG(warning) << "Bot " << (m_api->name ? m_api->name : "?") << " disqualified at tick " << tick << ": "
+				<< m_strikes << " ticks in a row without an answer within "
+				<< std::chrono::duration_cast<std::chrono::microseconds>(m_budget).count() << " us";
+		}
+	}
+
+	std::string PluginController::report() const
+	{
+		std::ostringstream out;
+		uint64_t decisions;
+		std::chrono::nanoseconds totalTime;
+		std::chrono::nanoseconds worstTime;
+
+		{
+			std::lock_guard<std::mutex> lock(m_call->mutex);
+
+			decisions = m_call->decisions;
+			totalTime = m_call->totalTime;
+			worstTime = m_call->worstTime;
+		}
+
+		const double average = decisions ? static_cast<double>(totalTime.count()) / decisions / 1000.0 : 0.0;
+
+		out << "bot:         " << (m_api->name ? m_api->name : "?") << (m_disqualified ? " (disqualified)" : "") << "\n"
+			<< "decisions:   " << decisions << "\n"
+			<< "decision us: " << average << " avg, " << worstTime.count() / 1000.0 << " max\n"
+			<< "overruns:    " << m_overruns << " over " << m_budget.count() / 1000.0 << " us\n";
+
+		if (m_invalid)
+		{
+			out << "invalid:     " << m_invalid << " answers\n";
+		}
+
+		return out.str();
+	}
+
+	void PluginController::reset(unsigned int width, unsigned int height, Obstacles const* obstacles)
+	{
+		destroyBot();
+
+		m_obstacles = obstacles;
+
+		const size_t area = static_cast<size_t>(width) * height;
+
+		m_cells.assign(area, SNAKE_BOT_FREE);
+		m_segments.assign(area, 0);
+		m_body.assign(area + 1, 0); // every cell, plus the tail a snake that just grew keeps twice
+
+		for (unsigned int x = 0; x < width; ++x)
+		{
+			m_cells[x] = SNAKE_BOT_WALL;
+			m_cells[(height - 1) * width + x] = SNAKE_BOT_WALL;
+		}
+
+		for (unsigned int y = 0; y < height; ++y)
+		{
+			m_cells[y * width] = SNAKE_BOT_WALL;
+			m_cells[y * width + width - 1] = SNAKE_BOT_WALL;
+		}
+
+		if (obstacles)
+		{
+			for (LevelFormat::Run const& run : obstacles->level().runs())
+			{
+				for (uint32_t x = run.x; x < run.x + run.length && x < width - 1 && run.y < height - 1; ++x)
+				{
+					m_cells[run.y * width + x] = SNAKE_BOT_WALL;
+				}
+			}
+		}
+
+		m_view = SnakeBotView{};
+		m_view.width = width;
+		m_view.height = height;
+		m_view.cells = m_cells.data();
+		m_view.body = m_body.data();
+		m_view.bodyCapacity = static_cast<uint32_t>(m_body.size());
+		m_view.food = SNAKE_BOT_NO_FOOD;
+		m_view.budgetNs = static_cast<uint64_t>(m_budget.count());
+
+		m_bot = m_api->create ? m_api->create(width, height) : nullptr;
+		m_created = true;
+	}
+
+	void PluginController::addSegment(uint32_t cell) noexcept
+	{
+		++m_segments[cell];
+
+		if (m_cells[cell] != SNAKE_BOT_WALL)
+		{
+			m_cells[cell] = SNAKE_BOT_SNAKE; // a head that died in a wall leaves the wall alone
+		}
+	}
+
+	void PluginController::removeSegment(uint32_t cell) noexcept
+	{
+		if (--m_segments[cell] == 0 && m_cells[cell] == SNAKE_BOT_SNAKE)
+		{
+			m_cells[cell] = SNAKE_BOT_FREE;
+		}
+	}
+
+	void PluginController::syncSnake(Game const& game)
+	{
+		const auto& cells = game.snake().cells();
+		const uint32_t width = m_view.width;
+		const uint32_t length = m_view.length;
+		const uint32_t capacity = m_view.bodyCapacity;
+
+		auto at = [&](size_t i) { return cells[i]->y * width + cells[i]->x; };
+
+		// Usual tick: a new head in front of the old one, and the old tail dropped unless the snake grew
+		const bool shifted = length > 0 && cells.size() >= 2 && (cells.size() == length || cells.size() == length + 1) &&
+			at(1) == snake_bot_segment(&m_view, 0) && at(cells.size() - 1) == snake_bot_segment(&m_view, static_cast<uint32_t>(cells.size()) - 2);
+
+		if (shifted)
+		{
+			m_view.bodyHead = (m_view.bodyHead + capacity - 1) % capacity;
+			m_body[m_view.bodyHead] = at(0);
+			addSegment(at(0));
+
+			if (cells.size() == length)
+			{
+				removeSegment(m_body[(m_view.bodyHead + length) % capacity]);
+			}
+
+			m_view.length = static_cast<uint32_t>(cells.size());
+
+			return;
+		}
+
+		for (uint32_t i = 0; i < length; ++i)
+		{
+			removeSegment(snake_bot_segment(&m_view, i));
+		}
+
+		m_view.bodyHead = 0;
+		m_view.length = static_cast<uint32_t>(std::min<size_t>(cells.size(), capacity));
+
+		for (uint32_t i = 0; i < m_view.length; ++i)
+		{
+			m_body[i] = at(i);
+			addSegment(m_body[i]);
+		}
+	}
+
+	void PluginController::syncFood(Game const& game)
+	{
+		Food const* food = game.food();
+		const uint32_t cell = food ? food->cells().front()->y * m_view.width + food->cells().front()->x : SNAKE_BOT_NO_FOOD;
+
+		if (cell == m_view.food)
+		{
+			return;
+		}
+
+		if (m_view.food != SNAKE_BOT_NO_FOOD && m_cells[m_view.food] == SNAKE_BOT_FOOD)
+		{
+			m_cells[m_view.food] = SNAKE_BOT_FREE; // eaten food is already under the head
+		}
+
+		if (cell != SNAKE_BOT_NO_FOOD && m_cells[cell] == SNAKE_BOT_FREE)
+		{
+			m_cells[cell] = SNAKE_BOT_FOOD;
+		}
+
+		m_view.food = cell;
+	}
+};
@@ -0,0 +1,63 @@
+#include <cstdio>
+
+#include "include/profile.h"
+
+namespace Snake
+{
+	namespace
+	{
+		/** @brief Taken during static initialization, before `main` runs */
+		const std::chrono::steady_clock::time_point s_ProcessStart = std::chrono::steady_clock::now();
+	}
+
+	StartupProfile::StartupProfile()
+		: m_start(s_ProcessStart)
+	{
+		m_phases.reserve(8);
+		mark("process");
+	}
+
+	void StartupProfile::mark(const char* phase)
+	{
+		m_phases.push_back({ phase, std::chrono::steady_clock::now() });
+	}
+
+	std::chrono::microseconds StartupProfile::total() const noexcept
+	{
+		if (m_phases.empty())
+		{
+			return std::chrono::microseconds(0);
+		}
+
+		return std::chrono::duration_cast<std::chrono::microseconds>(m_phases.back().end - m_start);
+	}
+
+	std::string StartupProfile::report(unsigned int budgetMs) const
+	{
+		using std::chrono::duration_cast;
+		using std::chrono::microseconds;
+
+		const microseconds budget = std::chrono::milliseconds(budgetMs);
+		std::string out = "Startup profile:\n";
+		char line[128];
+		auto phaseStart = m_start;
+
+		for (const Phase& phase : m_phases)
+		{
+			auto took = duration_cast<microseconds>(phase.end - phaseStart).count();
+			auto cumulative = duration_cast<microseconds>(phase.end - m_start);
+
+			std::snprintf(line, sizeof(line), "  %-16s %9.3f ms  (at %9.3f ms)%s\n",
+				phase.name, took / 1000.0, cumulative.count() / 1000.0,
+				cumulative > budget ? "  OVER BUDGET" : "");
+			out += line;
+
+			phaseStart = phase.end;
+		}
+
+		std::snprintf(line, sizeof(line), "  %-16s %9.3f ms  (budget %u ms)\n", "total", total().count() / 1000.0, budgetMs);
+		out += line;
+
+		return out;
+	}
+};
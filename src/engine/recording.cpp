@@ -0,0 +1,670 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include "include/input.h"
+#include "include/log.h"
+#include "include/recording.h"
+#include "include/terminal.h"
+#include "include/varint.h"
+
+namespace Snake
+{
+	namespace
+	{
+		/**
+		 * @brief Escapes a string for a JSON string literal
+		 */
+		std::string jsonEscape(std::string const& in)
+		{
+			std::string out;
+			out.reserve(in.size() + in.size() / 4);
+
+			for (unsigned char c : in)
+			{
+				if (c == '"' || c == '\\')
+				{
+					out += '\\';
+					out += static_cast<char>(c);
+				}
+				else if (c < 0x20)
+				{
+					char escaped[8];
+					std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+					out += escaped;
+				}
+				else
+				{
+					out += static_cast<char>(c); // UTF-8 passes through
+				}
+			}
+
+			return out;
+		}
+	}
+
+	FrameRecorder::FrameRecorder(std::filesystem::path const& path, unsigned int width, unsigned int height,
+		unsigned int frameMs, unsigned int keyframeInterval)
+		: m_path(path),
+		  m_out(path, std::ios::binary | std::ios::trunc),
+		  m_width(width),
+		  m_height(height),
+		  m_keyframeInterval(std::max(1u, keyframeInterval)),
+		  m_encoder(width, height)
+	{
+		if (!m_out.is_open())
+			throw std::runtime_error("Failed to create recording " + path.string());
+
+		m_bytes.reserve(static_cast<size_t>(width) * height);
+		m_bytes.insert(m_bytes.end(), std::begin(FrameFormat::MAGIC), std::end(FrameFormat::MAGIC));
+		m_bytes.push_back(FrameFormat::VERSION);
+
+		Varint::append(m_bytes, width);
+		Varint::append(m_bytes, height);
+		Varint::append(m_bytes, frameMs);
+		Varint::append(m_bytes, m_keyframeInterval);
+
+		write();
+	}
+
+	FrameRecorder::~FrameRecorder()
+	{
+		try
+		{
+			finish();
+		}
+		catch (const std::exception& e)
+		{
+			SNAKE_LOG(error) << e.what();
+		}
+	}
+
+	uint64_t FrameRecorder::frames() const noexcept
+	{
+		return m_frames;
+	}
+
+	uint64_t FrameRecorder::bytes() const noexcept
+	{
+		return m_offset;
+	}
+
+	void FrameRecorder::frame(ScreenBuffer const& buffer)
+	{
+		const bool keyframe = m_frames % m_keyframeInterval == 0;
+
+		if (keyframe)
+		{
+			m_index.emplace_back(m_frames, m_offset);
+		}
+
+		m_encoder.encode(buffer, keyframe, m_bytes);
+		write();
+
+		++m_frames;
+	}
+
+	FrameEncoder::FrameEncoder(unsigned int width, unsigned int height)
+	{
+		m_current.reserve(static_cast<size_t>(width) * height);
+		m_previous.reserve(static_cast<size_t>(width) * height);
+	}
+
+	void FrameEncoder::encode(ScreenBuffer const& buffer, bool keyframe, std::vector<uint8_t>& out)
+	{
+		buffer.snapshot(m_current);
+
+		if (keyframe || m_previous.size() != m_current.size())
+		{
+			encodeKeyframe(out);
+		}
+		else
+		{
+			encodeDelta(out);
+		}
+
+		std::swap(m_current, m_previous);
+	}
+
+	void FrameEncoder::encodeCell(PackedCell const& cell, std::vector<uint8_t>& out)
+	{
+		auto it = std::find(m_palette.begin(), m_palette.end(), cell);
+
+		Varint::append(out, static_cast<uint64_t>(it - m_palette.begin()));
+
+		if (it != m_palette.end())
+		{
+			return;
+		}
+
+		Varint::append(out, cell.codepoint);
+		out.push_back(cell.flags);
+
+		if (!(cell.flags & PackedCell::DEFAULT_FG))
+			out.push_back(cell.fg);
+
+		if (!(cell.flags & PackedCell::DEFAULT_BG))
+			out.push_back(cell.bg);
+
+		m_palette.push_back(cell);
+	}
+
+	void FrameEncoder::encodeKeyframe(std::vector<uint8_t>& out)
+	{
+		out.push_back(FrameFormat::KEYFRAME);
+		m_palette.clear();
+
+		for (size_t i = 0; i < m_current.size();)
+		{
+			size_t run = i + 1;
+
+			while (run < m_current.size() && m_current[run] == m_current[i])
+			{
+				++run;
+			}
+
+			Varint::append(out, run - i);
+			encodeCell(m_current[i], out);
+
+			i = run;
+		}
+	}
+
+	void FrameEncoder::encodeDelta(std::vector<uint8_t>& out)
+	{
+		out.push_back(FrameFormat::DELTA);
+
+		// A recolor A -> B is usable when no cell keeps fg A and every cell that only changes its fg from A turns B
+		std::array<int, 256> target;
+		std::array<bool, 256> blocked{};
+		target.fill(-1);
+
+		for (size_t i = 0; i < m_current.size(); ++i)
+		{
+			const PackedCell& before = m_previous[i];
+			const PackedCell& after = m_current[i];
+
+			if (before.flags & PackedCell::DEFAULT_FG)
+			{
+				continue;
+			}
+
+			PackedCell recolored = before;
+			recolored.fg = after.fg;
+
+			if (after == before)
+			{
+				blocked[before.fg] = true;
+			}
+			else if (after == recolored)
+			{
+				if (target[before.fg] == -1)
+					target[before.fg] = after.fg;
+				else if (target[before.fg] != after.fg)
+					blocked[before.fg] = true;
+			}
+		}
+
+		std::array<uint8_t, 256> fgMap;
+		size_t recolors = 0;
+
+		for (int fg = 0; fg < 256; ++fg)
+		{
+			fgMap[fg] = static_cast<uint8_t>(fg);
+
+			if (!blocked[fg] && target[fg] != -1)
+			{
+				fgMap[fg] = static_cast<uint8_t>(target[fg]);
+				++recolors;
+			}
+		}
+
+		Varint::append(out, recolors);
+
+		for (int fg = 0; fg < 256; ++fg)
+		{
+			if (fgMap[fg] != fg)
+			{
+				out.push_back(static_cast<uint8_t>(fg));
+				out.push_back(fgMap[fg]);
+			}
+		}
+
+		auto expected = [&](size_t i) {
+			PackedCell cell = m_previous[i];
+
+			if (!(cell.flags & PackedCell::DEFAULT_FG))
+				cell.fg = fgMap[cell.fg];
+
+			return cell;
+		};
+
+		size_t changes = 0;
+
+		for (size_t i = 0; i < m_current.size(); ++i)
+		{
+			changes += !(m_current[i] == expected(i));
+		}
+
+		Varint::append(out, changes);
+
+		size_t next = 0; // index the next gap counts from
+
+		for (size_t i = 0; i < m_current.size() && changes > 0; ++i)
+		{
+			if (m_current[i] == expected(i))
+			{
+				continue;
+			}
+
+			Varint::append(out, i - next);
+			encodeCell(m_current[i], out);
+
+			next = i + 1;
+			--changes;
+		}
+	}
+
+	void FrameRecorder::write()
+	{
+		m_out.write(reinterpret_cast<const char*>(m_bytes.data()), static_cast<std::streamsize>(m_bytes.size()));
+		m_offset += m_bytes.size();
+		m_bytes.clear();
+	}
+
+	void FrameRecorder::finish()
+	{
+		if (m_finished)
+		{
+			return;
+		}
+
+		m_finished = true;
+
+		const uint64_t indexOffset = m_offset;
+
+		for (const auto& [frame, offset] : m_index)
+		{
+			Varint::appendFixed64(m_bytes, frame);
+			Varint::appendFixed64(m_bytes, offset);
+		}
+
+		Varint::appendFixed64(m_bytes, indexOffset);
+		Varint::appendFixed64(m_bytes, m_frames);
+		m_bytes.insert(m_bytes.end(), std::begin(FrameFormat::INDEX_MAGIC), std::end(FrameFormat::INDEX_MAGIC));
+
+		write();
+		m_out.close();
+
+		if (m_out.fail())
+			throw std::runtime_error("Failed to write recording " + m_path.string());
+	}
+
+	FramePlayer::FramePlayer(std::filesystem::path const& path)
+		: m_file(path)
+	{
+		const uint8_t* data = m_file.data();
+		const size_t size = m_file.size();
+
+		if (size < sizeof(FrameFormat::MAGIC) + 1 + FrameFormat::TRAILER_SIZE ||
+			std::memcmp(data, FrameFormat::MAGIC, sizeof(FrameFormat::MAGIC)) != 0 ||
+			data[sizeof(FrameFormat::MAGIC)] != FrameFormat::VERSION)
+		{
+			throw std::runtime_error("Not a frame recording: " + path.string());
+		}
+
+		const uint8_t* trailer = data + size - FrameFormat::TRAILER_SIZE;
+
+		if (std::memcmp(trailer + 16, FrameFormat::INDEX_MAGIC, sizeof(FrameFormat::INDEX_MAGIC)) != 0)
+			throw std::runtime_error("Recording was not finished: " + path.string());
+
+		const uint64_t indexOffset = Varint::readFixed64(trailer);
+		m_frameCount = Varint::readFixed64(trailer + 8);
+
+		if (indexOffset > size - FrameFormat::TRAILER_SIZE || (size - FrameFormat::TRAILER_SIZE - indexOffset) % 16 != 0)
+			throw std::runtime_error("Corrupt recording index: " + path.string());
+
+		m_end = static_cast<size_t>(indexOffset);
+
+		for (size_t entry = m_end; entry < size - FrameFormat::TRAILER_SIZE; entry += 16)
+		{
+			m_index.emplace_back(Varint::readFixed64(data + entry), Varint::readFixed64(data + entry + 8));
+		}
+
+		if (m_frameCount == 0 || m_index.empty() || m_index.front().first != 0)
+			throw std::runtime_error("Empty recording: " + path.string());
+
+		size_t offset = sizeof(FrameFormat::MAGIC) + 1;
+		m_width = static_cast<unsigned int>(varint(offset));
+		m_height = static_cast<unsigned int>(varint(offset));
+		m_frameMs = static_cast<unsigned int>(varint(offset));
+		varint(offset); // keyframe interval, implied by the index
+
+		m_decoder.reset(m_width, m_height);
+		m_offset = static_cast<size_t>(m_index.front().second);
+
+		decodeFrame();
+	}
+
+	unsigned int FramePlayer::width() const noexcept
+	{
+		return m_width;
+	}
+
+	unsigned int FramePlayer::height() const noexcept
+	{
+		return m_height;
+	}
+
+	unsigned int FramePlayer::frameMs() const noexcept
+	{
+		return m_frameMs;
+	}
+
+	uint64_t FramePlayer::frameCount() const noexcept
+	{
+		return m_frameCount;
+	}
+
+	uint64_t FramePlayer::position() const noexcept
+	{
+		return m_position;
+	}
+
+	const std::vector<PackedCell>& FramePlayer::cells() const noexcept
+	{
+		return m_decoder.cells();
+	}
+
+	uint64_t FramePlayer::varint(size_t& offset) const
+	{
+		return Varint::read(m_file.data(), m_end, offset);
+	}
+
+	void FramePlayer::decodeFrame()
+	{
+		m_decoder.decode(m_file.data(), m_end, m_offset);
+	}
+
+	void FrameDecoder::reset(unsigned int width, unsigned int height)
+	{
+		m_cells.assign(static_cast<size_t>(width) * height, PackedCell{});
+		m_palette.clear();
+	}
+
+	const std::vector<PackedCell>& FrameDecoder::cells() const noexcept
+	{
+		return m_cells;
+	}
+
+	PackedCell FrameDecoder::decodeCell(const uint8_t* data, size_t size, size_t& offset)
+	{
+		auto byte = [&]()
+		{
+			if (offset >= size)
+				throw std::runtime_error("Truncated frame");
+
+			return data[offset++];
+		};
+
+		const uint64_t ref = Varint::read(data, size, offset);
+
+		if (ref < m_palette.size())
+		{
+			return m_palette[ref];
+		}
+
+		if (ref != m_palette.size())
+			throw std::runtime_error("Invalid palette reference in frame");
+
+		PackedCell cell;
+		cell.codepoint = static_cast<uint32_t>(Varint::read(data, size, offset));
+		cell.flags = byte();
+
+		if (!(cell.flags & PackedCell::DEFAULT_FG))
+			cell.fg = byte();
+
+		if (!(cell.flags & PackedCell::DEFAULT_BG))
+			cell.bg = byte();
+
+		m_palette.push_back(cell);
+
+		return cell;
+	}
+
+	void FrameDecoder::decode(const uint8_t* data, size_t size, size_t& offset)
+	{
+		auto byte = [&]()
+		{
+			if (offset >= size)
+				throw std::runtime_error("Truncated frame");
+
+			return data[offset++];
+		};
+
+		const uint8_t kind = byte();
+
+		if (kind == FrameFormat::KEYFRAME)
+		{
+			m_palette.clear();
+
+			for (size_t i = 0; i < m_cells.size();)
+			{
+				const uint64_t run = Varint::read(data, size, offset);
+				const PackedCell cell = decodeCell(data, size, offset);
+
+				if (run == 0 || run > m_cells.size() - i)
+					throw std::runtime_error("Invalid run in keyframe");
+
+				std::fill_n(m_cells.begin() + i, run, cell);
+				i += run;
+			}
+		}
+		else if (kind == FrameFormat::DELTA)
+		{
+			std::array<uint8_t, 256> fgMap;
+			uint64_t recolors = Varint::read(data, size, offset);
+
+			for (int fg = 0; fg < 256; ++fg)
+			{
+				fgMap[fg] = static_cast<uint8_t>(fg);
+			}
+
+			for (; recolors > 0; --recolors)
+			{
+				const uint8_t from = byte();
+				fgMap[from] = byte();
+			}
+
+			for (PackedCell& cell : m_cells)
+			{
+				if (!(cell.flags & PackedCell::DEFAULT_FG))
+					cell.fg = fgMap[cell.fg];
+			}
+
+			size_t next = 0;
+
+			for (uint64_t changes = Varint::read(data, size, offset); changes > 0; --changes)
+			{
+				const size_t i = next + Varint::read(data, size, offset);
+
+				if (i >= m_cells.size())
+					throw std::runtime_error("Invalid cell index in frame");
+
+				m_cells[i] = decodeCell(data, size, offset);
+				next = i + 1;
+			}
+		}
+		else
+		{
+			throw std::runtime_error("Unknown frame kind");
+		}
+	}
+
+	bool FramePlayer::next()
+	{
+		if (m_position + 1 >= m_frameCount)
+		{
+			return false;
+		}
+
+		decodeFrame();
+		++m_position;
+
+		return true;
+	}
+
+	void FramePlayer::seek(uint64_t frame)
+	{
+		frame = std::min(frame, m_frameCount - 1);
+
+		// Last keyframe at or before the target
+		auto keyframe = std::upper_bound(m_index.begin(), m_index.end(), frame,
+			[](uint64_t f, std::pair<uint64_t, uint64_t> const& entry) { return f < entry.first; }) - 1;
+
+		if (frame < m_position || keyframe->first > m_position)
+		{
+			m_offset = static_cast<size_t>(keyframe->second);
+			m_position = keyframe->first;
+			decodeFrame();
+		}
+
+		while (m_position < frame)
+		{
+			next();
+		}
+	}
+
+	void exportAsciicast(FramePlayer& player, std::ostream& out)
+	{
+		out << "{\"version\": 2, \"width\": " << player.width() << ", \"height\": " << player.height() << "}\n";
+
+		player.seek(0);
+
+		std::vector<PackedCell> previous;
+		std::string frame;
+
+		do
+		{
+			frame.clear();
+
+			if (previous.empty())
+			{
+				frame += TSEQ::CLEAR_SCREEN;
+				frame += TSEQ::HIDE_CURSOR;
+			}
+
+			Terminal::s_EncodeCells(frame, player.cells().data(), previous.empty() ? nullptr : previous.data(),
+				player.width(), player.height(), player.width(), player.height());
+
+			if (!frame.empty())
+			{
+				char time[32];
+				std::snprintf(time, sizeof(time), "%.3f", static_cast<double>(player.position()) * player.frameMs() / 1000.0);
+
+				out << "[" << time << ", \"o\", \"" << jsonEscape(frame) << "\"]\n";
+			}
+
+			previous = player.cells();
+		} while (player.next());
+	}
+
+	int playRecording(Options const& options)
+	{
+		try
+		{
+			FramePlayer player(options.playPath);
+
+			if (!options.asciicastPath.empty())
+			{
+				std::ofstream out(options.asciicastPath, std::ios::trunc);
+
+				if (!out.is_open())
+					throw std::runtime_error("Failed to create " + options.asciicastPath);
+
+				exportAsciicast(player, out);
+
+				std::cout << "exported " << player.frameCount() << " frames to " << options.asciicastPath << std::endl;
+
+				return 0;
+			}
+
+			player.seek(options.seekTick);
+
+			Terminal terminal;
+			std::signal(SIGINT, Input::signalHandler);
+
+			// Left/Right seek by this many frames, Up/Down double or halve the speed, Space pauses
+			const uint64_t seekFrames = std::max(1u, 10000 / std::max(1u, player.frameMs()));
+			unsigned int speed = 1;
+			bool paused = false;
+
+			std::vector<PackedCell> shown = player.cells();
+			uint64_t shownPosition = player.position();
+			auto lastFrame = std::chrono::steady_clock::now();
+
+			terminal.renderCells(shown.data(), nullptr, player.width(), player.height());
+
+			while (!Input::g_exitRequested)
+			{
+				Input::KeyEvent key = Input::readKey();
+
+				switch (key.kind)
+				{
+					case Input::KeyKind::Enter:
+						Input::g_exitRequested = true;
+						break;
+					case Input::KeyKind::Char:
+						paused = key.codepoint == U' ' ? !paused : paused;
+						break;
+					case Input::KeyKind::ArrowRight:
+						player.seek(player.position() + seekFrames);
+						break;
+					case Input::KeyKind::ArrowLeft:
+						player.seek(player.position() > seekFrames ? player.position() - seekFrames : 0);
+						break;
+					case Input::KeyKind::ArrowUp:
+						speed = std::min(speed * 2, 64u);
+						break;
+					case Input::KeyKind::ArrowDown:
+						speed = std::max(speed / 2, 1u);
+						break;
+					default:
+						break;
+				}
+
+				auto now = std::chrono::steady_clock::now();
+
+				if (!paused && now - lastFrame >= std::chrono::milliseconds(player.frameMs() / speed))
+				{
+					player.next(); // stays on the last frame at the end, so seeking back still works
+					lastFrame = now;
+				}
+
+				if (player.position() != shownPosition)
+				{
+					terminal.renderCells(player.cells().data(), shown.data(), player.width(), player.height());
+					shown = player.cells();
+					shownPosition = player.position();
+				}
+
+				// avoid busy-waiting
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			}
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+
+			return 1;
+		}
+
+		return 0;
+	}
+};
@@ -0,0 +1,233 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "include/game.h"
+#include "include/replay.h"
+#include "include/varint.h"
+
+namespace Snake
+{
+	ReplayWriter::ReplayWriter(std::filesystem::path path, uint64_t seed, unsigned int width, unsigned int height, unsigned int checksumInterval)
+		: m_path(std::move(path)),
+		  m_checksumInterval(checksumInterval)
+	{
+		m_bytes.reserve(4096);
+		m_bytes.insert(m_bytes.end(), std::begin(ReplayFormat::MAGIC), std::end(ReplayFormat::MAGIC));
+		m_bytes.push_back(ReplayFormat::VERSION);
+
+		Varint::appendFixed64(m_bytes, seed);
+		Varint::append(m_bytes, width);
+		Varint::append(m_bytes, height);
+		Varint::append(m_bytes, checksumInterval);
+	}
+
+	void ReplayWriter::record(uint64_t tick, uint8_t tag)
+	{
+		Varint::append(m_bytes, ((tick - m_lastTick) << ReplayFormat::TAG_BITS) | tag);
+		m_lastTick = tick;
+	}
+
+	void ReplayWriter::input(uint64_t tick, Snake::Direction direction)
+	{
+		record(tick, static_cast<uint8_t>(direction));
+	}
+
+	void ReplayWriter::checksum(uint64_t tick, uint32_t checksum)
+	{
+		if (m_checksumInterval == 0 || (tick + 1) % m_checksumInterval != 0)
+		{
+			return;
+		}
+
+		record(tick, ReplayFormat::TAG_CHECKSUM);
+		Varint::append(m_bytes, checksum);
+	}
+
+	unsigned int ReplayWriter::checksumInterval() const noexcept
+	{
+		return m_checksumInterval;
+	}
+
+	void ReplayWriter::finish(uint64_t ticks, bool gameOver)
+	{
+		record(ticks, gameOver ? ReplayFormat::TAG_END : ReplayFormat::TAG_STOPPED);
+
+		std::ofstream out(m_path, std::ios::binary | std::ios::trunc);
+
+		if (!out.write(reinterpret_cast<const char*>(m_bytes.data()), static_cast<std::streamsize>(m_bytes.size())))
+			throw std::runtime_error("Failed to write replay " + m_path.string());
+	}
+
+	ReplayReader::ReplayReader(std::filesystem::path const& path)
+		: m_file(path)
+	{
+		constexpr size_t fixedHeader = sizeof(ReplayFormat::MAGIC) + 1 + 8;
+		const uint8_t* data = m_file.data();
+
+		if (m_file.size() < fixedHeader ||
+			std::memcmp(data, ReplayFormat::MAGIC, sizeof(ReplayFormat::MAGIC)) != 0 ||
+			data[sizeof(ReplayFormat::MAGIC)] != ReplayFormat::VERSION)
+		{
+			throw std::runtime_error("Not a replay file: " + path.string());
+		}
+
+		m_seed = Varint::readFixed64(data + sizeof(ReplayFormat::MAGIC) + 1);
+
+		// Walk the records once, so playback never meets a corrupt one in the middle of a game
+		try
+		{
+			size_t offset = fixedHeader;
+			m_width = static_cast<unsigned int>(varint(offset));
+			m_height = static_cast<unsigned int>(varint(offset));
+			m_checksumInterval = static_cast<unsigned int>(varint(offset));
+			m_offset = offset;
+
+			uint64_t tick = 0;
+
+			while (true)
+			{
+				if (offset >= m_file.size())
+					throw std::runtime_error("no END or STOPPED record");
+
+				const Record record = decode(offset, tick);
+				tick = record.tick;
+
+				if (record.tag == ReplayFormat::TAG_END || record.tag == ReplayFormat::TAG_STOPPED)
+				{
+					m_endsInGameOver = record.tag == ReplayFormat::TAG_END;
+					break;
+				}
+
+				if (record.tag > ReplayFormat::TAG_STOPPED)
+					throw std::runtime_error("unknown record tag " + std::to_string(record.tag));
+			}
+
+			if (offset != m_file.size())
+				throw std::runtime_error("data after the end record");
+		}
+		catch (const std::runtime_error& e)
+		{
+			throw std::runtime_error("Corrupt replay " + path.string() + ": " + e.what());
+		}
+	}
+
+	uint64_t ReplayReader::seed() const noexcept
+	{
+		return m_seed;
+	}
+
+	unsigned int ReplayReader::width() const noexcept
+	{
+		return m_width;
+	}
+
+	unsigned int ReplayReader::height() const noexcept
+	{
+		return m_height;
+	}
+
+	unsigned int ReplayReader::checksumInterval() const noexcept
+	{
+		return m_checksumInterval;
+	}
+
+	bool ReplayReader::endsInGameOver() const noexcept
+	{
+		return m_endsInGameOver;
+	}
+
+	uint64_t ReplayReader::varint(size_t& offset) const
+	{
+		return Varint::read(m_file.data(), m_file.size(), offset);
+	}
+
+	ReplayReader::Record ReplayReader::decode(size_t& offset, uint64_t tick) const
+	{
+		uint64_t header = varint(offset);
+		Record record{ tick + (header >> ReplayFormat::TAG_BITS), static_cast<uint8_t>(header & ((1u << ReplayFormat::TAG_BITS) - 1)), 0 };
+
+		if (record.tag == ReplayFormat::TAG_CHECKSUM)
+		{
+			record.checksum = static_cast<uint32_t>(varint(offset));
+		}
+
+		return record;
+	}
+
+	std::optional<ReplayReader::Record> ReplayReader::peek() const
+	{
+		if (m_offset >= m_file.size())
+		{
+			return std::nullopt;
+		}
+
+		size_t offset = m_offset;
+		Record record = decode(offset, m_tick); // cannot throw: the constructor decoded every record
+
+		m_nextOffset = offset;
+
+		return record;
+	}
+
+	void ReplayReader::advance()
+	{
+		std::optional<Record> record = peek();
+
+		if (record)
+		{
+			m_tick = record->tick;
+			m_offset = m_nextOffset;
+		}
+	}
+
+	ReplayController::ReplayController(ReplayReader& reader)
+		: m_reader(reader)
+	{}
+
+	Input::KeyKind ReplayController::nextKey(Game const& game)
+	{
+		static constexpr Input::KeyKind keys[] = {
+			Input::KeyKind::ArrowUp, Input::KeyKind::ArrowDown,
+			Input::KeyKind::ArrowLeft, Input::KeyKind::ArrowRight
+		};
+
+		Input::KeyKind key = Input::KeyKind::None;
+
+		for (auto record = m_reader.peek(); record && record->tick == game.ticksElapsed() && record->tag < 4; record = m_reader.peek())
+		{
+			key = keys[record->tag];
+			m_reader.advance();
+		}
+
+		return key;
+	}
+
+	bool ReplayController::verify(uint64_t tick, uint32_t checksum)
+	{
+		auto record = m_reader.peek();
+
+		if (!record || record->tag != ReplayFormat::TAG_CHECKSUM || record->tick != tick)
+		{
+			return true;
+		}
+
+		m_reader.advance();
+		m_expected = record->checksum;
+
+		return record->checksum == checksum;
+	}
+
+	bool ReplayController::finished(uint64_t ticks) const
+	{
+		auto record = m_reader.peek();
+
+		return !record || ((record->tag == ReplayFormat::TAG_END || record->tag == ReplayFormat::TAG_STOPPED) && record->tick <= ticks);
+	}
+
+	uint32_t ReplayController::expectedChecksum() const noexcept
+	{
+		return m_expected;
+	}
+};
@@ -1,6 +1,7 @@
 #include <functional>
 
-#include <boost/log/trivial.hpp>
+#include "include/board.h"
+#include "include/log.h"
 
 #include "include/screen.h"
 #include "include/objects.h"
@@ -33,11 +34,7 @@ namespace Snake
 
 	void ScreenBuffer::clear()
 	{
-		m_buffer.clear();
-
-		for (int i = 0 ; i < m_width * m_height; ++i) {
-			m_buffer.push_back(m_emptyCell);
-		}
+		m_buffer.assign(static_cast<size_t>(m_width) * m_height, m_emptyCell);
 	}
 
 	inline int ScreenBuffer::index(int x, int y) const noexcept
@@ -61,8 +58,20 @@ namespace Snake
 		return m_objects;
 	}
 
+	uint64_t ScreenBuffer::getObjectsVersion() const noexcept
+	{
+		return m_objectsVersion;
+	}
+
+	void ScreenBuffer::setCollisionFilter(BaseObject* obj, uint16_t layer, uint16_t mask)
+	{
+		obj->setCollisionFilter(layer, mask);
+		++m_objectsVersion;
+	}
+
 	void ScreenBuffer::addObject(BaseObject* obj) {
 		m_objects.push_back(obj);
+		++m_objectsVersion;
 
 	    for (const PCellPtr& cwp : obj->cells()) {
 	        set(cwp->x, cwp->y, cwp->cell);
@@ -74,6 +83,7 @@ namespace Snake
 
 		if (it != m_objects.end()) {
 			m_objects.erase(it);
+			++m_objectsVersion;
 		}
 
 		// add empty cells where the object was
@@ -133,17 +143,51 @@ namespace Snake
 		return toClear;
 	}
 
-	void ScreenBuffer::clearPositions(const PosVector& positions)
+	void ScreenBuffer::accountMemory(MemoryReport& report) const
+	{
+		report.addVector(MemorySubsystem::ScreenBuffer, m_buffer);
+		report.addVector(MemorySubsystem::ScreenBuffer, m_objects);
+
+		// Allocated with new rather than make_shared: cell and control block are separate blocks
+		report.add(MemorySubsystem::ScreenBuffer, sizeof(Cell) + MemoryReport::s_SharedControlBytes, 2);
+	}
+
+	std::vector<CellPtr> const& ScreenBuffer::cells() const noexcept
+	{
+		return m_buffer;
+	}
+
+	void ScreenBuffer::snapshot(std::vector<PackedCell>& out) const
 	{
-		for (const auto& [x, y] : positions)
+		withBoard(m_width, m_height, [&](auto board)
 		{
-			if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+			out.resize(board.cells());
+
+			const CellPtr* cells = m_buffer.data();
+			const Cell* empty = m_emptyCell.get();
+
+			for (size_t i = 0; i < board.cells(); ++i)
 			{
-				continue; // Skip out-of-bounds
+				// Shared empty cell: skip the dereference for the common case
+				out[i] = cells[i].get() == empty ? PackedCell{} : PackedCell::s_Pack(*cells[i]);
 			}
+		});
+	}
 
-			set(x, y, m_emptyCell);
-		}
+	void ScreenBuffer::clearPositions(const PosVector& positions)
+	{
+		withBoard(m_width, m_height, [&](auto board)
+		{
+			for (const auto& [x, y] : positions)
+			{
+				if (!board.contains(x, y))
+				{
+					continue; // Skip out-of-bounds
+				}
+
+				m_buffer[board.index(x, y)] = m_emptyCell;
+			}
+		});
 	}
 
 	std::string ScreenBuffer::s_ToUnicode(uint32_t codepoint) noexcept
@@ -178,14 +222,15 @@ namespace Snake
 
 	void ScreenBuffer::dumpBuffer() const
 	{
-		std::string dump;
+		// One record per row: a log record holds at most Log::MESSAGE_CAPACITY bytes
+		std::string row;
 		for (int y = 0; y < m_height; ++y) {
+			row.clear();
 			for (int x = 0; x < m_width; ++x) {
-				dump += s_ToUnicode(get(x, y)->codepoint);
+				row += s_ToUnicode(get(x, y)->codepoint);
 			}
-			dump += '\n';
-		}
 
-		BOOST_LOG_TRIVIAL(info) << dump;
+			SNAKE_LOG(info) << row;
+		}
 	}
 }
@@ -0,0 +1,355 @@
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "include/log.h"
+#include "include/objects.h"
+#include "include/sharedframe.h"
+
+namespace Snake
+{
+	using namespace SharedFrameFormat;
+
+#if defined(_WIN32)
+	SharedFrameWriter::SharedFrameWriter(std::string const&, unsigned int width, unsigned int height, unsigned int slots)
+		: m_width(width), m_height(height), m_slots(slots)
+	{
+		throw std::runtime_error("Shared memory frames are not supported on Windows");
+	}
+
+	SharedFrameWriter::~SharedFrameWriter() = default;
+
+	void SharedFrameWriter::frame(ScreenBuffer const&, PosVector const&, Metadata const&)
+	{}
+
+	SharedFrameReader::SharedFrameReader(std::string const&)
+	{
+		throw std::runtime_error("Shared memory frames are not supported on Windows");
+	}
+
+	SharedFrameReader::~SharedFrameReader() = default;
+
+	bool SharedFrameReader::read(std::vector<PackedCell>&, Metadata&, uint64_t&) const
+	{
+		return false;
+	}
+#else
+	namespace
+	{
+		/**
+		 * @brief Whether `name` is a frame segment whose writer is no longer running, e.g. after a crash
+		 *
+		 * Anything else, a live game's segment or one that is not a frame segment, is left alone.
+		 */
+		bool s_IsStale(std::string const& name)
+		{
+			int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+
+			if (fd < 0)
+			{
+				return false;
+			}
+
+			struct stat st;
+			bool stale = false;
+
+			if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= HEADER_BYTES)
+			{
+				void* data = ::mmap(nullptr, HEADER_BYTES, PROT_READ, MAP_SHARED, fd, 0);
+
+				if (data != MAP_FAILED)
+				{
+					const Header& h = *std::launder(reinterpret_cast<const Header*>(data));
+
+					// A reused pid keeps the segment; refusing to start is the safe side of that mistake
+					stale = std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0 && h.writerPid != 0
+						&& ::kill(static_cast<pid_t>(h.writerPid), 0) != 0 && errno == ESRCH;
+
+					::munmap(data, HEADER_BYTES);
+				}
+			}
+
+			::close(fd);
+
+			return stale;
+		}
+
+		/** @brief Packs one buffer cell; the shared empty cell is not dereferenced */
+		PackedCell s_Pack(CellPtr const& cell, Cell const* empty) noexcept
+		{
+			return cell.get() == empty ? PackedCell{} : PackedCell::s_Pack(*cell);
+		}
+	}
+
+	SharedFrameWriter::SharedFrameWriter(std::string const& name, unsigned int width, unsigned int height, unsigned int slots)
+		: m_name(name), m_width(width), m_height(height), m_slots(slots),
+		  m_changed(slots), m_changedAll(slots, 0)
+	{
+		if (slots == 0)
+			throw std::invalid_argument("SharedFrameWriter needs at least one slot");
+
+		const size_t slotBytes = s_SlotBytes(width, height);
+
+		if (slotBytes > UINT32_MAX)
+			throw std::runtime_error("Board too large for shared memory frames");
+
+		m_size = HEADER_BYTES + slotBytes * slots;
+
+		int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+		int error = errno;
+
+		if (fd < 0 && error == EEXIST && s_IsStale(name))
+		{
+			SNAKE_LOG(info) << "Replacing shared memory " << name << " left by a game that is no longer running";
+
+			::shm_unlink(name.c_str()); // readers of the old segment keep their mapping
+			fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+			error = errno;
+		}
+
+		if (fd < 0 && error == EEXIST)
+			throw std::runtime_error("Shared memory " + name + " is in use by a running game or is not a frame segment; remove it if nothing uses it");
+
+		if (fd < 0)
+			throw std::runtime_error("Failed to create shared memory " + name + ": " + std::strerror(error));
+
+		if (::ftruncate(fd, static_cast<off_t>(m_size)) != 0)
+		{
+			::close(fd);
+			::shm_unlink(name.c_str());
+
+			throw std::runtime_error("Failed to size shared memory " + name + ": " + std::strerror(errno));
+		}
+
+		void* data = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		::close(fd);
+
+		if (data == MAP_FAILED)
+		{
+			::shm_unlink(name.c_str());
+
+			throw std::runtime_error("Failed to map shared memory " + name + ": " + std::strerror(errno));
+		}
+
+		m_base = static_cast<uint8_t*>(data);
+
+		for (unsigned int i = 0; i < slots; ++i)
+		{
+			new (m_base + HEADER_BYTES + slotBytes * i) Slot{};
+		}
+
+		Header* h = new (m_base) Header{};
+		h->version = VERSION;
+		h->width = width;
+		h->height = height;
+		h->slots = slots;
+		h->slotBytes = static_cast<uint32_t>(slotBytes);
+		h->cellBytes = sizeof(PackedCell);
+		h->writerPid = static_cast<uint32_t>(::getpid());
+		std::memcpy(h->magic, MAGIC, sizeof(MAGIC));
+	}
+
+	SharedFrameWriter::~SharedFrameWriter()
+	{
+		if (m_base)
+		{
+			::munmap(m_base, m_size);
+			::shm_unlink(m_name.c_str());
+		}
+	}
+
+	Header& SharedFrameWriter::header() const noexcept
+	{
+		return *std::launder(reinterpret_cast<Header*>(m_base));
+	}
+
+	Slot& SharedFrameWriter::slot(unsigned int index) const noexcept
+	{
+		return *std::launder(reinterpret_cast<Slot*>(m_base + HEADER_BYTES + s_SlotBytes(m_width, m_height) * index));
+	}
+
+	void SharedFrameWriter::frame(ScreenBuffer const& buffer, PosVector const& vacated, Metadata const& metadata)
+	{
+		const uint64_t n = m_frames;
+		const unsigned int index = static_cast<unsigned int>(n % m_slots);
+		const uint64_t objectsVersion = buffer.getObjectsVersion();
+
+		// What this frame can have changed: vacated cells, and the cells of objects that move or animate in place
+		PosVector& changed = m_changed[index];
+		changed.assign(vacated.begin(), vacated.end());
+
+		for (const BaseObject* obj : buffer.getObjects())
+		{
+			if (obj->isMovable() || obj->isAnimated())
+			{
+				for (const PCellPtr& pCell : obj->cells())
+				{
+					changed.emplace_back(pCell->x, pCell->y);
+				}
+			}
+		}
+
+		m_changedAll[index] = n == 0 || objectsVersion != m_objectsVersion;
+		m_objectsVersion = objectsVersion;
+
+		// The slot still holds frame `n - m_slots`: it misses what the last `m_slots` frames changed, this one included
+		bool all = n < m_slots;
+
+		for (unsigned int i = 0; i < m_slots && !all; ++i)
+		{
+			all = m_changedAll[i] != 0;
+		}
+
+		Slot& target = slot(index);
+		PackedCell* cells = reinterpret_cast<PackedCell*>(reinterpret_cast<uint8_t*>(&target) + SLOT_HEADER_BYTES);
+		const std::vector<CellPtr>& source = buffer.cells();
+		const Cell* empty = buffer.getEmptyCellPtr().get();
+
+		// Odd while writing; readers that saw the old even value notice the change and retry
+		target.sequence.store(2 * n + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		target.metadata = metadata;
+
+		if (all)
+		{
+			for (size_t i = 0; i < source.size(); ++i)
+			{
+				cells[i] = s_Pack(source[i], empty);
+			}
+		}
+		else
+		{
+			for (const PosVector& frameChanged : m_changed)
+			{
+				for (const auto& [x, y] : frameChanged)
+				{
+					if (x < m_width && y < m_height)
+					{
+						const size_t i = size_t(y) * m_width + x;
+						cells[i] = s_Pack(source[i], empty);
+					}
+				}
+			}
+		}
+
+		target.sequence.store(2 * n + 2, std::memory_order_release);
+		header().latest.store(n + 1, std::memory_order_release);
+
+		++m_frames;
+	}
+
+	SharedFrameReader::SharedFrameReader(std::string const& name)
+	{
+		int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+
+		if (fd < 0)
+			throw std::runtime_error("Failed to open shared memory " + name + ": " + std::strerror(errno));
+
+		struct stat st;
+
+		if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < HEADER_BYTES)
+		{
+			::close(fd);
+
+			throw std::runtime_error("Not a frame segment: " + name);
+		}
+
+		m_size = static_cast<size_t>(st.st_size);
+
+		void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+
+		if (data == MAP_FAILED)
+			throw std::runtime_error("Failed to map shared memory " + name + ": " + std::strerror(errno));
+
+		m_base = static_cast<const uint8_t*>(data);
+
+		const Header& h = *std::launder(reinterpret_cast<const Header*>(m_base));
+
+		if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.version != VERSION || h.cellBytes != sizeof(PackedCell)
+			|| h.slots == 0 || h.slotBytes != s_SlotBytes(h.width, h.height) || m_size < HEADER_BYTES + size_t(h.slotBytes) * h.slots)
+		{
+			::munmap(const_cast<uint8_t*>(m_base), m_size);
+
+			throw std::runtime_error("Not a frame segment or unsupported version: " + name);
+		}
+
+		m_width = h.width;
+		m_height = h.height;
+		m_slots = h.slots;
+		m_slotBytes = h.slotBytes;
+	}
+
+	SharedFrameReader::~SharedFrameReader()
+	{
+		if (m_base)
+		{
+			::munmap(const_cast<uint8_t*>(m_base), m_size);
+		}
+	}
+
+	bool SharedFrameReader::read(std::vector<PackedCell>& cells, Metadata& metadata, uint64_t& frame) const
+	{
+		const Header& h = *std::launder(reinterpret_cast<const Header*>(m_base));
+
+		cells.resize(size_t(m_width) * m_height);
+
+		for (;;)
+		{
+			const uint64_t latest = h.latest.load(std::memory_order_acquire);
+
+			if (latest == 0)
+			{
+				return false;
+			}
+
+			const uint64_t n = latest - 1;
+			const uint8_t* base = m_base + HEADER_BYTES + m_slotBytes * (n % m_slots);
+			const Slot& source = *std::launder(reinterpret_cast<const Slot*>(base));
+
+			// Already being overwritten with a newer frame, or not finished yet: start over from `latest`
+			if (source.sequence.load(std::memory_order_acquire) != 2 * n + 2)
+			{
+				continue;
+			}
+
+			metadata = source.metadata;
+			std::memcpy(cells.data(), base + SLOT_HEADER_BYTES, cells.size() * sizeof(PackedCell));
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if (source.sequence.load(std::memory_order_relaxed) == 2 * n + 2)
+			{
+				frame = n;
+
+				return true;
+			}
+		}
+	}
+#endif
+
+	uint64_t SharedFrameWriter::frames() const noexcept
+	{
+		return m_frames;
+	}
+
+	unsigned int SharedFrameReader::width() const noexcept
+	{
+		return m_width;
+	}
+
+	unsigned int SharedFrameReader::height() const noexcept
+	{
+		return m_height;
+	}
+};
@@ -0,0 +1,247 @@
+#include <algorithm>
+
+#include "include/snapshot.h"
+
+namespace Snake
+{
+	RewindBuffer::RewindBuffer(size_t capacity, size_t keyframeInterval)
+		: m_capacity(capacity),
+		  m_keyframeInterval(std::max<size_t>(1, keyframeInterval))
+	{}
+
+	size_t RewindBuffer::size() const noexcept
+	{
+		return m_size;
+	}
+
+	size_t RewindBuffer::bytes() const noexcept
+	{
+		size_t total = 0;
+
+		for (const Group& group : m_groups)
+		{
+			total += group.data.size() * sizeof(uint32_t);
+		}
+
+		return total;
+	}
+
+	void RewindBuffer::accountMemory(MemoryReport& report) const
+	{
+		for (const Group& group : m_groups)
+		{
+			report.addVector(MemorySubsystem::History, group.data);
+			report.addVector(MemorySubsystem::History, group.offsets);
+		}
+
+		for (const Group& group : m_free)
+		{
+			report.addVector(MemorySubsystem::History, group.data);
+			report.addVector(MemorySubsystem::History, group.offsets);
+		}
+
+		report.addVector(MemorySubsystem::History, m_free);
+		report.addVector(MemorySubsystem::History, m_last.words);
+	}
+
+	void RewindBuffer::clear() noexcept
+	{
+		while (!m_groups.empty())
+		{
+			m_groups.back().data.clear();
+			m_groups.back().offsets.clear();
+			m_free.push_back(std::move(m_groups.back()));
+			m_groups.pop_back();
+		}
+
+		m_size = 0;
+	}
+
+	void RewindBuffer::push(GameSnapshot const& snapshot)
+	{
+		if (m_groups.empty() || m_groups.back().offsets.size() == m_keyframeInterval)
+		{
+			if (!m_free.empty())
+			{
+				m_groups.push_back(std::move(m_free.back()));
+				m_free.pop_back();
+			}
+			else
+			{
+				m_groups.emplace_back();
+			}
+
+			// Keyframe: word count, then the snapshot as is
+			Group& group = m_groups.back();
+			group.offsets.push_back(0);
+			group.data.push_back(static_cast<uint32_t>(snapshot.words.size()));
+			group.data.insert(group.data.end(), snapshot.words.begin(), snapshot.words.end());
+		}
+		else
+		{
+			encodeDelta(m_groups.back(), snapshot);
+		}
+
+		m_last.words.assign(snapshot.words.begin(), snapshot.words.end());
+		++m_size;
+
+		// Evict whole groups while the rest still covers the capacity
+		while (m_groups.size() > 1 && m_size - m_groups.front().offsets.size() >= m_capacity)
+		{
+			m_size -= m_groups.front().offsets.size();
+
+			m_groups.front().data.clear();
+			m_groups.front().offsets.clear();
+			m_free.push_back(std::move(m_groups.front()));
+			m_groups.pop_front();
+		}
+	}
+
+	void RewindBuffer::encodeDelta(Group& group, GameSnapshot const& snapshot) const
+	{
+		const std::vector<uint32_t>& prev = m_last.words;
+		const std::vector<uint32_t>& cur = snapshot.words;
+		std::vector<uint32_t>& data = group.data;
+
+		group.offsets.push_back(static_cast<uint32_t>(data.size()));
+
+		const size_t maskAt = data.size();
+		uint32_t mask = 0;
+		data.push_back(0);
+
+		for (size_t i = 0; i < GameSnapshot::HEADER_WORDS; ++i)
+		{
+			if (cur[i] != prev[i])
+			{
+				mask |= 1u << i;
+				data.push_back(cur[i]);
+			}
+		}
+
+		data[maskAt] = mask;
+
+		// A move adds one head cell and drops the tail, growing adds the head and keeps everything
+		const size_t curLength = snapshot.length();
+		const size_t prevLength = m_last.length();
+		size_t k = curLength;
+
+		for (size_t added = 0; added <= std::min<size_t>(2, curLength); ++added)
+		{
+			const size_t kept = curLength - added;
+
+			if (kept <= prevLength && std::equal(cur.begin() + GameSnapshot::HEADER_WORDS + added, cur.end(), prev.begin() + GameSnapshot::HEADER_WORDS))
+			{
+				k = added;
+				break;
+			}
+		}
+
+		data.push_back(static_cast<uint32_t>(k));
+		data.push_back(static_cast<uint32_t>(curLength - k));
+		data.insert(data.end(), cur.begin() + GameSnapshot::HEADER_WORDS, cur.begin() + GameSnapshot::HEADER_WORDS + k);
+	}
+
+	void RewindBuffer::s_ApplyDelta(const uint32_t* delta, GameSnapshot& out)
+	{
+		const uint32_t mask = *delta++;
+
+		for (size_t i = 0; i < GameSnapshot::HEADER_WORDS; ++i)
+		{
+			if (mask & (1u << i))
+			{
+				out.words[i] = *delta++;
+			}
+		}
+
+		const size_t k = *delta++;
+		const size_t m = *delta++;
+		auto cells = out.words.begin() + GameSnapshot::HEADER_WORDS;
+
+		if (k + m > out.length())
+		{
+			out.words.resize(GameSnapshot::HEADER_WORDS + k + m);
+			cells = out.words.begin() + GameSnapshot::HEADER_WORDS;
+		}
+
+		// The kept cells slide back by k to make room for the new head cells
+		std::copy_backward(cells, cells + m, cells + k + m);
+		std::copy(delta, delta + k, cells);
+
+		out.words.resize(GameSnapshot::HEADER_WORDS + k + m);
+	}
+
+	void RewindBuffer::decode(size_t groupIndex, size_t entry, GameSnapshot& out) const
+	{
+		const Group& group = m_groups[groupIndex];
+		const uint32_t* keyframe = group.data.data();
+
+		out.words.assign(keyframe + 1, keyframe + 1 + keyframe[0]);
+
+		for (size_t i = 1; i <= entry; ++i)
+		{
+			s_ApplyDelta(group.data.data() + group.offsets[i], out);
+		}
+	}
+
+	bool RewindBuffer::get(size_t back, GameSnapshot& out) const
+	{
+		if (back >= m_size)
+		{
+			return false;
+		}
+
+		// Walk from the newest group; groups are at most `m_keyframeInterval` entries
+		for (size_t g = m_groups.size(); g-- > 0;)
+		{
+			const size_t count = m_groups[g].offsets.size();
+
+			if (back < count)
+			{
+				decode(g, count - 1 - back, out);
+
+				return true;
+			}
+
+			back -= count;
+		}
+
+		return false;
+	}
+
+	bool RewindBuffer::rewind(size_t back, GameSnapshot& out)
+	{
+		if (!get(back, out))
+		{
+			return false;
+		}
+
+		m_size -= back;
+
+		while (back > 0)
+		{
+			Group& group = m_groups.back();
+			const size_t count = group.offsets.size();
+
+			if (back >= count)
+			{
+				group.data.clear();
+				group.offsets.clear();
+				m_free.push_back(std::move(group));
+				m_groups.pop_back();
+
+				back -= count;
+			}
+			else
+			{
+				group.data.resize(group.offsets[count - back]);
+				group.offsets.resize(count - back);
+
+				back = 0;
+			}
+		}
+
+		m_last.words.assign(out.words.begin(), out.words.end());
+
+		return true;
+	}
+};
@@ -0,0 +1,476 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "include/input.h"
+#include "include/log.h"
+#include "include/spectator.h"
+#include "include/terminal.h"
+#include "include/varint.h"
+
+namespace Snake
+{
+	struct SpectatorServer::Client
+	{
+		int fd;
+		std::deque<Message> queue;
+
+		/** @brief Bytes of `queue.front()` already sent */
+		size_t sent = 0;
+
+		std::chrono::steady_clock::time_point lastProgress;
+	};
+
+#if defined(_WIN32)
+	SpectatorServer::SpectatorServer(std::filesystem::path const&, unsigned int width, unsigned int height, unsigned int)
+		: m_encoder(width, height)
+	{
+		throw std::runtime_error("Spectator sockets are not supported on Windows");
+	}
+
+	SpectatorServer::~SpectatorServer() = default;
+
+	void SpectatorServer::frame(ScreenBuffer const&)
+	{}
+
+	void SpectatorServer::serve()
+	{}
+
+	int runSpectator(Options const&)
+	{
+		std::cerr << "Spectator sockets are not supported on Windows" << std::endl;
+
+		return 1;
+	}
+#else
+	namespace
+	{
+		sockaddr_un socketAddress(std::filesystem::path const& path)
+		{
+			sockaddr_un address{};
+			address.sun_family = AF_UNIX;
+
+			const std::string native = path.string();
+
+			if (native.size() >= sizeof(address.sun_path))
+				throw std::runtime_error("Socket path too long: " + native);
+
+			std::memcpy(address.sun_path, native.c_str(), native.size() + 1);
+
+			return address;
+		}
+
+		void setNonBlocking(int fd)
+		{
+			::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+			::fcntl(fd, F_SETFD, FD_CLOEXEC);
+		}
+	}
+
+	SpectatorServer::SpectatorServer(std::filesystem::path const& path, unsigned int width, unsigned int height, unsigned int frameMs)
+		: m_path(path),
+		  m_encoder(width, height)
+	{
+		const sockaddr_un address = socketAddress(path);
+
+		// A socket file left behind by a crashed run would make bind fail
+		std::error_code ignored;
+
+		if (std::filesystem::is_socket(path, ignored))
+		{
+			std::filesystem::remove(path, ignored);
+		}
+
+		m_listen = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+		if (m_listen < 0)
+			throw std::runtime_error(std::string("Failed to create spectator socket: ") + std::strerror(errno));
+
+		if (::bind(m_listen, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(m_listen, 16) != 0 || ::pipe(m_wake) != 0)
+		{
+			const std::string error = std::strerror(errno);
+
+			::close(m_listen);
+			throw std::runtime_error("Failed to listen on " + path.string() + ": " + error);
+		}
+
+		setNonBlocking(m_listen);
+		setNonBlocking(m_wake[0]);
+		setNonBlocking(m_wake[1]);
+
+		auto hello = std::make_shared<std::vector<uint8_t>>(std::begin(SpectatorFormat::MAGIC), std::end(SpectatorFormat::MAGIC));
+		hello->push_back(SpectatorFormat::VERSION);
+		Varint::append(*hello, width);
+		Varint::append(*hello, height);
+		Varint::append(*hello, frameMs);
+		m_hello = std::move(hello);
+
+		m_thread = std::thread(&SpectatorServer::serve, this);
+
+		SNAKE_LOG(info) << "Broadcasting to spectators on " << path.string();
+	}
+
+	SpectatorServer::~SpectatorServer()
+	{
+		m_stop.store(true, std::memory_order_release);
+
+		const char wake = 0;
+		[[maybe_unused]] ssize_t written = ::write(m_wake[1], &wake, 1);
+
+		if (m_thread.joinable())
+		{
+			m_thread.join();
+		}
+
+		::close(m_listen);
+		::close(m_wake[0]);
+		::close(m_wake[1]);
+
+		std::error_code ignored;
+		std::filesystem::remove(m_path, ignored);
+	}
+
+	size_t SpectatorServer::clients() const noexcept
+	{
+		return m_clients.load(std::memory_order_relaxed);
+	}
+
+	void SpectatorServer::frame(ScreenBuffer const& buffer)
+	{
+		const bool keyframe = m_frames++ % s_KeyframeInterval == 0;
+
+		// Length prefix first: reserve the widest varint, then move the frame up against the real one
+		auto message = std::make_shared<std::vector<uint8_t>>(10);
+		m_encoder.encode(buffer, keyframe, *message);
+
+		std::vector<uint8_t> prefix;
+		Varint::append(prefix, message->size() - 10);
+		message->erase(message->begin() + static_cast<std::ptrdiff_t>(prefix.size()), message->begin() + 10);
+		std::copy(prefix.begin(), prefix.end(), message->begin());
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (keyframe)
+			{
+				m_latest.clear();
+			}
+
+			m_latest.push_back(message);
+			m_pending.push_back(std::move(message));
+		}
+
+		// A full pipe already means the thread has a wakeup pending
+		const char wake = 0;
+		[[maybe_unused]] ssize_t written = ::write(m_wake[1], &wake, 1);
+	}
+
+	void SpectatorServer::serve()
+	{
+		std::vector<Client> clients;
+		std::vector<Message> pending;
+		std::vector<Message> latest;
+		std::vector<pollfd> fds;
+		std::vector<iovec> iov;
+
+		while (!m_stop.load(std::memory_order_acquire))
+		{
+			fds.clear();
+			fds.push_back({ m_wake[0], POLLIN, 0 });
+			fds.push_back({ m_listen, POLLIN, 0 });
+
+			for (const Client& client : clients)
+			{
+				fds.push_back({ client.fd, static_cast<short>(POLLIN | (client.queue.empty() ? 0 : POLLOUT)), 0 });
+			}
+
+			if (::poll(fds.data(), fds.size(), 1000) < 0 && errno != EINTR)
+			{
+				SNAKE_LOG(error) << "Spectator poll failed: " << std::strerror(errno);
+				return;
+			}
+
+			char drain[64];
+			while (::read(m_wake[0], drain, sizeof(drain)) > 0)
+			{}
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				pending.swap(m_pending);
+				latest.assign(m_latest.begin(), m_latest.end());
+			}
+
+			const auto now = std::chrono::steady_clock::now();
+
+			for (size_t i = 0; i < clients.size(); ++i)
+			{
+				Client& client = clients[i];
+				const short revents = fds[i + 2].revents;
+				bool drop = (revents & (POLLERR | POLLHUP | POLLNVAL)) != 0;
+
+				// Spectators send nothing, so readable means closed
+				if (revents & POLLIN)
+				{
+					char ignored[64];
+					drop = drop || ::recv(client.fd, ignored, sizeof(ignored), MSG_DONTWAIT) == 0;
+				}
+
+				if (!drop && !pending.empty())
+				{
+					if (client.queue.size() + pending.size() > s_MaxBacklog)
+					{
+						// Keep a partly sent frame (or the unsent hello) so the stream stays whole, then resume at the latest keyframe
+						Message partial = !client.queue.empty() && (client.sent > 0 || client.queue.front() == m_hello) ? client.queue.front() : nullptr;
+
+						client.queue.clear();
+
+						if (partial)
+						{
+							client.queue.push_back(std::move(partial));
+						}
+
+						client.queue.insert(client.queue.end(), latest.begin(), latest.end());
+					}
+					else
+					{
+						client.queue.insert(client.queue.end(), pending.begin(), pending.end());
+					}
+				}
+
+				if (!drop && !client.queue.empty())
+				{
+					iov.clear();
+
+					for (size_t m = 0; m < client.queue.size() && iov.size() < IOV_MAX; ++m)
+					{
+						const std::vector<uint8_t>& bytes = *client.queue[m];
+						const size_t skip = m == 0 ? client.sent : 0;
+
+						iov.push_back({ const_cast<uint8_t*>(bytes.data()) + skip, bytes.size() - skip });
+					}
+
+					msghdr header{};
+					header.msg_iov = iov.data();
+					header.msg_iovlen = iov.size();
+
+					ssize_t written = ::sendmsg(client.fd, &header, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+					if (written > 0)
+					{
+						client.lastProgress = now;
+
+						while (written > 0)
+						{
+							const size_t left = client.queue.front()->size() - client.sent;
+
+							if (static_cast<size_t>(written) < left)
+							{
+								client.sent += static_cast<size_t>(written);
+								break;
+							}
+
+							written -= static_cast<ssize_t>(left);
+							client.sent = 0;
+							client.queue.pop_front();
+						}
+					}
+					else if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+					{
+						drop = true;
+					}
+					else if (now - client.lastProgress > s_StallTimeout)
+					{
+						SNAKE_LOG(warning) << "Disconnecting a spectator that stopped reading";
+						drop = true;
+					}
+				}
+				else if (!drop)
+				{
+					client.lastProgress = now;
+				}
+
+				if (drop)
+				{
+					::close(client.fd);
+
+					// Swap in the last client, along with its poll result
+					if (i + 1 != clients.size())
+					{
+						clients[i] = std::move(clients.back());
+						fds[i + 2] = fds[clients.size() + 1];
+					}
+
+					clients.pop_back();
+					--i;
+
+					SNAKE_LOG(info) << "Spectator left, " << clients.size() << " watching";
+				}
+			}
+
+			// Clients only ever see whole frames from a keyframe on, so new ones start at the latest
+			for (int fd = ::accept(m_listen, nullptr, nullptr); fd >= 0; fd = ::accept(m_listen, nullptr, nullptr))
+			{
+				setNonBlocking(fd);
+
+				Client client{ fd, {}, 0, now };
+				client.queue.push_back(m_hello);
+				client.queue.insert(client.queue.end(), latest.begin(), latest.end());
+				clients.push_back(std::move(client));
+
+				SNAKE_LOG(info) << "Spectator connected, " << clients.size() << " watching";
+			}
+
+			pending.clear();
+			m_clients.store(clients.size(), std::memory_order_relaxed);
+		}
+
+		for (Client& client : clients)
+		{
+			::close(client.fd);
+		}
+	}
+
+	int runSpectator(Options const& options)
+	{
+		try
+		{
+			const sockaddr_un address = socketAddress(options.spectatePath);
+			const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+			if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+				throw std::runtime_error("Failed to connect to " + options.spectatePath + ": " + std::strerror(errno));
+
+			setNonBlocking(fd);
+
+			std::vector<uint8_t> received;
+			size_t offset = 0;
+			bool helloRead = false;
+			bool closed = false;
+			unsigned int width = 0, height = 0;
+
+			FrameDecoder decoder;
+			std::vector<PackedCell> shown;
+			std::unique_ptr<Terminal> terminal;
+
+			std::signal(SIGINT, Input::signalHandler);
+
+			while (!Input::g_exitRequested && !closed)
+			{
+				pollfd readable{ fd, POLLIN, 0 };
+				::poll(&readable, 1, 20);
+
+				uint8_t chunk[65536];
+				ssize_t got;
+
+				while ((got = ::recv(fd, chunk, sizeof(chunk), 0)) > 0)
+				{
+					received.insert(received.end(), chunk, chunk + got);
+				}
+
+				closed = got == 0;
+
+				// Reads a varint at `at` if it arrived whole
+				auto next = [&](size_t& at, uint64_t& value)
+				{
+					if (!Varint::complete(received.data(), received.size(), at))
+					{
+						return false;
+					}
+
+					value = Varint::read(received.data(), received.size(), at);
+
+					return true;
+				};
+
+				if (!helloRead && received.size() >= sizeof(SpectatorFormat::MAGIC) + 1)
+				{
+					if (std::memcmp(received.data(), SpectatorFormat::MAGIC, sizeof(SpectatorFormat::MAGIC)) != 0 ||
+						received[sizeof(SpectatorFormat::MAGIC)] != SpectatorFormat::VERSION)
+					{
+						throw std::runtime_error("Not a spectator stream: " + options.spectatePath);
+					}
+
+					size_t at = sizeof(SpectatorFormat::MAGIC) + 1;
+					uint64_t w, h, frameMs;
+
+					if (next(at, w) && next(at, h) && next(at, frameMs))
+					{
+						width = static_cast<unsigned int>(w);
+						height = static_cast<unsigned int>(h);
+
+						decoder.reset(width, height);
+						terminal = std::make_unique<Terminal>();
+						offset = at;
+						helloRead = true;
+					}
+				}
+
+				// Decode every whole frame that arrived; only the last one gets drawn
+				bool decoded = false;
+				size_t at = offset;
+				uint64_t length;
+
+				while (helloRead && next(at, length) && received.size() - at >= length)
+				{
+					decoder.decode(received.data(), at + static_cast<size_t>(length), at);
+					offset = at;
+					decoded = true;
+				}
+
+				// Keep the unparsed tail only
+				if (offset > 0 && offset == received.size())
+				{
+					received.clear();
+					offset = 0;
+				}
+				else if (offset > (1u << 20))
+				{
+					received.erase(received.begin(), received.begin() + static_cast<std::ptrdiff_t>(offset));
+					offset = 0;
+				}
+
+				if (decoded)
+				{
+					terminal->renderCells(decoder.cells().data(), shown.empty() ? nullptr : shown.data(), width, height);
+					shown = decoder.cells();
+				}
+
+				if (Input::readKey().kind == Input::KeyKind::Enter)
+				{
+					Input::g_exitRequested = true;
+				}
+			}
+
+			::close(fd);
+			terminal.reset();
+
+			if (closed)
+			{
+				std::cout << "The game ended" << std::endl;
+			}
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+
+			return 1;
+		}
+
+		return 0;
+	}
+#endif
+};
@@ -1,8 +1,7 @@
-#include <iostream>
+#include <algorithm>
 #include <string>
-#include <thread>
 #include <format> // requires gcc 13 or newer
-#include <boost/log/trivial.hpp>
+#include "include/log.h"
 
 #if defined(_WIN32)
 #include <windows.h>
@@ -11,9 +10,11 @@
 #include <unistd.h>
 #endif
 
+#include "include/board.h"
 #include "include/terminal.h"
 #include "include/screen.h"
 #include "include/input.h"
+#include "include/trace.h"
 
 namespace Snake
 {
@@ -55,36 +56,39 @@ namespace Snake
 #endif
 		if (!Input::initStdinRaw())
 		{
-			BOOST_LOG_TRIVIAL(error) << "Failed to initialize stdin in raw mode";
+			SNAKE_LOG(error) << "Failed to initialize stdin in raw mode";
 
 			exit(1);
 		}
 
-		std::cout << TSEQ::ALTERNATE_SCREEN;
-		std::cout.flush();
+		// Whole terminal setup goes out in a single write
+		std::string setup;
+		setup.reserve(48);
+		s_AppendSetup(setup);
 
-		std::cout << "\x1b[?7l"; // Disable line wrapping
-		std::cout.flush();
-
-		std::cout << TSEQ::CLEAR_SCREEN << TSEQ::CURSOR_HOME;
-		std::cout.flush();
-
-		std::cout << TSEQ::HIDE_CURSOR;
-		std::cout.flush();
+		m_writer.write(setup);
 	}
 
 	Terminal::~Terminal()
 	{
-		showCursor();
-		std::cout << TSEQ::RESET_ATTRS;
-		std::cout << TSEQ::EXIT_ALTERNATE_SCREEN; // Exit alternate screen buffer
+		std::string teardown;
+		teardown += TSEQ::SHOW_CURSOR;
+		teardown += TSEQ::DISABLE_FOCUS_REPORTING;
+		teardown += TSEQ::RESET_ATTRS;
+		teardown += TSEQ::EXIT_ALTERNATE_SCREEN; // Exit alternate screen buffer
+#ifndef _WIN32
+		teardown += TSEQ::CLEAR_SCREEN;
+		teardown += TSEQ::CURSOR_HOME;
+#endif
+		m_writer.write(teardown);
+
+		// The shell writes to the terminal next; don't leave our output behind it
+		m_writer.flush(TtyWriter::s_CloseTimeout);
 #ifdef _WIN32
 		SetConsoleMode(m_hStdin, m_originalInputMode);
 		SetConsoleMode(m_hStdout, m_originalOutputMode);
 #else
-		clearScreen();
 		Input::restoreTerminal();
-		std::cout.flush();
 #endif
 	}
 
@@ -100,22 +104,25 @@ namespace Snake
 
 	void Terminal::clearScreen()
 	{
-		std::cout << TSEQ::CLEAR_SCREEN << TSEQ::CURSOR_HOME;
+		m_writer.write(std::string(TSEQ::CLEAR_SCREEN) + TSEQ::CURSOR_HOME);
 	}
 
 	void Terminal::hideCursor()
 	{
-		std::cout << TSEQ::HIDE_CURSOR;
+		m_writer.write(TSEQ::HIDE_CURSOR);
 	}
 
 	void Terminal::showCursor()
 	{
-		std::cout << TSEQ::SHOW_CURSOR;
+		m_writer.write(TSEQ::SHOW_CURSOR);
 	}
 
 	void Terminal::moveCursor(unsigned int row, unsigned int col)
 	{
-		std::cout << "\033[" << (row + 1) << ";" << (col + 1) << "H";
+		std::string move;
+		s_AppendCursor(move, row, col);
+
+		m_writer.write(move);
 	}
 
 	std::string Terminal::toUnicode(uint32_t codepoint) noexcept
@@ -148,88 +155,258 @@ namespace Snake
 		return out;
 	}
 
-	void Terminal::recoverFromOutputFailure()
+	void Terminal::s_AppendSetup(std::string& out)
 	{
-		BOOST_LOG_TRIVIAL(warning) << "Attempting terminal recovery from output failure";
+		out += TSEQ::ALTERNATE_SCREEN;
+		out += TSEQ::DISABLE_LINE_WRAP;
+		out += TSEQ::CLEAR_SCREEN;
+		out += TSEQ::CURSOR_HOME;
+		out += TSEQ::HIDE_CURSOR;
+		out += TSEQ::ENABLE_FOCUS_REPORTING;
+	}
 
-		// Clear iostream error flags
-		std::cout.clear();
-		std::cerr.clear();
+	bool Terminal::beginFrame()
+	{
+		m_frame.clear();
 
-		// Reset terminal state
-		std::cout << TSEQ::TERMINAL_RESET;
-		std::cout.flush();
+		if (!m_writer.takeResync())
+		{
+			return false;
+		}
 
-		// Wait a moment for terminal to process reset
-		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		// A dropped frame's changes or a failed write left the screen unknown: set the terminal up again and draw everything.
+		// Sending the whole setup also restores modes a terminal reset after a failure would have cleared.
+		s_AppendSetup(m_frame);
 
-		// Re-enter alternate screen and set up terminal state
-		std::cout << TSEQ::ALTERNATE_SCREEN;
-		std::cout << TSEQ::HIDE_CURSOR;
-		clearScreen();
-		std::cout.flush();
+		if (!m_status.empty())
+		{
+			s_AppendCursor(m_frame, m_height, 0);
+			m_frame += m_status;
+		}
 
-		BOOST_LOG_TRIVIAL(info) << "Terminal recovery completed";
+		return true;
 	}
 
 	void Terminal::render(ScreenBuffer& buf)
 	{
-		PosVector toClear = buf.getPositionsToClear();
+		{
+			SNAKE_TRACE_SCOPE("encode");
+
+			beginFrame(); // every visible cell is drawn anyway
+
+			// A replay may bring its own, smaller board
+			s_EncodeBuffer(m_frame, buf, m_width, m_height);
+			m_frame += TSEQ::HIDE_CURSOR;
+		}
+
+		submitFrame();
+	}
 
-		// 1st phase: update terminal contents
-		for (const auto &[x, y] : toClear)
+	void Terminal::render(ScreenBuffer const& buf, PosVector const& vacated)
+	{
 		{
-			moveCursor(y, x);
-			std::cout << toUnicode(TGLYPHS::SPACE); // Clear cell by printing space
+			SNAKE_TRACE_SCOPE("encode");
+
+			beginFrame();
+
+			s_EncodeFrame(m_frame, buf, vacated, m_width, m_height, m_jobs);
+			m_frame += TSEQ::HIDE_CURSOR;
 		}
 
-		// 2nd phase: update screen buffer to reflect cleared positions
+		submitFrame();
+	}
+
+	void Terminal::submitFrame()
+	{
+		m_lastFrameBytes = m_frame.size();
+		m_writer.frame(m_frame);
+	}
+
+	std::size_t Terminal::lastFrameBytes() const noexcept
+	{
+		return m_lastFrameBytes;
+	}
+
+	void Terminal::status(std::string_view text)
+	{
+		m_status = text;
+
+		std::string line;
+		line.reserve(text.size() + 16);
+
+		// The row below the board is left free by the constructor
+		s_AppendCursor(line, m_height, 0);
+		line += TSEQ::CLEAR_LINE;
+		line += text;
+
+		m_writer.write(line);
+	}
+
+	void Terminal::s_AppendCursor(std::string& out, unsigned int row, unsigned int col)
+	{
+		out += "\033[";
+		out += std::to_string(row + 1);
+		out += ';';
+		out += std::to_string(col + 1);
+		out += 'H';
+	}
+
+	void Terminal::s_EncodeBuffer(std::string& out, ScreenBuffer& buf, unsigned int clipWidth, unsigned int clipHeight)
+	{
+		PosVector toClear = buf.getPositionsToClear();
+
+		// Update the screen buffer to reflect cleared positions, then draw them as spaces
 		buf.clearPositions(toClear);
 
-		moveCursor(0, 0);
+		s_EncodeFrame(out, buf, toClear, clipWidth, clipHeight);
+	}
+
+	void Terminal::setFrameJobs(FrameJobs* jobs) noexcept
+	{
+		m_jobs = jobs;
+	}
 
-		for (int y = 0; y < m_height; ++y)
+	void Terminal::s_EncodeFrame(std::string& out, ScreenBuffer const& buf, PosVector const& vacated, unsigned int clipWidth, unsigned int clipHeight,
+		FrameJobs* jobs)
+	{
+		// 1st phase: clear vacated cells on the terminal
+		for (const auto &[x, y] : vacated)
 		{
-			for (int x = 0; x < m_width; ++x)
-			{
-				CellPtr cellPtr = buf.get(x, y);
+			s_AppendCursor(out, y, x);
+			out += toUnicode(TGLYPHS::SPACE); // Clear cell by printing space
+		}
+
+		// 2nd phase: draw every visible cell
+		s_AppendCursor(out, 0, 0);
 
-				if (cellPtr == buf.getEmptyCellPtr())
+		const std::vector<CellPtr>& cells = buf.cells();
+		const Cell* empty = buf.getEmptyCellPtr().get();
+
+		withBoard(buf.width(), buf.height(), [&](auto board)
+		{
+			const unsigned int height = std::min(clipHeight, board.height());
+			const unsigned int width = std::min(clipWidth, board.width());
+
+			// Every cell starts with its own cursor move, so bands of rows encode independently and join into the serial output
+			auto encodeRows = [&](std::string& rows, unsigned int begin, unsigned int end)
+			{
+				for (unsigned int y = begin; y < end; ++y)
 				{
-					continue; // Skip empty cells
+					for (unsigned int x = 0; x < width; ++x)
+					{
+						const Cell* cellPtr = cells[board.index(x, y)].get();
+
+						if (cellPtr == empty)
+						{
+							continue; // Skip empty cells
+						}
+
+						const Cell &cell = *cellPtr;
+
+						if (cell.codepoint == TGLYPHS::SPACE)
+						{
+							continue; // Don't render empty/space cells
+						}
+
+						s_AppendCursor(rows, y, x);
+
+						if (cell.default_fg) {
+						    rows += TSEQ::DEFAULT_FOREGROUND; // default foreground
+						} else {
+						    rows += TSEQ::FG_COLOR_256;
+						    rows += std::to_string(cell.fg);
+						    rows += 'm';
+						}
+
+						if (cell.default_bg) {
+						    rows += TSEQ::DEFAULT_BACKGROUND; // default background
+						} else {
+						    rows += TSEQ::BG_COLOR_256;
+						    rows += std::to_string(cell.bg);
+						    rows += 'm';
+						}
+
+						rows += toUnicode(cell.codepoint);
+					}
 				}
+			};
+
+			if (jobs == nullptr || jobs->threads() == 1 || height <= s_EncodeBandRows)
+			{
+				encodeRows(out, 0, height);
+
+				return;
+			}
 
-				const Cell &cell = *cellPtr;
+			const size_t bandCount = (height + s_EncodeBandRows - 1) / s_EncodeBandRows;
+			std::vector<std::string>& bands = jobs->strings(bandCount);
 
-				if (cell.codepoint == TGLYPHS::SPACE)
+			jobs->parallelFor(FrameJobs::Phase::Encode, bandCount, 1, [&](size_t begin, size_t end)
+			{
+				for (size_t band = begin; band < end; ++band)
 				{
-					continue; // Don't render empty/space cells
+					const unsigned int first = static_cast<unsigned int>(band) * s_EncodeBandRows;
+
+					encodeRows(bands[band], first, std::min(height, first + s_EncodeBandRows));
 				}
+			});
 
-				moveCursor(y, x);
+			for (size_t band = 0; band < bandCount; ++band)
+			{
+				out += bands[band];
+			}
+		});
+	}
 
-				if (cell.default_fg) {
-				    std::cout << TSEQ::DEFAULT_FOREGROUND; // default foreground
-				} else {
-				    std::cout << TSEQ::FG_COLOR_256 << static_cast<int>(cell.fg) << "m";
-				}
+	void Terminal::s_EncodeCells(std::string& out, const PackedCell* cells, const PackedCell* previous,
+		unsigned int width, unsigned int height, unsigned int clipWidth, unsigned int clipHeight)
+	{
+		const unsigned int rows = std::min(height, clipHeight);
+		const unsigned int cols = std::min(width, clipWidth);
 
-				if (cell.default_bg) {
-				    std::cout << TSEQ::DEFAULT_BACKGROUND; // default background
-				} else {
-				    std::cout << TSEQ::BG_COLOR_256 << static_cast<int>(cell.bg) << "m";
+		for (unsigned int y = 0; y < rows; ++y)
+		{
+			for (unsigned int x = 0; x < cols; ++x)
+			{
+				const PackedCell& cell = cells[y * width + x];
+
+				// Against a blank screen only visible glyphs need drawing; against a frame only changes do
+				if (previous == nullptr ? cell == PackedCell{} : cell == previous[y * width + x])
+				{
+					continue;
 				}
 
-				std::cout << toUnicode(cell.codepoint);
+				out += "\033[" + std::to_string(y + 1) + ";" + std::to_string(x + 1) + "H";
+
+				if (cell.flags & PackedCell::DEFAULT_FG)
+					out += TSEQ::DEFAULT_FOREGROUND;
+				else
+					out += TSEQ::FG_COLOR_256 + std::to_string(cell.fg) + "m";
+
+				if (cell.flags & PackedCell::DEFAULT_BG)
+					out += TSEQ::DEFAULT_BACKGROUND;
+				else
+					out += TSEQ::BG_COLOR_256 + std::to_string(cell.bg) + "m";
+
+				out += toUnicode(cell.codepoint);
 			}
 		}
+	}
 
-		hideCursor();
-		std::cout.flush();
-
-		if (std::cout.fail())
+	void Terminal::renderCells(const PackedCell* cells, const PackedCell* previous, unsigned int width, unsigned int height)
+	{
+		if (beginFrame())
 		{
-			recoverFromOutputFailure();
+			previous = nullptr; // the screen is blank again
 		}
+		else if (previous == nullptr)
+		{
+			m_frame += TSEQ::CLEAR_SCREEN;
+		}
+
+		s_EncodeCells(m_frame, cells, previous, width, height, m_width, m_height);
+		m_frame += TSEQ::HIDE_CURSOR;
+
+		submitFrame();
 	}
 }
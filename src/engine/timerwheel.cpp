@@ -0,0 +1,161 @@
+#include <bit>
+#include <stdexcept>
+#include <string>
+
+#include "include/timerwheel.h"
+
+namespace Snake
+{
+	TimerWheel::TimerWheel()
+	{
+		m_heads.fill(s_None);
+	}
+
+	TimerWheel::TimerId TimerWheel::schedule(uint64_t delay, Callback callback)
+	{
+		if (delay == 0 || delay > s_MaxDelay)
+			throw std::invalid_argument("Timer delay must be 1 to " + std::to_string(s_MaxDelay) + " ticks, got " + std::to_string(delay));
+
+		uint32_t index = m_free;
+
+		if (index != s_None)
+		{
+			m_free = m_timers[index].next;
+		}
+		else
+		{
+			index = static_cast<uint32_t>(m_timers.size());
+			m_timers.emplace_back();
+		}
+
+		Timer& timer = m_timers[index];
+		timer.due = m_now + delay;
+		timer.callback = std::move(callback);
+
+		link(index);
+		++m_pending;
+
+		return (static_cast<uint64_t>(timer.generation) << 32) | index;
+	}
+
+	bool TimerWheel::cancel(TimerId id) noexcept
+	{
+		const uint32_t index = static_cast<uint32_t>(id);
+
+		if (index >= m_timers.size() || m_timers[index].generation != static_cast<uint32_t>(id >> 32) || m_timers[index].slot == s_None)
+		{
+			return false;
+		}
+
+		Timer& timer = m_timers[index];
+
+		unlink(index);
+		timer.callback = nullptr;
+		++timer.generation;
+		timer.next = m_free;
+		m_free = index;
+		--m_pending;
+
+		return true;
+	}
+
+	void TimerWheel::advance()
+	{
+		++m_now;
+
+		// Each time a level wraps around, the next slot of the level above is due within its span
+		for (unsigned int level = 1; level < s_Levels && (m_now & ((uint64_t(1) << (level * s_SlotBits)) - 1)) == 0; ++level)
+		{
+			cascade(level);
+		}
+
+		const uint32_t slot = static_cast<uint32_t>(m_now & (s_Slots - 1));
+
+		// One at a time: a callback may cancel timers of this slot that have not fired yet
+		while (m_heads[slot] != s_None)
+		{
+			const uint32_t index = m_heads[slot];
+			Timer& timer = m_timers[index];
+
+			unlink(index);
+			Callback callback = std::move(timer.callback);
+			timer.callback = nullptr;
+			++timer.generation;
+			timer.next = m_free;
+			m_free = index;
+			--m_pending;
+
+			callback(); // may schedule timers and grow m_timers, so `timer` is not used after it
+		}
+	}
+
+	uint64_t TimerWheel::now() const noexcept
+	{
+		return m_now;
+	}
+
+	std::size_t TimerWheel::pending() const noexcept
+	{
+		return m_pending;
+	}
+
+	void TimerWheel::link(uint32_t index) noexcept
+	{
+		Timer& timer = m_timers[index];
+		const uint64_t distance = timer.due - m_now;
+
+		// Level L holds the timers less than 64^(L + 1) ticks away, in slots of 64^L ticks
+		const unsigned int level = distance < s_Slots ? 0 : static_cast<unsigned int>((std::bit_width(distance) - 1) / s_SlotBits);
+		const uint32_t slot = level * s_Slots + static_cast<uint32_t>((timer.due >> (level * s_SlotBits)) & (s_Slots - 1));
+
+		timer.slot = slot;
+		timer.prev = s_None;
+		timer.next = m_heads[slot];
+
+		if (timer.next != s_None)
+		{
+			m_timers[timer.next].prev = index;
+		}
+
+		m_heads[slot] = index;
+	}
+
+	void TimerWheel::unlink(uint32_t index) noexcept
+	{
+		Timer& timer = m_timers[index];
+
+		if (timer.prev != s_None)
+		{
+			m_timers[timer.prev].next = timer.next;
+		}
+		else
+		{
+			m_heads[timer.slot] = timer.next;
+		}
+
+		if (timer.next != s_None)
+		{
+			m_timers[timer.next].prev = timer.prev;
+		}
+
+		timer.slot = s_None;
+		timer.prev = s_None;
+		timer.next = s_None;
+	}
+
+	void TimerWheel::cascade(unsigned int level) noexcept
+	{
+		const uint32_t slot = level * s_Slots + static_cast<uint32_t>((m_now >> (level * s_SlotBits)) & (s_Slots - 1));
+		uint32_t index = m_heads[slot];
+
+		m_heads[slot] = s_None;
+
+		while (index != s_None)
+		{
+			const uint32_t next = m_timers[index].next;
+
+			link(index); // now less than 64^level ticks away, so into a lower level
+			index = next;
+		}
+	}
+};
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "include/trace.h"
+
+namespace Snake
+{
+	namespace Trace
+	{
+		std::atomic<bool> g_enabled{ false };
+
+		namespace
+		{
+			/**
+			 * @brief One recorded event; a negative duration marks an instant
+			 */
+			struct Event
+			{
+				const char* name;
+				int64_t startNs;
+				int64_t durationNs;
+			};
+
+			/**
+			 * @brief Ring of the events of one thread, written only by that thread
+			 */
+			struct ThreadBuffer
+			{
+				explicit ThreadBuffer(uint32_t id)
+					: events(EVENTS_PER_THREAD), tid(id)
+				{}
+
+				std::vector<Event> events;
+				uint64_t written = 0;
+				uint32_t tid;
+				const char* name = nullptr;
+			};
+
+			std::chrono::steady_clock::time_point s_origin;
+
+			/** @brief Guards `s_buffers`; taken once per thread, on its first event */
+			std::mutex s_registryMutex;
+
+			/** @brief Every thread's buffer, kept after the thread ends so `Trace::write` still sees it */
+			std::vector<std::unique_ptr<ThreadBuffer>> s_buffers;
+
+			thread_local ThreadBuffer* t_buffer = nullptr;
+
+			ThreadBuffer& s_ThreadBuffer()
+			{
+				if (t_buffer == nullptr)
+				{
+					std::lock_guard<std::mutex> lock(s_registryMutex);
+
+					s_buffers.push_back(std::make_unique<ThreadBuffer>(static_cast<uint32_t>(s_buffers.size() + 1)));
+					t_buffer = s_buffers.back().get();
+				}
+
+				return *t_buffer;
+			}
+
+			int64_t s_Since(std::chrono::steady_clock::time_point time) noexcept
+			{
+				return std::chrono::duration_cast<std::chrono::nanoseconds>(time - s_origin).count();
+			}
+
+			void s_Record(const char* name, int64_t startNs, int64_t durationNs)
+			{
+				ThreadBuffer& buffer = s_ThreadBuffer();
+
+				buffer.events[buffer.written % EVENTS_PER_THREAD] = { name, startNs, durationNs };
+				++buffer.written;
+			}
+
+			/**
+			 * @brief Writes non-negative nanoseconds as the microseconds Chrome expects, keeping the fraction
+			 */
+			void s_WriteMicros(std::ostream& out, int64_t ns)
+			{
+				const int64_t us = ns / 1000;
+				const int64_t frac = ns % 1000;
+
+				out << us << '.' << static_cast<char>('0' + frac / 100) << static_cast<char>('0' + frac / 10 % 10) << static_cast<char>('0' + frac % 10);
+			}
+		}
+
+		void start()
+		{
+			s_origin = std::chrono::steady_clock::now();
+			g_enabled.store(true, std::memory_order_release);
+
+			nameThread("game");
+		}
+
+		void nameThread(const char* name)
+		{
+			if (g_enabled.load(std::memory_order_relaxed))
+			{
+				s_ThreadBuffer().name = name;
+			}
+		}
+
+		void instant(const char* name)
+		{
+			if (g_enabled.load(std::memory_order_relaxed))
+			{
+				s_Record(name, s_Since(std::chrono::steady_clock::now()), -1);
+			}
+		}
+
+		void complete(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+		{
+			if (g_enabled.load(std::memory_order_relaxed))
+			{
+				s_Record(name, s_Since(start), std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+			}
+		}
+
+		bool write(std::filesystem::path const& path)
+		{
+			g_enabled.store(false, std::memory_order_release);
+
+			std::ofstream out(path, std::ios::binary | std::ios::trunc);
+
+			if (!out)
+			{
+				return false;
+			}
+
+			std::lock_guard<std::mutex> lock(s_registryMutex);
+
+			out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+			out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"snake\"}}";
+
+			for (const auto& buffer : s_buffers)
+			{
+				if (buffer->name)
+				{
+					out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+						<< ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+				}
+
+				// Oldest first: a full ring starts at the slot written next
+				const uint64_t count = std::min<uint64_t>(buffer->written, EVENTS_PER_THREAD);
+				const uint64_t first = buffer->written - count;
+
+				for (uint64_t i = first; i < buffer->written; ++i)
+				{
+					const Event& event = buffer->events[i % EVENTS_PER_THREAD];
+
+					out << ",\n{\"name\":\"" << event.name << "\",\"pid\":1,\"tid\":" << buffer->tid << ",\"ts\":";
+					s_WriteMicros(out, event.startNs);
+
+					if (event.durationNs < 0)
+					{
+						out << ",\"ph\":\"i\",\"s\":\"t\"}";
+					}
+					else
+					{
+						out << ",\"ph\":\"X\",\"dur\":";
+						s_WriteMicros(out, event.durationNs);
+						out << '}';
+					}
+				}
+			}
+
+			out << "\n]}\n";
+
+			return static_cast<bool>(out.flush());
+		}
+	};
+};
@@ -0,0 +1,281 @@
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#include "include/log.h"
+#include "include/trace.h"
+#include "include/ttywriter.h"
+
+namespace Snake
+{
+#if defined(_WIN32)
+	TtyWriter::TtyWriter() = default;
+	TtyWriter::~TtyWriter() = default;
+
+	void TtyWriter::write(std::string_view bytes)
+	{
+		std::cout.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+		std::cout.flush();
+
+		if (std::cout.fail())
+		{
+			std::cout.clear();
+			m_resync.store(true, std::memory_order_relaxed);
+		}
+	}
+
+	void TtyWriter::frame(std::string& frame)
+	{
+		write(frame);
+	}
+
+	bool TtyWriter::flush(std::chrono::milliseconds)
+	{
+		return true;
+	}
+
+	void TtyWriter::run() {}
+	void TtyWriter::wake() noexcept {}
+#else
+	TtyWriter::TtyWriter()
+	{
+		// A description of our own, so O_NONBLOCK does not leak into stdin, stdout or the shell sharing them
+		if (const char* tty = ::ttyname(STDOUT_FILENO))
+		{
+			m_fd = ::open(tty, O_WRONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+		}
+
+		if (m_fd < 0)
+		{
+			m_fd = ::fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 0);
+
+			// The duplicate shares stdout's description, so stdout turns non-blocking too until the destructor restores it
+			if (m_fd >= 0 && (m_stdoutFlags = ::fcntl(m_fd, F_GETFL)) >= 0)
+			{
+				::fcntl(m_fd, F_SETFL, m_stdoutFlags | O_NONBLOCK);
+			}
+		}
+
+		if (m_fd < 0 || ::pipe(m_wake) != 0)
+			throw std::runtime_error(std::string("Failed to set up terminal output: ") + std::strerror(errno));
+
+		for (int fd : m_wake)
+		{
+			::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+			::fcntl(fd, F_SETFD, FD_CLOEXEC);
+		}
+
+		m_thread = std::thread(&TtyWriter::run, this);
+	}
+
+	TtyWriter::~TtyWriter()
+	{
+		if (!flush(s_CloseTimeout))
+		{
+			SNAKE_LOG(warning) << "Terminal did not take the last output within " << s_CloseTimeout.count() << " ms";
+		}
+
+		if (const uint64_t dropped = framesDropped())
+		{
+			SNAKE_LOG(info) << "Terminal output fell behind: " << dropped << " frames dropped";
+		}
+
+		m_stop.store(true, std::memory_order_release);
+		wake();
+
+		if (m_thread.joinable())
+		{
+			m_thread.join();
+		}
+
+		if (m_stdoutFlags >= 0)
+		{
+			::fcntl(m_fd, F_SETFL, m_stdoutFlags);
+		}
+
+		::close(m_fd);
+		::close(m_wake[0]);
+		::close(m_wake[1]);
+	}
+
+	void TtyWriter::write(std::string_view bytes)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			// Keep the order of the calls: a waiting frame goes out first and can no longer be dropped
+			if (m_hasFrame)
+			{
+				m_control += m_frame;
+				m_frame.clear();
+				m_hasFrame = false;
+			}
+
+			m_control.append(bytes);
+		}
+
+		wake();
+	}
+
+	void TtyWriter::frame(std::string& frame)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (m_hasFrame)
+			{
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				m_resync.store(true, std::memory_order_relaxed);
+			}
+
+			m_frame.swap(frame);
+			m_hasFrame = true;
+		}
+
+		wake();
+	}
+
+	bool TtyWriter::flush(std::chrono::milliseconds timeout)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		return m_drained.wait_for(lock, timeout, [this] { return m_control.empty() && !m_hasFrame && !m_busy; });
+	}
+
+	void TtyWriter::wake() noexcept
+	{
+		// A full pipe already means the thread has a wakeup pending
+		const char byte = 0;
+		[[maybe_unused]] ssize_t written = ::write(m_wake[1], &byte, 1);
+	}
+
+	void TtyWriter::run()
+	{
+		Trace::nameThread("tty writer");
+
+		std::string out;
+		size_t sent = 0;
+		bool failed = false;
+
+		while (!m_stop.load(std::memory_order_acquire))
+		{
+			if (sent == out.size() && !failed)
+			{
+				out.clear();
+				sent = 0;
+
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				out.swap(m_control);
+
+				if (m_hasFrame)
+				{
+					if (out.empty())
+					{
+						out.swap(m_frame); // the frame's buffer comes back through `TtyWriter::frame`
+					}
+					else
+					{
+						out += m_frame;
+					}
+
+					m_hasFrame = false;
+				}
+
+				m_busy = !out.empty();
+
+				if (!m_busy)
+				{
+					m_drained.notify_all();
+				}
+			}
+
+			if (sent < out.size())
+			{
+				ssize_t n;
+
+				{
+					SNAKE_TRACE_SCOPE("write");
+					n = ::write(m_fd, out.data() + sent, out.size() - sent);
+				}
+
+				if (n >= 0)
+				{
+					sent += static_cast<size_t>(n);
+					continue;
+				}
+
+				if (errno == EINTR)
+				{
+					continue;
+				}
+
+				if (errno != EAGAIN && errno != EWOULDBLOCK)
+				{
+					// Retrying would fail the same way; drop everything queued and let the next frame repaint
+					SNAKE_LOG(warning) << "Terminal output failed: " << std::strerror(errno);
+
+					out.clear();
+					sent = 0;
+					failed = true;
+					m_resync.store(true, std::memory_order_relaxed);
+
+					{
+						std::lock_guard<std::mutex> lock(m_mutex);
+
+						m_control.clear();
+						m_hasFrame = false;
+						m_busy = false;
+					}
+
+					m_drained.notify_all();
+					continue;
+				}
+			}
+
+			// Behind or idle: sleep until the terminal drains or the game queues more
+			pollfd fds[2] = { { m_wake[0], POLLIN, 0 }, { m_fd, POLLOUT, 0 } };
+			const bool waitWritable = sent < out.size();
+			const auto waitStart = std::chrono::steady_clock::now();
+
+			if (::poll(fds, waitWritable ? 2 : 1, -1) < 0 && errno != EINTR)
+			{
+				SNAKE_LOG(error) << "Terminal output poll failed: " << std::strerror(errno);
+				return;
+			}
+
+			// Idle waits are not interesting; waits on a terminal that stopped reading are
+			if (waitWritable)
+			{
+				Trace::complete("wait writable", waitStart, std::chrono::steady_clock::now());
+			}
+
+			if (fds[0].revents & POLLIN)
+			{
+				char drain[64];
+				while (::read(m_wake[0], drain, sizeof(drain)) > 0)
+				{}
+
+				failed = false; // new output: try again
+			}
+		}
+	}
+#endif
+
+	bool TtyWriter::takeResync() noexcept
+	{
+		return m_resync.exchange(false, std::memory_order_relaxed);
+	}
+
+	uint64_t TtyWriter::framesDropped() const noexcept
+	{
+		return m_dropped.load(std::memory_order_relaxed);
+	}
+};
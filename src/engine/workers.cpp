@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "include/workers.h"
+
+namespace Snake
+{
+	namespace
+	{
+		thread_local unsigned int t_threadIndex = 0;
+
+		constexpr uint64_t s_PackRange(uint64_t begin, uint64_t end) noexcept
+		{
+			return begin | (end << 32);
+		}
+
+		constexpr uint64_t s_RangeBegin(uint64_t range) noexcept
+		{
+			return range & 0xFFFFFFFFull;
+		}
+
+		constexpr uint64_t s_RangeEnd(uint64_t range) noexcept
+		{
+			return range >> 32;
+		}
+	}
+
+	WorkerPool::WorkerPool(unsigned int threads)
+	{
+		if (threads == 0)
+		{
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		m_slots = std::make_unique<Slot[]>(threads);
+		m_threads.reserve(threads - 1);
+
+		for (unsigned int i = 1; i < threads; ++i)
+		{
+			m_threads.emplace_back(&WorkerPool::workerLoop, this, i);
+		}
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		m_stop.store(true, std::memory_order_release);
+		m_generation.fetch_add(1, std::memory_order_release);
+		m_generation.notify_all();
+
+		for (std::thread& thread : m_threads)
+		{
+			thread.join();
+		}
+	}
+
+	unsigned int WorkerPool::size() const noexcept
+	{
+		return static_cast<unsigned int>(m_threads.size()) + 1;
+	}
+
+	unsigned int WorkerPool::s_ThreadIndex() noexcept
+	{
+		return t_threadIndex;
+	}
+
+	void WorkerPool::run(Job const& job)
+	{
+		if (m_threads.empty() || job.count <= job.grain)
+		{
+			job.invoke(job.ctx, 0, job.count);
+
+			return;
+		}
+
+		if (job.count > UINT32_MAX)
+		{
+			throw std::length_error("WorkerPool::parallelFor: too many items");
+		}
+
+		// Equal shares of whole chunks, so only the last chunk of the job can be short
+		const size_t threads = size();
+		const size_t chunks = (job.count + job.grain - 1) / job.grain;
+
+		for (size_t i = 0; i < threads; ++i)
+		{
+			const size_t begin = std::min(job.count, chunks * i / threads * job.grain);
+			const size_t end = std::min(job.count, chunks * (i + 1) / threads * job.grain);
+
+			m_slots[i].range.store(s_PackRange(begin, end), std::memory_order_relaxed);
+		}
+
+		m_job = job;
+		m_active.store(static_cast<unsigned int>(m_threads.size()), std::memory_order_relaxed);
+
+		m_generation.fetch_add(1, std::memory_order_release);
+		m_generation.notify_all();
+
+		work(job, 0);
+
+		// Workers only touch m_job until they decrement m_active, so the next job can safely reuse it
+		for (unsigned int active = m_active.load(std::memory_order_acquire); active != 0; active = m_active.load(std::memory_order_acquire))
+		{
+			m_active.wait(active, std::memory_order_acquire);
+		}
+	}
+
+	void WorkerPool::work(Job const& job, unsigned int self)
+	{
+		std::atomic<uint64_t>& own = m_slots[self].range;
+
+		do
+		{
+			uint64_t range = own.load(std::memory_order_acquire);
+
+			while (s_RangeBegin(range) < s_RangeEnd(range))
+			{
+				const uint64_t begin = s_RangeBegin(range);
+				const uint64_t end = std::min<uint64_t>(begin + job.grain, s_RangeEnd(range));
+
+				if (own.compare_exchange_weak(range, s_PackRange(end, s_RangeEnd(range)), std::memory_order_acq_rel))
+				{
+					job.invoke(job.ctx, begin, end);
+					range = own.load(std::memory_order_acquire);
+				}
+			}
+		} while (steal(self, job.grain));
+	}
+
+	bool WorkerPool::steal(unsigned int self, size_t grain)
+	{
+		const unsigned int threads = size();
+
+		for (;;)
+		{
+			unsigned int victim = self;
+			uint64_t victimRange = 0;
+			uint64_t most = 0;
+
+			for (unsigned int i = 1; i < threads; ++i)
+			{
+				const unsigned int candidate = (self + i) % threads;
+				const uint64_t range = m_slots[candidate].range.load(std::memory_order_acquire);
+				const uint64_t left = s_RangeEnd(range) > s_RangeBegin(range) ? s_RangeEnd(range) - s_RangeBegin(range) : 0;
+
+				if (left > most)
+				{
+					victim = candidate;
+					victimRange = range;
+					most = left;
+				}
+			}
+
+			if (most == 0)
+			{
+				return false;
+			}
+
+			// The victim keeps the front half (rounded up to whole chunks), the thief takes the rest
+			const uint64_t begin = s_RangeBegin(victimRange);
+			const uint64_t end = s_RangeEnd(victimRange);
+			const uint64_t chunks = (most + grain - 1) / grain;
+			const uint64_t split = chunks == 1 ? begin : begin + (chunks + 1) / 2 * grain;
+
+			if (m_slots[victim].range.compare_exchange_strong(victimRange, s_PackRange(begin, split), std::memory_order_acq_rel))
+			{
+				// Only this thread refills its own slot, and only once it is empty
+				m_slots[self].range.store(s_PackRange(split, end), std::memory_order_release);
+
+				return true;
+			}
+		}
+	}
+
+	void WorkerPool::workerLoop(unsigned int index)
+	{
+		uint32_t seen = 0;
+
+		t_threadIndex = index;
+
+		for (;;)
+		{
+			m_generation.wait(seen, std::memory_order_acquire);
+			seen = m_generation.load(std::memory_order_acquire);
+
+			if (m_stop.load(std::memory_order_acquire))
+			{
+				return;
+			}
+
+			work(m_job, index);
+
+			if (m_active.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				m_active.notify_one();
+			}
+		}
+	}
+};
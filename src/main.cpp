@@ -1,10 +1,86 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "engine/include/batch.h"
+#include "engine/include/flightrecorder.h"
 #include "engine/include/game.h"
+#include "engine/include/level.h"
+#include "engine/include/mcts.h"
+#include "engine/include/options.h"
+#include "engine/include/recording.h"
+#include "engine/include/spectator.h"
+#include "engine/include/trace.h"
 
-int main ()
+int main (int argc, char* argv[])
 {
-	Snake::Game g = Snake::Game();
+	Snake::Options options;
+
+	try
+	{
+		options = Snake::Options::parse(argc, argv);
+	}
+	catch (const std::invalid_argument& e)
+	{
+		std::cerr << e.what() << "\n" << Snake::Options::usage();
+
+		return 2;
+	}
+
+	if (options.batchGames > 0)
+	{
+		return Snake::runBatch(options);
+	}
+
+	if (!options.compileLevelPath.empty())
+	{
+		return Snake::runCompileLevel(options);
+	}
+
+	if (!options.decodeFlightPath.empty())
+	{
+		return Snake::runDecodeFlight(options);
+	}
+
+	if (options.mctsBench)
+	{
+		return Snake::runMctsBench(options);
+	}
+
+	if (!options.spectatePath.empty())
+	{
+		return Snake::runSpectator(options);
+	}
+
+	if (!options.playPath.empty())
+	{
+		return Snake::playRecording(options);
+	}
+
+	std::string exitReport;
+	bool replayDiverged = false;
+
+	if (!options.tracePath.empty())
+	{
+		Snake::Trace::start(); // before the game starts its threads, so they record too
+	}
+
+	{
+		Snake::Game g = Snake::Game(options);
+
+		g.run();
+
+		exitReport = g.exitReport();
+		replayDiverged = g.replayDiverged();
+	} // terminal is restored here
+
+	std::cerr << exitReport;
 
-	g.run();
+	// Every traced thread has been joined with the game
+	if (!options.tracePath.empty() && !Snake::Trace::write(options.tracePath))
+	{
+		std::cerr << "Failed to write trace to " << options.tracePath << "\n";
+	}
 
-	return 0;
+	return replayDiverged ? 1 : 0;
 }